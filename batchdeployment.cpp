@@ -0,0 +1,183 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "batchdeployment.h"
+#include "commandlineparser.h"
+#include "deployment.h"
+#include "deploymentcache.h"
+#include "jsonoutput.h"
+#include "utils.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QJsonParseError>
+#include <QtCore/QRunnable>
+#include <QtCore/QSet>
+#include <QtCore/QThreadPool>
+
+QT_BEGIN_NAMESPACE
+
+static QStringList jsonStringList(const QJsonValue &value)
+{
+    QStringList result;
+    if (value.isString()) {
+        result.append(value.toString());
+    } else {
+        foreach (const QJsonValue &v, value.toArray())
+            result.append(v.toString());
+    }
+    return result;
+}
+
+bool readBatchManifest(const QString &fileName, Platform platform, int verboseLevel,
+                       QList<BatchEntry> *entries, QString *errorMessage)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *errorMessage = QString::fromLatin1("Unable to open %1: %2")
+                        .arg(QDir::toNativeSeparators(fileName), file.errorString());
+        return false;
+    }
+    QJsonParseError jsonParseError;
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &jsonParseError);
+    if (document.isNull()) {
+        *errorMessage = QString::fromLatin1("Invalid batch manifest %1: %2")
+                        .arg(QDir::toNativeSeparators(fileName), jsonParseError.errorString());
+        return false;
+    }
+
+    const QDir manifestDir = QFileInfo(fileName).absoluteDir();
+    const QJsonArray array = document.object().value(QStringLiteral("entries")).toArray();
+    if (array.isEmpty()) {
+        *errorMessage = QString::fromLatin1("The batch manifest %1 does not contain any entries.")
+                        .arg(QDir::toNativeSeparators(fileName));
+        return false;
+    }
+
+    QSet<QString> targetDirectories;
+    for (int e = 0; e < array.size(); ++e) {
+        const QJsonObject object = array.at(e).toObject();
+        QStringList arguments(QCoreApplication::applicationFilePath());
+        arguments.append(jsonStringList(object.value(QStringLiteral("options"))));
+        const QString directory = object.value(QStringLiteral("dir")).toString();
+        if (!directory.isEmpty()) {
+            arguments.append(QStringLiteral("--dir"));
+            arguments.append(manifestDir.absoluteFilePath(directory));
+        }
+        foreach (const QString &binary, jsonStringList(object.value(QStringLiteral("binaries"))))
+            arguments.append(manifestDir.absoluteFilePath(binary));
+
+        BatchEntry entry;
+        entry.name = object.value(QStringLiteral("name")).toString();
+        entry.options.platform = platform;
+        if (platform == WindowsMinGW || platform == Windows)
+            entry.options.compilerRunTime = true;
+        CommandLineParser parser;
+        const int parseResult = parser.parseArguments(arguments, &entry.options, errorMessage);
+        // "--json", "--verbose" of entries are overridden by the batch level setting.
+        entry.options.verboseLevel = verboseLevel;
+        if (parseResult || !entry.options.batchManifest.isEmpty()) {
+            if (!parseResult)
+                *errorMessage = QStringLiteral("Batch manifests cannot be nested.");
+            errorMessage->prepend(QString::fromLatin1("Entry %1 of %2: ")
+                                  .arg(e + 1).arg(QDir::toNativeSeparators(fileName)));
+            return false;
+        }
+        if (entry.name.isEmpty())
+            entry.name = QFileInfo(entry.options.binaries.first()).fileName();
+
+        // Entries run concurrently and must not update the same files.
+        const QString targetDirectory = QDir::cleanPath(QFileInfo(entry.options.directory).absoluteFilePath());
+        if (targetDirectories.contains(targetDirectory)) {
+            *errorMessage = QString::fromLatin1("Entry %1 of %2: The target directory %3 is used by several entries.")
+                            .arg(e + 1).arg(QDir::toNativeSeparators(fileName), QDir::toNativeSeparators(targetDirectory));
+            return false;
+        }
+        targetDirectories.insert(targetDirectory);
+        entries->append(entry);
+    }
+    return true;
+}
+
+class BatchDeploymentTask : public QRunnable
+{
+public:
+    BatchDeploymentTask(BatchEntry *entry, const QMap<QString, QString> &qmakeVariables, DeploymentCache *cache)
+        : m_entry(entry), m_qmakeVariables(qmakeVariables), m_cache(cache), m_logContext(currentLogContext()) {}
+
+    void run() Q_DECL_OVERRIDE
+    {
+        const LogScope logScope(m_logContext);
+        Options &options = m_entry->options;
+        m_entry->success = deployApplication(options, m_qmakeVariables, m_cache, &m_entry->errorMessage);
+        if (options.json) {
+            if (m_entry->success) {
+                m_entry->output = options.list
+                        ? options.json->toList(options.list, options.directory)
+                        : options.json->toJson();
+            }
+            delete options.json;
+            options.json = 0;
+        }
+    }
+
+private:
+    BatchEntry *m_entry;
+    const QMap<QString, QString> &m_qmakeVariables;
+    DeploymentCache *m_cache;
+    const LogContext m_logContext;
+};
+
+bool runBatchDeployment(QList<BatchEntry> *entries, const QMap<QString, QString> &qmakeVariables,
+                        DeploymentCache *cache, int jobs)
+{
+    QThreadPool pool;
+    if (jobs > 0)
+        pool.setMaxThreadCount(jobs);
+    for (int e = 0; e < entries->size(); ++e)
+        pool.start(new BatchDeploymentTask(&(*entries)[e], qmakeVariables, cache));
+    pool.waitForDone();
+    flushLog();
+
+    bool success = true;
+    foreach (const BatchEntry &entry, *entries) {
+        if (entry.success) {
+            std::fputs(entry.output.constData(), stdout);
+        } else {
+            errorStream() << entry.name << ": " << entry.errorMessage << '\n';
+            success = false;
+        }
+    }
+    return success;
+}
+
+QT_END_NAMESPACE
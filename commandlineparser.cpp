@@ -75,6 +75,26 @@ static QString findBinary(const QString &directory, Platform platform)
 
 //-----------------------------------------------------------------------------
 
+QString preParsedArgument(const QStringList &arguments, const QString &name)
+{
+    for (int i = 1; i < arguments.size(); ++i) {
+        const QString &argument = arguments.at(i);
+        if (argument == QLatin1String("--"))
+            break;
+        // Single dash words are long options (ParseAsLongOptions).
+        const int nameStart = argument.startsWith(QLatin1String("--")) ? 2
+            : (argument.startsWith(QLatin1Char('-')) ? 1 : 0);
+        if (!nameStart || argument.midRef(nameStart, name.size()) != name)
+            continue;
+        const int nameEnd = nameStart + name.size();
+        if (argument.size() == nameEnd)
+            return i + 1 < arguments.size() ? arguments.at(i + 1) : QString();
+        if (argument.at(nameEnd) == QLatin1Char('='))
+            return argument.mid(nameEnd + 1);
+    }
+    return QString();
+}
+
 CommandLineParser::CommandLineParser(): m_parser(), m_optWebKit2(OptionAuto)
 {
     m_parser.setSingleDashWordOptionMode(QCommandLineParser::ParseAsLongOptions);
@@ -110,7 +130,7 @@ CommandLineParser::ExlusiveOptionValue CommandLineParser::parseExclusiveOptions(
     const bool disabled = m_parser.isSet(disableOption);
     if (enabled) {
         if (disabled) {
-            std::wcerr << "Warning: both -" << enableOption.names().first()
+            errorStream() << "Warning: both -" << enableOption.names().first()
                        << " and -" << disableOption.names().first() << " were specified, defaulting to -"
                        << enableOption.names().first() << ".\n";
         }
@@ -169,6 +189,28 @@ int CommandLineParser::parseArguments(const QStringList &arguments, Options *opt
                                     QStringLiteral("directory"));
     m_parser.addOption(qmlDirOption);
 
+    QCommandLineOption qmlScannerOption(QStringLiteral("qml-scanner"),
+                                        QLatin1String("Scanner for QML imports.\n"
+                                                      "Available options:\n"
+                                                      "  external: run qmlimportscanner (default)\n"
+                                                      "  builtin:  lex the files in-process"),
+                                        QStringLiteral("scanner"));
+    m_parser.addOption(qmlScannerOption);
+
+    QCommandLineOption noQmlScanCacheOption(QStringLiteral("no-qml-scan-cache"),
+                                            QStringLiteral("Always scan for QML imports, do not use cached results."));
+    m_parser.addOption(noQmlScanCacheOption);
+
+    QCommandLineOption pruneQmlOption(QStringLiteral("prune-qml"),
+                                      QLatin1String("Deploy only the QML, JavaScript and image files of the\n"
+                                                    "QML imports reachable from the application's QML files."));
+    m_parser.addOption(pruneQmlOption);
+
+    QCommandLineOption qmlCacheOption(QStringLiteral("qml-cache"),
+                                      QLatin1String("Generate cache files (.qmlc, .jsc) for the deployed QML\n"
+                                                    "imports using qmlcachegen if available."));
+    m_parser.addOption(qmlCacheOption);
+
     QCommandLineOption noQuickImportOption(QStringLiteral("no-quick-import"),
                                            QStringLiteral("Skip deployment of Qt Quick imports."));
     m_parser.addOption(noQuickImportOption);
@@ -177,6 +219,11 @@ int CommandLineParser::parseArguments(const QStringList &arguments, Options *opt
                                            QStringLiteral("Skip deployment of translations."));
     m_parser.addOption(noTranslationOption);
 
+    QCommandLineOption translationsOption(QStringLiteral("translations"),
+                                          QStringLiteral("A comma-separated list of languages to deploy (de,fi)."),
+                                          QStringLiteral("languages"));
+    m_parser.addOption(translationsOption);
+
     QCommandLineOption noSystemD3DCompilerOption(QStringLiteral("no-system-d3d-compiler"),
                                                  QStringLiteral("Skip deployment of the system D3D compiler."));
     m_parser.addOption(noSystemD3DCompilerOption);
@@ -223,6 +270,93 @@ int CommandLineParser::parseArguments(const QStringList &arguments, Options *opt
                                   QStringLiteral("option"));
     m_parser.addOption(listOption);
 
+    QCommandLineOption batchOption(QStringLiteral("batch"),
+                                   QLatin1String("Deploy the applications listed in a JSON manifest file\n"
+                                                 "in one run, sharing the analysis of the Qt\n"
+                                                 "installation. Each entry of the \"entries\" array\n"
+                                                 "may specify \"binaries\", \"dir\" and \"options\"."),
+                                   QStringLiteral("manifest"));
+    m_parser.addOption(batchOption);
+
+    QCommandLineOption jobsOption(QStringLiteral("jobs"),
+                                  QStringLiteral("Maximum number of parallel jobs (default: number of processors)."),
+                                  QStringLiteral("count"));
+    m_parser.addOption(jobsOption);
+
+    QCommandLineOption sharedRuntimeOption(QStringLiteral("shared-runtime"),
+                                           QLatin1String("Deploy the Qt libraries and plugins once into directory\n"
+                                                         "and link them into the application directory."),
+                                           QStringLiteral("directory"));
+    m_parser.addOption(sharedRuntimeOption);
+
+    QCommandLineOption sharedRuntimeModeOption(QStringLiteral("shared-runtime-mode"),
+                                               QLatin1String("How the shared runtime is referenced.\n"
+                                                             "Available options:\n"
+                                                             "  link:   hard link libraries and plugins (default)\n"
+                                                             "  qtconf: hard link libraries, reference the\n"
+                                                             "          plugins by qt.conf"),
+                                               QStringLiteral("mode"));
+    m_parser.addOption(sharedRuntimeModeOption);
+
+    QCommandLineOption storeOption(QStringLiteral("store"),
+                                   QLatin1String("Keep the deployed files in a content-addressed store\n"
+                                                 "and place them by reflink or hard link."),
+                                   QStringLiteral("directory"));
+    m_parser.addOption(storeOption);
+
+    QCommandLineOption storeGcOption(QStringLiteral("store-gc"),
+                                     QStringLiteral("Remove unreferenced files from the store and exit."));
+    m_parser.addOption(storeGcOption);
+
+    QCommandLineOption indexQtOption(QStringLiteral("index-qt"),
+                                     QStringLiteral("Create or refresh the index of the Qt installation and exit."));
+    m_parser.addOption(indexQtOption);
+
+    QCommandLineOption qtIndexOption(QStringLiteral("qt-index"),
+                                     QLatin1String("Use the index of the Qt installation in file\n"
+                                                   "(default: per installation in the cache location)."),
+                                     QStringLiteral("file"));
+    m_parser.addOption(qtIndexOption);
+
+    // Evaluated by main() before parsing, see queryQMakeAllCached().
+    QCommandLineOption qmakeQueryOption(QStringLiteral("qmake-query"),
+                                        QLatin1String("Read the qmake variables from file containing the\n"
+                                                      "output of \"qmake -query\" instead of running qmake\n"
+                                                      "(default: $WINDEPLOYQT_QMAKE_QUERY)."),
+                                        QStringLiteral("file"));
+    m_parser.addOption(qmakeQueryOption);
+
+    // Evaluated by main() before parsing, see qmakeVariablesFromPrefix().
+    QCommandLineOption qtPrefixOption(QStringLiteral("qt-prefix"),
+                                      QLatin1String("Determine the layout of the Qt installation in directory\n"
+                                                    "from its qt.conf and mkspecs instead of running qmake."),
+                                      QStringLiteral("directory"));
+    m_parser.addOption(qtPrefixOption);
+
+    QCommandLineOption timingsOption(QStringLiteral("timings"),
+                                     QLatin1String("Report wall time, CPU time and counters per deployment\n"
+                                                   "phase (in the JSON output with -json)."));
+    m_parser.addOption(timingsOption);
+
+    QCommandLineOption ioStatsOption(QStringLiteral("io-stats"),
+                                     QLatin1String("Report the file system calls and bytes per deployment\n"
+                                                   "phase and storage: Qt installation, application and\n"
+                                                   "target directories (in the JSON output with -json)."));
+    m_parser.addOption(ioStatsOption);
+
+    QCommandLineOption memStatsOption(QStringLiteral("memstats"),
+                                      QLatin1String("Report the peak resident set size and, in builds\n"
+                                                    "configured with CONFIG+=memstats, the allocations\n"
+                                                    "per deployment phase (in the JSON output with -json)."));
+    m_parser.addOption(memStatsOption);
+
+    // Evaluated by main() before parsing to include the qmake query.
+    QCommandLineOption traceOption(QStringLiteral("trace"),
+                                   QLatin1String("Write Chrome trace events of the run to file, for\n"
+                                                 "chrome://tracing or Perfetto."),
+                                   QStringLiteral("file"));
+    m_parser.addOption(traceOption);
+
     QCommandLineOption verboseOption(QStringLiteral("verbose"),
                                      QStringLiteral("Verbose level."),
                                      QStringLiteral("level"));
@@ -260,6 +394,17 @@ int CommandLineParser::parseArguments(const QStringList &arguments, Options *opt
     options->plugins = !m_parser.isSet(noPluginsOption);
     options->libraries = !m_parser.isSet(noLibraryOption);
     options->translations = !m_parser.isSet(noTranslationOption);
+    if (m_parser.isSet(translationsOption)) {
+        foreach (const QString &language, m_parser.value(translationsOption).split(QLatin1Char(','), QString::SkipEmptyParts)) {
+            const QString trimmed = language.trimmed();
+            if (!trimmed.isEmpty() && !options->languages.contains(trimmed))
+                options->languages.append(trimmed);
+        }
+        if (options->languages.isEmpty()) {
+            *errorMessage = QStringLiteral("Please specify a list of languages for --translations.");
+            return CommandLineParseError;
+        }
+    }
     options->systemD3dCompiler = !m_parser.isSet(noSystemD3DCompilerOption);
     options->quickImports = !m_parser.isSet(noQuickImportOption);
 
@@ -301,6 +446,16 @@ int CommandLineParser::parseArguments(const QStringList &arguments, Options *opt
     }
 
     m_optWebKit2 = parseExclusiveOptions(webKitOption, noWebKitOption);
+    switch (m_optWebKit2) {
+    case OptionAuto:
+        break;
+    case OptionEnabled:
+        options->webKit2 = Options::WebKit2DeploymentForceOn;
+        break;
+    case OptionDisabled:
+        options->webKit2 = Options::WebKit2DeploymentForceOff;
+        break;
+    }
 
     if (m_parser.isSet(forceOption))
         options->updateFileFlags |= ForceUpdateFile;
@@ -338,22 +493,83 @@ int CommandLineParser::parseArguments(const QStringList &arguments, Options *opt
         }
     }
 
+    if (m_parser.isSet(sharedRuntimeOption))
+        options->sharedRuntimeDirectory = QDir::cleanPath(QFileInfo(m_parser.value(sharedRuntimeOption)).absoluteFilePath());
+    if (m_parser.isSet(sharedRuntimeModeOption)) {
+        const QString value = m_parser.value(sharedRuntimeModeOption);
+        if (value == QStringLiteral("link")) {
+            options->sharedRuntimeMode = Options::SharedRuntimeHardLinks;
+        } else if (value == QStringLiteral("qtconf")) {
+            options->sharedRuntimeMode = Options::SharedRuntimeQtConf;
+        } else {
+            *errorMessage = QStringLiteral("Please specify a valid option for -shared-runtime-mode (link, qtconf).");
+            return CommandLineParseError;
+        }
+    }
+
     if (m_parser.isSet(jsonOption) || options->list) {
-        optVerboseLevel = 0;
+        options->verboseLevel = 0;
         options->json = new JsonOutput;
     } else {
         if (m_parser.isSet(verboseOption)) {
             bool ok;
             const QString value = m_parser.value(verboseOption);
-            optVerboseLevel = value.toInt(&ok);
-            if (!ok || optVerboseLevel < 0) {
+            options->verboseLevel = value.toInt(&ok);
+            if (!ok || options->verboseLevel < 0) {
                 *errorMessage = QStringLiteral("Invalid value \"%1\" passed for verbose level.").arg(value);
                 return CommandLineParseError;
             }
         }
     }
 
+    if (m_parser.isSet(jobsOption)) {
+        bool ok;
+        const QString value = m_parser.value(jobsOption);
+        options->jobs = value.toInt(&ok);
+        if (!ok || options->jobs <= 0) {
+            *errorMessage = QStringLiteral("Invalid value \"%1\" passed for the number of jobs.").arg(value);
+            return CommandLineParseError;
+        }
+    }
+
+    options->timings = m_parser.isSet(timingsOption);
+    options->ioStats = m_parser.isSet(ioStatsOption);
+    options->memoryStats = m_parser.isSet(memStatsOption);
+    if (m_parser.isSet(traceOption))
+        options->traceFile = m_parser.value(traceOption);
+
+    if (m_parser.isSet(storeOption))
+        options->storeDirectory = m_parser.value(storeOption);
+    if (m_parser.isSet(storeGcOption)) {
+        if (options->storeDirectory.isEmpty()) {
+            *errorMessage = QStringLiteral("Please specify the store directory for -store-gc.");
+            return CommandLineParseError;
+        }
+        options->storeGarbageCollection = true;
+        return 0;
+    }
+
+    if (m_parser.isSet(qtIndexOption))
+        options->qtIndexFile = QDir::cleanPath(QFileInfo(m_parser.value(qtIndexOption)).absoluteFilePath());
+    if (m_parser.isSet(indexQtOption)) {
+        options->createQtIndex = true;
+        return 0;
+    }
+
     const QStringList posArgs = m_parser.positionalArguments();
+    if (m_parser.isSet(batchOption)) {
+        options->batchManifest = m_parser.value(batchOption);
+        if (!QFileInfo(options->batchManifest).isFile()) {
+            *errorMessage = msgFileDoesNotExist(options->batchManifest);
+            return CommandLineParseError;
+        }
+        if (!posArgs.isEmpty()) {
+            *errorMessage = QStringLiteral("Binaries cannot be specified together with -batch.");
+            return CommandLineParseError;
+        }
+        return 0;
+    }
+
     if (posArgs.isEmpty()) {
         *errorMessage = QStringLiteral("Please specify the binary or folder.");
         return CommandLineParseError | CommandLineParseHelpRequested;
@@ -365,6 +581,22 @@ int CommandLineParser::parseArguments(const QStringList &arguments, Options *opt
     if (m_parser.isSet(qmlDirOption))
         options->qmlDirectories = m_parser.values(qmlDirOption);
 
+    options->qmlScanCache = !m_parser.isSet(noQmlScanCacheOption);
+    options->pruneQml = m_parser.isSet(pruneQmlOption);
+    options->qmlCache = m_parser.isSet(qmlCacheOption);
+
+    if (m_parser.isSet(qmlScannerOption)) {
+        const QString value = m_parser.value(qmlScannerOption);
+        if (value == QStringLiteral("external")) {
+            options->qmlImportScanner = Options::QmlImportScannerExternal;
+        } else if (value == QStringLiteral("builtin")) {
+            options->qmlImportScanner = Options::QmlImportScannerBuiltin;
+        } else {
+            *errorMessage = QStringLiteral("Please specify a valid option for -qml-scanner (external, builtin).");
+            return CommandLineParseError;
+        }
+    }
+
     const QString &file = posArgs.front();
     const QFileInfo fi(QDir::cleanPath(file));
     if (!fi.exists()) {
@@ -72,6 +72,11 @@ private:
     ExlusiveOptionValue m_optWebKit2;
 };
 
+// The qmake variables determine the platform, which is required for parsing
+// the command line. Extracts the value of "-name <value>" or "-name=<value>"
+// (also with "--") in advance for "qmake-query", "qt-prefix" and "trace".
+QString preParsedArgument(const QStringList &arguments, const QString &name);
+
 QT_END_NAMESPACE
 
 #endif // COMMANDLINEPARSER_H
@@ -0,0 +1,73 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef DEPLOYER_H
+#define DEPLOYER_H
+
+#include "deployment.h"
+#include "logging.h"
+
+QT_BEGIN_NAMESPACE
+
+class DeploymentCache;
+
+// Entry point for deploying applications from a host process (libwindeployqt).
+// All settings are passed per deployment in Options, the messages and the
+// progress are passed to the observer instead of std::wcout/std::wcerr, and
+// the deployed files are returned in DeployResult::files. deploy() may be
+// called concurrently from several threads, on one or several instances.
+class Deployer
+{
+public:
+    // qmakeVariables as returned by queryQMakeAllCached() or qmakeVariablesFromPrefix().
+    explicit Deployer(const QMap<QString, QString> &qmakeVariables, DeploymentCache *cache = 0);
+    ~Deployer();
+
+    // Receives the records and the progress on the log writer thread.
+    LogSink *observer() const { return m_observer; }
+    void setObserver(LogSink *observer) { m_observer = observer; }
+
+    DeployResult deploy(const Options &options, QString *errorMessage) const;
+
+private:
+    Q_DISABLE_COPY(Deployer)
+
+    const QMap<QString, QString> m_qmakeVariables;
+    QScopedPointer<DeploymentCache> m_ownCache;
+    DeploymentCache *m_cache;
+    LogSink *m_observer;
+};
+
+QT_END_NAMESPACE
+
+#endif // DEPLOYER_H
@@ -32,10 +32,28 @@
 ****************************************************************************/
 
 #include "deployment.h"
+#include "deploymentcache.h"
+#include "deploymentstore.h"
+#include "qtindex.h"
 #include "jsonoutput.h"
 #include "utils.h"
 #include "qtmodules.h"
 #include "qmlutils.h"
+#include "directorywalker.h"
+#include "qmlreachability.h"
+#include "qmlcachegen.h"
+#include "qmcatalog.h"
+#include "statistics.h"
+#include "tracing.h"
+#include "iostats.h"
+
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QRunnable>
+#include <QtCore/QSaveFile>
+#include <QtCore/QStandardPaths>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
 
 QT_BEGIN_NAMESPACE
 
@@ -44,6 +62,7 @@ class NameFilterFileEntryFunction {
 public:
     explicit NameFilterFileEntryFunction(const QStringList &nameFilters);
     QStringList operator()(const QDir &dir) const;
+    QStringList operator()(const QDir &dir, const QStringList &fileNames) const;
 
 private:
     const QStringList m_nameFilters;
@@ -58,6 +77,7 @@ public:
     explicit DllDirectoryFileEntryFunction(Platform platform, DebugMatchMode debugMatchMode, const QString &prefix = QString());
 
     QStringList operator()(const QDir &dir) const;
+    QStringList operator()(const QDir &dir, const QStringList &fileNames) const;
 
 private:
     const Platform m_platform;
@@ -69,15 +89,23 @@ private:
 // QML import trees: DLLs (matching debgug) and .qml/,js, etc.
 class QmlDirectoryFileEntryFunction {
 public:
-    explicit QmlDirectoryFileEntryFunction(Platform platform, DebugMatchMode debugMatchMode, bool skipQmlSources = false);
+    explicit QmlDirectoryFileEntryFunction(Platform platform, DebugMatchMode debugMatchMode, bool skipQmlSources = false,
+                                           const QSet<QString> *reachableFiles = 0);
 
     QStringList operator()(const QDir &dir) const;
+    // Filter the file names of a directory read by the directory walker.
+    QStringList operator()(const QDir &dir, const QStringList &fileNames) const;
 
 private:
     static inline QStringList qmlNameFilters(bool skipQmlSources);
+    QStringList filterPlugins(const QDir &dir, const QStringList &plugins) const;
+    QStringList filterReachable(const QDir &dir, const QStringList &fileNames) const;
 
     NameFilterFileEntryFunction m_qmlNameFilter;
     DllDirectoryFileEntryFunction m_dllFilter;
+    Platform m_platform;
+    DebugMatchMode m_debugMatchMode;
+    const QSet<QString> *m_reachableFiles; // --prune-qml
 };
 
 //-----------------------------------------------------------------------------
@@ -91,14 +119,66 @@ QStringList DllDirectoryFileEntryFunction::operator()(const QDir &dir) const
     return findSharedLibraries(dir, m_platform, m_debugMatchMode, m_prefix);
 }
 
-QmlDirectoryFileEntryFunction::QmlDirectoryFileEntryFunction(Platform platform, DebugMatchMode debugMatchMode, bool skipQmlSources)
+QStringList DllDirectoryFileEntryFunction::operator()(const QDir &dir, const QStringList &fileNames) const
+{
+    return filterSharedLibraries(dir, fileNames, m_platform, m_debugMatchMode, m_prefix);
+}
+
+QmlDirectoryFileEntryFunction::QmlDirectoryFileEntryFunction(Platform platform, DebugMatchMode debugMatchMode, bool skipQmlSources,
+                                                             const QSet<QString> *reachableFiles)
     : m_qmlNameFilter(QmlDirectoryFileEntryFunction::qmlNameFilters(skipQmlSources))
     , m_dllFilter(platform, debugMatchMode)
+    , m_platform(platform)
+    , m_debugMatchMode(debugMatchMode)
+    , m_reachableFiles(reachableFiles)
 {}
 
+// Libraries are restricted to the plugins declared by the qmldir file if
+// the directory has one.
 QStringList QmlDirectoryFileEntryFunction::operator()(const QDir &dir) const
 {
-    return m_dllFilter(dir) + m_qmlNameFilter(dir);
+    bool hasQmlDir;
+    const QStringList plugins = findQmlPluginLibraries(dir.path(), m_platform, m_debugMatchMode, &hasQmlDir);
+    if (!hasQmlDir)
+        return m_dllFilter(dir) + filterReachable(dir, m_qmlNameFilter(dir));
+    return filterPlugins(dir, plugins) + filterReachable(dir, m_qmlNameFilter(dir));
+}
+
+QStringList QmlDirectoryFileEntryFunction::operator()(const QDir &dir, const QStringList &fileNames) const
+{
+    if (!fileNames.contains(QStringLiteral("qmldir")))
+        return m_dllFilter(dir, fileNames) + filterReachable(dir, m_qmlNameFilter(dir, fileNames));
+    bool hasQmlDir;
+    const QStringList plugins = findQmlPluginLibraries(dir.path(), m_platform, m_debugMatchMode, &hasQmlDir);
+    return filterPlugins(dir, plugins) + filterReachable(dir, m_qmlNameFilter(dir, fileNames));
+}
+
+// Drop QML sources and assets not reachable from the application (qmldir and
+// type information are always kept).
+QStringList QmlDirectoryFileEntryFunction::filterReachable(const QDir &dir, const QStringList &fileNames) const
+{
+    if (!m_reachableFiles)
+        return fileNames;
+    QStringList result;
+    foreach (const QString &fileName, fileNames) {
+        if (fileName == QLatin1String("qmldir") || fileName.endsWith(QLatin1String(".qmltypes"))
+            || m_reachableFiles->contains(QDir::cleanPath(dir.absoluteFilePath(fileName)))) {
+            result.append(fileName);
+        }
+    }
+    return result;
+}
+
+// Return the file names of the plugins located in dir.
+QStringList QmlDirectoryFileEntryFunction::filterPlugins(const QDir &dir, const QStringList &plugins) const
+{
+    QStringList result;
+    foreach (const QString &plugin, plugins) {
+        const QFileInfo pluginFileInfo(plugin);
+        if (pluginFileInfo.absolutePath() == dir.absolutePath())
+            result.append(pluginFileInfo.fileName());
+    }
+    return result;
 }
 
 QStringList QmlDirectoryFileEntryFunction::qmlNameFilters(bool skipQmlSources)
@@ -119,6 +199,18 @@ QStringList NameFilterFileEntryFunction::operator()(const QDir &dir) const
     return dir.entryList(m_nameFilters, QDir::Files);
 }
 
+QStringList NameFilterFileEntryFunction::operator()(const QDir &, const QStringList &fileNames) const
+{
+    if (m_nameFilters.isEmpty())
+        return fileNames;
+    QStringList result;
+    foreach (const QString &fileName, fileNames) {
+        if (QDir::match(m_nameFilters, fileName))
+            result.append(fileName);
+    }
+    return result;
+}
+
 //-----------------------------------------------------------------------------
 
 static inline QString webProcessBinary(const char *binaryName, Platform p)
@@ -159,8 +251,8 @@ static bool updateFile(const QString &sourceFileName, const QStringList &nameFil
 {
     const QFileInfo sourceFileInfo(sourceFileName);
     const QString targetFileName = targetDirectory + QLatin1Char('/') + sourceFileInfo.fileName();
-    if (optVerboseLevel > 1)
-        std::wcout << "Checking " << sourceFileName << ", " << targetFileName<< '\n';
+    LOG_MESSAGE(LogDebug) << "Checking " << sourceFileName << ", " << targetFileName
+        << LogField("file", sourceFileName) << LogField("target", targetFileName);
 
     if (!sourceFileInfo.exists()) {
         *errorMessage = QString::fromLatin1("%1 does not exist.").arg(QDir::toNativeSeparators(sourceFileName));
@@ -174,6 +266,9 @@ static bool updateFile(const QString &sourceFileName, const QStringList &nameFil
     }
 
     const QFileInfo targetFileInfo(targetFileName);
+    countEvent(FilesStatedCounter, 2);
+    ioEvent(IoStat, sourceFileName);
+    ioEvent(IoStat, targetFileName);
 
     if (sourceFileInfo.isDir()) {
         if (targetFileInfo.exists()) {
@@ -184,8 +279,8 @@ static bool updateFile(const QString &sourceFileName, const QStringList &nameFil
             } // Not a directory.
         } else { // exists.
             QDir d(targetDirectory);
-            if (optVerboseLevel)
-                std::wcout << "Creating " << QDir::toNativeSeparators(targetFileName) << ".\n";
+            LOG_MESSAGE(LogInfo) << "Creating " << QDir::toNativeSeparators(targetFileName) << '.'
+                << LogField("target", targetFileName);
             if (!(flags & SkipUpdateFile) && !d.mkdir(sourceFileInfo.fileName())) {
                 *errorMessage = QString::fromLatin1("Cannot create directory %1 under %2.")
                                 .arg(sourceFileInfo.fileName(), QDir::toNativeSeparators(targetDirectory));
@@ -194,6 +289,7 @@ static bool updateFile(const QString &sourceFileName, const QStringList &nameFil
         }
         // Recurse into directory
         QDir dir(sourceFileName);
+        ioEvent(IoListDirectory, sourceFileName);
         const QStringList allEntries = dir.entryList(nameFilters, QDir::Files) + dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
         foreach (const QString &entry, allEntries)
             if (!updateFile(sourceFileName + QLatin1Char('/') + entry, nameFilters, targetFileName, flags, json, errorMessage))
@@ -204,46 +300,50 @@ static bool updateFile(const QString &sourceFileName, const QStringList &nameFil
     if (targetFileInfo.exists()) {
         if (!(flags & ForceUpdateFile)
             && targetFileInfo.lastModified() >= sourceFileInfo.lastModified()) {
-            if (optVerboseLevel)
-                std::wcout << sourceFileInfo.fileName() << " is up to date.\n";
+            LOG_MESSAGE(LogInfo) << sourceFileInfo.fileName() << " is up to date."
+                << LogField("file", sourceFileName) << LogField("target", targetFileName);
+            countEvent(UpToDateCounter);
             if (json)
                 json->addFile(sourceFileName, targetDirectory);
             return true;
         }
-        QFile targetFile(targetFileName);
-        if (!(flags & SkipUpdateFile) && !targetFile.remove()) {
-            *errorMessage = QString::fromLatin1("Cannot remove existing file %1: %2")
-                            .arg(QDir::toNativeSeparators(targetFileName), targetFile.errorString());
+        if (!(flags & SkipUpdateFile) && !removeFile(targetFileName, errorMessage))
             return false;
-        }
     } // target exists
     QFile file(sourceFileName);
-    if (optVerboseLevel)
-        std::wcout << "Updating " << sourceFileInfo.fileName() << ".\n";
-    if (!(flags & SkipUpdateFile) && !file.copy(targetFileName)) {
-        *errorMessage = QString::fromLatin1("Cannot copy %1 to %2: %3")
-                .arg(QDir::toNativeSeparators(sourceFileName),
-                     QDir::toNativeSeparators(targetFileName),
-                     file.errorString());
-        return false;
+    LOG_MESSAGE(LogInfo) << "Updating " << sourceFileInfo.fileName() << '.'
+        << LogField("file", sourceFileName) << LogField("target", targetFileName);
+    const TraceSpan span("copy", "file", "file", sourceFileName);
+    if (!(flags & SkipUpdateFile)) {
+        if (!file.copy(targetFileName)) {
+            *errorMessage = QString::fromLatin1("Cannot copy %1 to %2: %3")
+                    .arg(QDir::toNativeSeparators(sourceFileName),
+                         QDir::toNativeSeparators(targetFileName),
+                         file.errorString());
+            return false;
+        }
+        countEvent(BytesCopiedCounter, sourceFileInfo.size());
+        ioCopyEvent(sourceFileName, targetFileName, sourceFileInfo.size());
     }
     if (json)
         json->addFile(sourceFileName, targetDirectory);
     return true;
 }
 
+// Files are placed by the DeploymentStore if one is passed.
 template <class DirectoryFileEntryFunction>
 static bool updateFile(const QString &sourceFileName,
                 DirectoryFileEntryFunction directoryFileEntryFunction,
                 const QString &targetDirectory,
                 unsigned flags,
                 JsonOutput *json,
+                DeploymentStore *store,
                 QString *errorMessage)
 {
     const QFileInfo sourceFileInfo(sourceFileName);
     const QString targetFileName = targetDirectory + QLatin1Char('/') + sourceFileInfo.fileName();
-    if (optVerboseLevel > 1)
-        std::wcout << "Checking " << sourceFileName << ", " << targetFileName << '\n';
+    LOG_MESSAGE(LogDebug) << "Checking " << sourceFileName << ", " << targetFileName
+        << LogField("file", sourceFileName) << LogField("target", targetFileName);
 
     if (!sourceFileInfo.exists()) {
         *errorMessage = QString::fromLatin1("%1 does not exist.").arg(QDir::toNativeSeparators(sourceFileName));
@@ -251,6 +351,9 @@ static bool updateFile(const QString &sourceFileName,
     }
 
     const QFileInfo targetFileInfo(targetFileName);
+    countEvent(FilesStatedCounter, 2);
+    ioEvent(IoStat, sourceFileName);
+    ioEvent(IoStat, targetFileName);
 
     if (sourceFileInfo.isSymLink()) {
         const QString sourcePath = sourceFileInfo.symLinkTarget();
@@ -262,7 +365,7 @@ static bool updateFile(const QString &sourceFileName,
         }
 
         // Update the linked-to file
-        if (!updateFile(sourcePath, directoryFileEntryFunction, targetDirectory, flags, json, errorMessage))
+        if (!updateFile(sourcePath, directoryFileEntryFunction, targetDirectory, flags, json, store, errorMessage))
             return false;
 
         if (targetFileInfo.exists()) {
@@ -285,7 +388,6 @@ static bool updateFile(const QString &sourceFileName,
     } // Source is symbolic link
 
     if (sourceFileInfo.isDir()) {
-        bool created = false;
         if (targetFileInfo.exists()) {
             if (!targetFileInfo.isDir()) {
                 *errorMessage = QString::fromLatin1("%1 already exists and is not a directory.")
@@ -294,69 +396,59 @@ static bool updateFile(const QString &sourceFileName,
             } // Not a directory.
         } else { // exists.
             QDir d(targetDirectory);
-            if (optVerboseLevel)
-                std::wcout << "Creating " << targetFileName << ".\n";
-            if (!(flags & SkipUpdateFile)) {
-                created = d.mkdir(sourceFileInfo.fileName());
-                if (!created) {
-                    *errorMessage = QString::fromLatin1("Cannot create directory %1 under %2.")
-                            .arg(sourceFileInfo.fileName(), QDir::toNativeSeparators(targetDirectory));
-                    return false;
-                }
+            LOG_MESSAGE(LogInfo) << "Creating " << targetFileName << '.'
+                << LogField("target", targetFileName);
+            if (!(flags & SkipUpdateFile) && !d.mkdir(sourceFileInfo.fileName())) {
+                *errorMessage = QString::fromLatin1("Cannot create directory %1 under %2.")
+                        .arg(sourceFileInfo.fileName(), QDir::toNativeSeparators(targetDirectory));
+                return false;
             }
         }
         // Recurse into directory
         QDir dir(sourceFileName);
+        ioEvent(IoListDirectory, sourceFileName);
 
         const QStringList allEntries = directoryFileEntryFunction(dir) + dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
         foreach (const QString &entry, allEntries)
-            if (!updateFile(sourceFileName + QLatin1Char('/') + entry, directoryFileEntryFunction, targetFileName, flags, json, errorMessage))
+            if (!updateFile(sourceFileName + QLatin1Char('/') + entry, directoryFileEntryFunction, targetFileName, flags, json, store, errorMessage))
                 return false;
-        // Remove empty directories, for example QML import folders for which the filter did not match.
-        if (created && (flags & RemoveEmptyQmlDirectories)) {
-            QDir d(targetFileName);
-            const QStringList entries = d.entryList(QStringList(), QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot);
-            if (entries.isEmpty() || (entries.size() == 1 && entries.first() == QLatin1String("qmldir"))) {
-                if (!d.removeRecursively()) {
-                    *errorMessage = QString::fromLatin1("Cannot remove empty directory %1.")
-                            .arg(QDir::toNativeSeparators(targetFileName));
-                    return false;
-                }
-                if (json)
-                    json->removeTargetDirectory(targetFileName);
-            }
-        }
         return true;
     } // Source is directory.
 
     if (targetFileInfo.exists()) {
         if (!(flags & ForceUpdateFile)
             && targetFileInfo.lastModified() >= sourceFileInfo.lastModified()) {
-            if (optVerboseLevel)
-                std::wcout << sourceFileInfo.fileName() << " is up to date.\n";
+            LOG_MESSAGE(LogInfo) << sourceFileInfo.fileName() << " is up to date."
+                << LogField("file", sourceFileName) << LogField("target", targetFileName);
+            countEvent(UpToDateCounter);
             if (json)
                 json->addFile(sourceFileName, targetDirectory);
             return true;
         }
-        QFile targetFile(targetFileName);
-        if (!(flags & SkipUpdateFile) && !targetFile.remove()) {
-            *errorMessage = QString::fromLatin1("Cannot remove existing file %1: %2")
-                            .arg(QDir::toNativeSeparators(targetFileName), targetFile.errorString());
+        if (!(flags & SkipUpdateFile) && !removeFile(targetFileName, errorMessage))
             return false;
-        }
     } // target exists
     QFile file(sourceFileName);
-    if (optVerboseLevel)
-        std::wcout << "Updating " << sourceFileInfo.fileName() << ".\n";
+    LOG_MESSAGE(LogInfo) << "Updating " << sourceFileInfo.fileName() << '.'
+        << LogField("file", sourceFileName) << LogField("target", targetFileName);
+    const TraceSpan span("copy", "file", "file", sourceFileName);
     if (!(flags & SkipUpdateFile)) {
-        if (!file.copy(targetFileName)) {
+        if (store) {
+            if (!store->place(sourceFileName, targetFileName, errorMessage))
+                return false;
+        } else if (file.copy(targetFileName)) {
+            countEvent(BytesCopiedCounter, sourceFileInfo.size());
+            ioCopyEvent(sourceFileName, targetFileName, sourceFileInfo.size());
+        } else {
             *errorMessage = QString::fromLatin1("Cannot copy %1 to %2: %3")
                 .arg(QDir::toNativeSeparators(sourceFileName),
                      QDir::toNativeSeparators(targetFileName),
                      file.errorString());
             return false;
         }
-        if (!(file.permissions() & QFile::WriteUser)) { // QTBUG-40152, clear inherited read-only attribute
+        // QTBUG-40152, clear inherited read-only attribute. Hard links into the store
+        // must stay read-only since they share the object.
+        if (!store && !(file.permissions() & QFile::WriteUser)) {
             QFile targetFile(targetFileName);
             if (!targetFile.setPermissions(targetFile.permissions() | QFile::WriteUser)) {
                 *errorMessage = QString::fromLatin1("Cannot set write permission on %1: %2")
@@ -370,56 +462,281 @@ static bool updateFile(const QString &sourceFileName,
     return true;
 }
 
-static bool updateFile(const QString &sourceFileName, const QString &targetDirectory,
-                       unsigned flags, JsonOutput *json, QString *errorMessage)
+bool updateFile(const QString &sourceFileName, const QString &targetDirectory,
+                unsigned flags, JsonOutput *json, DeploymentStore *store, QString *errorMessage)
 {
     return updateFile(sourceFileName, NameFilterFileEntryFunction(QStringList()),
-                      targetDirectory, flags, json, errorMessage);
+                      targetDirectory, flags, json, store, errorMessage);
 }
 
-// Return dependent modules of executable files.
-static QStringList findDependentLibraries(const QString &executableFileName, Platform platform, QString *errorMessage)
+namespace {
+
+struct FileCopy {
+    FileCopy() : success(false) {}
+    FileCopy(const QString &s, const QString &t) : sourceFileName(s), targetDirectory(t), success(false) {}
+
+    QString sourceFileName;
+    QString targetDirectory;
+    bool success;
+    QString errorMessage;
+};
+
+// Copies every stride-th file of the queue.
+class FileCopyTask : public QRunnable
 {
-    QStringList result;
-    readExecutable(executableFileName, platform, errorMessage, &result);
-    return result;
-}
+public:
+    FileCopyTask(QVector<FileCopy> *queue, int first, int stride, unsigned flags, DeploymentStore *store)
+        : m_queue(queue), m_first(first), m_stride(stride), m_flags(flags), m_store(store)
+        , m_logContext(currentLogContext()) {}
+
+    void run() Q_DECL_OVERRIDE
+    {
+        const LogScope logScope(m_logContext);
+        for (int i = m_first; i < m_queue->size(); i += m_stride) {
+            FileCopy &copy = (*m_queue)[i];
+            copy.success = updateFile(copy.sourceFileName, copy.targetDirectory, m_flags, 0, m_store,
+                                      &copy.errorMessage);
+        }
+    }
+
+private:
+    QVector<FileCopy> *m_queue;
+    const int m_first;
+    const int m_stride;
+    const unsigned m_flags;
+    DeploymentStore *m_store;
+    const LogContext m_logContext;
+};
 
-// Helper for recursively finding all dependent Qt libraries.
-static bool findDependentQtLibraries(const QString &qtBinDir, const QString &binary, Platform platform,
-                                     QString *errorMessage, QStringList *result,
-                                     unsigned *wordSize = 0, bool *isDebug = 0,
-                                     int *directDependencyCount = 0, int recursionDepth = 0)
+} // namespace
+
+// Deploy a QML import tree. The source tree is read once by the parallel
+// directory walker, directories are created in order (with
+// RemoveEmptyQmlDirectories, new ones not receiving any files besides qmldir
+// are dropped), then the files are copied by a pool of threads. The JSON
+// output is added in the order of the walk. The target paths of deployed
+// .qml/.js files are appended to qmlSourceFiles if passed.
+static bool updateQmlImportTree(const QString &sourceDirName, const QmlDirectoryFileEntryFunction &fileEntryFunction,
+                                const QString &targetDirectory, unsigned flags, int jobs,
+                                JsonOutput *json, DeploymentStore *store, QStringList *qmlSourceFiles,
+                                QString *errorMessage)
 {
-    QStringList dependentLibs;
-    if (directDependencyCount)
-        *directDependencyCount = 0;
-    if (!readExecutable(binary, platform, errorMessage, &dependentLibs, wordSize, isDebug)) {
-        errorMessage->prepend(QLatin1String("Unable to find dependent libraries of ") +
-                              QDir::toNativeSeparators(binary) + QLatin1String(" :"));
+    QList<WalkedDirectory> directories;
+    if (!walkDirectoryTree(sourceDirName, jobs, &directories, errorMessage))
         return false;
+    const QString targetRoot = targetDirectory + QLatin1Char('/') + QFileInfo(sourceDirName).fileName();
+
+    // Classify: files to copy per directory and whether the directory is kept.
+    const int directoryCount = directories.size();
+    QVector<QStringList> files(directoryCount);
+    QVector<QStringList> symLinks(directoryCount);
+    QVector<bool> keep(directoryCount, false);
+    QHash<QString, int> directoryIndexes;
+    for (int d = 0; d < directoryCount; ++d) {
+        const WalkedDirectory &directory = directories.at(d);
+        directoryIndexes.insert(directory.relativePath, d);
+        const QString sourcePath = directory.relativePath.isEmpty()
+            ? sourceDirName : sourceDirName + QLatin1Char('/') + directory.relativePath;
+        const QStringList fileNames = directory.entries.files + directory.entries.symLinks;
+        foreach (const QString &fileName, fileEntryFunction(QDir(sourcePath), fileNames)) {
+            if (directory.entries.symLinks.contains(fileName))
+                symLinks[d].append(fileName);
+            else
+                files[d].append(fileName);
+            if (fileName != QLatin1String("qmldir"))
+                keep[d] = true;
+        }
+        symLinks[d] += directory.entries.symLinkDirectories;
+        if (!directory.entries.symLinkDirectories.isEmpty())
+            keep[d] = true;
+    }
+    // Subdirectories follow their parents, propagate upwards.
+    for (int d = directoryCount - 1; d > 0; --d) {
+        if (keep.at(d)) {
+            const QString &relativePath = directories.at(d).relativePath;
+            const int slashPos = relativePath.lastIndexOf(QLatin1Char('/'));
+            keep[directoryIndexes.value(slashPos < 0 ? QString() : relativePath.left(slashPos))] = true;
+        }
+    }
+
+    // Create the directories and queue the files.
+    QVector<FileCopy> queue;
+    QList<FileCopy> symLinkUpdates;
+    QSet<QString> droppedDirectories;
+    for (int d = 0; d < directoryCount; ++d) {
+        const QString &relativePath = directories.at(d).relativePath;
+        const QString sourcePath = relativePath.isEmpty() ? sourceDirName : sourceDirName + QLatin1Char('/') + relativePath;
+        const QString targetPath = relativePath.isEmpty() ? targetRoot : targetRoot + QLatin1Char('/') + relativePath;
+        const int slashPos = relativePath.lastIndexOf(QLatin1Char('/'));
+        if (!relativePath.isEmpty()
+            && droppedDirectories.contains(slashPos < 0 ? QString() : relativePath.left(slashPos))) {
+            droppedDirectories.insert(relativePath);
+            continue;
+        }
+        const QFileInfo targetInfo(targetPath);
+        if (targetInfo.exists()) {
+            if (!targetInfo.isDir()) {
+                *errorMessage = QString::fromLatin1("%1 already exists and is not a directory.")
+                                .arg(QDir::toNativeSeparators(targetPath));
+                return false;
+            }
+        } else {
+            if ((flags & RemoveEmptyQmlDirectories) && !keep.at(d)) {
+                LOG_MESSAGE(LogDebug) << "Skipping " << sourcePath << ", no files to deploy."
+                    << LogField("file", sourcePath);
+                droppedDirectories.insert(relativePath);
+                continue;
+            }
+            LOG_MESSAGE(LogInfo) << "Creating " << targetPath << '.'
+                << LogField("target", targetPath);
+            if (!(flags & SkipUpdateFile) && !QDir().mkdir(targetPath)) {
+                *errorMessage = QString::fromLatin1("Cannot create directory %1.")
+                                .arg(QDir::toNativeSeparators(targetPath));
+                return false;
+            }
+        }
+        foreach (const QString &fileName, files.at(d))
+            queue.append(FileCopy(sourcePath + QLatin1Char('/') + fileName, targetPath));
+        foreach (const QString &fileName, symLinks.at(d))
+            symLinkUpdates.append(FileCopy(sourcePath + QLatin1Char('/') + fileName, targetPath));
+    }
+
+    if (jobs <= 0)
+        jobs = QThread::idealThreadCount();
+    const int taskCount = qBound(1, queue.size() / 8, qMax(1, jobs));
+    if (taskCount == 1) {
+        FileCopyTask(&queue, 0, 1, flags, store).run();
+    } else {
+        QThreadPool pool;
+        pool.setMaxThreadCount(taskCount);
+        for (int t = 0; t < taskCount; ++t)
+            pool.start(new FileCopyTask(&queue, t, taskCount, flags, store));
+        pool.waitForDone();
     }
-    // Filter out the Qt libraries. Note that depends.exe finds libs from optDirectory if we
-    // are run the 2nd time (updating). We want to check against the Qt bin dir libraries
-    const int start = result->size();
-    foreach (const QString &lib, dependentLibs) {
-        if (isQtModule(lib)) {
-            const QString path = normalizeFileName(qtBinDir + QLatin1Char('/') + QFileInfo(lib).fileName());
-            if (!result->contains(path))
-                result->append(path);
-        }
-    }
-    const int end = result->size();
-    if (directDependencyCount)
-        *directDependencyCount = end - start;
-    // Recurse
-    for (int i = start; i < end; ++i)
-        if (!findDependentQtLibraries(qtBinDir, result->at(i), platform, errorMessage, result, 0, 0, 0, recursionDepth + 1))
+    foreach (const FileCopy &copy, queue) {
+        if (!copy.success) {
+            *errorMessage = copy.errorMessage;
             return false;
+        }
+        if (json)
+            json->addFile(copy.sourceFileName, copy.targetDirectory);
+        if (qmlSourceFiles && (copy.sourceFileName.endsWith(QLatin1String(".qml"))
+                               || copy.sourceFileName.endsWith(QLatin1String(".js")))) {
+            qmlSourceFiles->append(copy.targetDirectory + QLatin1Char('/') + QFileInfo(copy.sourceFileName).fileName());
+        }
+    }
+    // Symbolic links refer to files of the same directory, update them last.
+    foreach (const FileCopy &symLink, symLinkUpdates) {
+        if (!updateFile(symLink.sourceFileName, fileEntryFunction, symLink.targetDirectory,
+                        flags, json, store, errorMessage)) {
+            return false;
+        }
+    }
     return true;
 }
 
-static QStringList findQtPlugins(quint64 *usedQtModules, quint64 disabledQtModules,
+// Place a file of the shared runtime directory into an application directory
+// by a hard link, falling back to copying (different volumes). Symbolic links
+// (Unix library versions) are recreated after placing the file they point to,
+// a hard link to them would point into the application directory.
+bool linkSharedFile(const QString &sharedFileName, const QString &targetDirectory,
+                    unsigned flags, JsonOutput *json, QString *errorMessage)
+{
+    const QFileInfo sharedFileInfo(sharedFileName);
+    const QString targetFileName = targetDirectory + QLatin1Char('/') + sharedFileInfo.fileName();
+    const QFileInfo targetFileInfo(targetFileName);
+    countEvent(FilesStatedCounter, 2);
+    ioEvent(IoStat, sharedFileName);
+    ioEvent(IoStat, targetFileName);
+    if (sharedFileInfo.isSymLink()) {
+        const QString linkTarget = sharedFileInfo.symLinkTarget();
+        const QString relativeLinkTarget = QDir(sharedFileInfo.absolutePath()).relativeFilePath(linkTarget);
+        if (relativeLinkTarget.contains(QLatin1Char('/'))) {
+            *errorMessage = QString::fromLatin1("Symbolic links across directories are not supported (%1).")
+                            .arg(QDir::toNativeSeparators(sharedFileName));
+            return false;
+        }
+        if (!linkSharedFile(linkTarget, targetDirectory, flags, json, errorMessage))
+            return false;
+        // Links copied by earlier versions point to the right name, too.
+        if (targetFileInfo.isSymLink()) {
+            if (QDir(targetDirectory).relativeFilePath(targetFileInfo.symLinkTarget()) == relativeLinkTarget)
+                return true;
+        }
+        if (flags & SkipUpdateFile)
+            return true;
+        if (targetFileInfo.isSymLink() || targetFileInfo.exists()) {
+            if (!removeFile(targetFileName, errorMessage))
+                return false;
+        }
+        return createSymbolicLink(QFileInfo(targetDirectory + QLatin1Char('/') + relativeLinkTarget),
+                                  sharedFileInfo.fileName(), errorMessage);
+    } // Shared file is symbolic link
+    if (targetFileInfo.exists()) {
+        // A hard link shares size and time stamp with the shared file.
+        if (!(flags & ForceUpdateFile) && targetFileInfo.size() == sharedFileInfo.size()
+            && targetFileInfo.lastModified() >= sharedFileInfo.lastModified()) {
+            LOG_MESSAGE(LogInfo) << sharedFileInfo.fileName() << " is up to date."
+                << LogField("file", sharedFileName) << LogField("target", targetFileName);
+            countEvent(UpToDateCounter);
+            if (json)
+                json->addFile(sharedFileName, targetDirectory);
+            return true;
+        }
+        if (!(flags & SkipUpdateFile) && !removeFile(targetFileName, errorMessage))
+            return false;
+    } // target exists
+    LOG_MESSAGE(LogInfo) << "Linking " << sharedFileInfo.fileName() << '.'
+        << LogField("file", sharedFileName) << LogField("target", targetFileName);
+    const TraceSpan span("link", "file", "file", sharedFileName);
+    if (!(flags & SkipUpdateFile)) {
+        QString linkErrorMessage;
+        if (!createHardLink(sharedFileName, targetFileName, &linkErrorMessage)) {
+            LOG_MESSAGE(LogDebug) << linkErrorMessage << ", copying."
+                << LogField("file", sharedFileName);
+            return updateFile(sharedFileName, targetDirectory, flags | ForceUpdateFile, json, 0, errorMessage);
+        }
+    }
+    if (json)
+        json->addFile(sharedFileName, targetDirectory);
+    return true;
+}
+
+// Write a qt.conf pointing to the plugins of the shared runtime directory.
+static bool writeSharedRuntimeQtConf(const QString &directory, const QString &sharedRuntimeDirectory,
+                                     unsigned flags, QString *errorMessage)
+{
+    const QString fileName = directory + QStringLiteral("/qt.conf");
+    const QString plugins = QDir(directory).relativeFilePath(sharedRuntimeDirectory);
+    const QByteArray content = "[Paths]\nPlugins = " + plugins.toUtf8() + '\n';
+    QFile file(fileName);
+    if (file.open(QIODevice::ReadOnly) && file.readAll() == content) {
+        countEvent(UpToDateCounter);
+        return true;
+    }
+    file.close();
+    if (verboseLevel())
+        logStream() << "Creating " << QDir::toNativeSeparators(fileName) << "...\n";
+    if (flags & SkipUpdateFile)
+        return true;
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(content) != content.size()) {
+        *errorMessage = QString::fromLatin1("Unable to write %1: %2")
+                        .arg(QDir::toNativeSeparators(fileName), file.errorString());
+        return false;
+    }
+    return true;
+}
+
+// Return dependent modules of executable files.
+static QStringList findDependentLibraries(DeploymentCache *cache, const QString &executableFileName,
+                                          Platform platform, QString *errorMessage)
+{
+    QStringList result;
+    cache->readExecutable(executableFileName, platform, errorMessage, &result);
+    return result;
+}
+
+static QStringList findQtPlugins(DeploymentCache *cache, quint64 *usedQtModules, quint64 disabledQtModules,
                                  const QString &qtPluginsDirName, const QString &libraryLocation,
                                  DebugMatchMode debugMatchModeIn, Platform platform, QString *platformPlugin)
 {
@@ -428,7 +745,9 @@ static QStringList findQtPlugins(quint64 *usedQtModules, quint64 disabledQtModul
         return QStringList();
     QDir pluginsDir(qtPluginsDirName);
     QStringList result;
-    foreach (const QString &subDirName, pluginsDir.entryList(QStringList(QLatin1String("*")), QDir::Dirs | QDir::NoDotAndDotDot)) {
+    const QtInstallationIndex *index = cache->qtIndex();
+    const QStringList subDirNames = index ? index->pluginCategories() : cache->subDirectories(pluginsDir);
+    foreach (const QString &subDirName, subDirNames) {
         const quint64 module = qtModuleForPlugin(subDirName);
         if (module & *usedQtModules) {
             const DebugMatchMode debugMatchMode = (module & QtWebEngineCoreModule)
@@ -465,28 +784,44 @@ static QStringList findQtPlugins(quint64 *usedQtModules, quint64 disabledQtModul
             } else {
                 filter  = QLatin1String("*");
             }
-            const QStringList plugins = findSharedLibraries(subDir, platform, debugMatchMode, filter);
-            foreach (const QString &plugin, plugins) {
+            // Take the plugins from the index if there is one, else scan the directory.
+            QtInstallationIndex::LibraryList plugins;
+            if (index) {
+                foreach (const QtInstallationIndex::Library &library, index->plugins(subDirName)) {
+                    if (QtInstallationIndex::matches(library, platform, debugMatchMode, filter))
+                        plugins.append(library);
+                }
+            } else {
+                foreach (const QString &fileName, cache->findSharedLibraries(subDir, platform, debugMatchMode, filter)) {
+                    QtInstallationIndex::Library library;
+                    library.fileName = fileName;
+                    plugins.append(library);
+                }
+            }
+            foreach (const QtInstallationIndex::Library &library, plugins) {
+                const QString &plugin = library.fileName;
                 const QString pluginPath = subDir.absoluteFilePath(plugin);
                 if (isPlatformPlugin)
                     *platformPlugin = pluginPath;
                 QStringList dependentQtLibs;
-                quint64 neededModules = 0;
-                if (findDependentQtLibraries(libraryLocation, pluginPath, platform, &errorMessage, &dependentQtLibs)) {
-                    for (int d = 0; d < dependentQtLibs.size(); ++ d)
-                        neededModules |= qtModule(dependentQtLibs.at(d));
-                } else {
-                    std::wcerr << "Warning: Cannot determine dependencies of "
-                               << QDir::toNativeSeparators(pluginPath) << ": " << errorMessage << '\n';
+                quint64 neededModules = library.modules;
+                if (!library.dependenciesKnown) {
+                    if (cache->findDependentQtLibraries(libraryLocation, pluginPath, platform, &errorMessage, &dependentQtLibs)) {
+                        for (int d = 0; d < dependentQtLibs.size(); ++ d)
+                            neededModules |= qtModule(dependentQtLibs.at(d));
+                    } else {
+                        errorStream() << "Warning: Cannot determine dependencies of "
+                                   << QDir::toNativeSeparators(pluginPath) << ": " << errorMessage << '\n';
+                    }
                 }
                 if (neededModules & disabledQtModules) {
-                    if (optVerboseLevel)
-                        std::wcout << "Skipping plugin " << plugin << " due to disabled dependencies.\n";
+                    if (verboseLevel())
+                        logStream() << "Skipping plugin " << plugin << " due to disabled dependencies.\n";
                 } else {
                     if (const quint64 missingModules = (neededModules & ~*usedQtModules)) {
                         *usedQtModules |= missingModules;
-                        if (optVerboseLevel)
-                            std::wcout << "Adding " << formatQtModules(missingModules).constData() << " for " << plugin << '\n';
+                        if (verboseLevel())
+                            logStream() << "Adding " << formatQtModules(missingModules).constData() << " for " << plugin << '\n';
                     }
                     result.append(pluginPath);
                 }
@@ -499,16 +834,20 @@ static QStringList findQtPlugins(quint64 *usedQtModules, quint64 disabledQtModul
 // Search for "qt_prfxpath=xxxx" in \a path, and replace it with "qt_prfxpath=."
 static bool patchQtCore(const QString &path, QString *errorMessage)
 {
-    if (optVerboseLevel)
-        std::wcout << "Patching " << QFileInfo(path).fileName() << "...\n";
+    const PhaseTimer phaseTimer(CorePatchPhase);
+    if (verboseLevel())
+        logStream() << "Patching " << QFileInfo(path).fileName() << "...\n";
 
     QFile file(path);
-    if (!file.open(QIODevice::ReadWrite)) {
+    if (!file.open(QIODevice::ReadOnly)) {
         *errorMessage = QString::fromLatin1("Unable to patch %1: %2").arg(
                     QDir::toNativeSeparators(path), file.errorString());
         return false;
     }
     QByteArray content = file.readAll();
+    file.close();
+    ioEvent(IoOpen, path);
+    ioEvent(IoRead, path, content.size());
 
     if (content.isEmpty()) {
         *errorMessage = QString::fromLatin1("Unable to patch %1: Could not read file content").arg(
@@ -532,59 +871,281 @@ static bool patchQtCore(const QString &path, QString *errorMessage)
         return false;
     }
 
+    if (endPos - startPos == 1 && content.at(startPos) == '.')
+        return true; // Already patched.
+
     QByteArray replacement = QByteArray(endPos - startPos, char(0));
     replacement[0] = '.';
     content.replace(startPos, endPos - startPos, replacement);
 
-    if (!file.seek(0)
-            || (file.write(content) != content.size())) {
+    // Write a new file instead of modifying the existing one, which may be a hard
+    // link into the shared runtime directory or the deployment store.
+    if (!makeFileWritable(path, errorMessage))
+        return false;
+    QSaveFile saveFile(path);
+    if (!saveFile.open(QIODevice::WriteOnly)
+            || (saveFile.write(content) != content.size()) || !saveFile.commit()) {
         *errorMessage = QString::fromLatin1("Unable to patch %1: Could not write to file").arg(
                     QDir::toNativeSeparators(path));
         return false;
     }
+    ioEvent(IoOpen, path);
+    ioEvent(IoWrite, path, content.size());
     return true;
 }
 
 //-----------------------------------------------------------------------------
 
-bool Deployment::deployTranslations(const QString &sourcePath, quint64 usedQtModules, const QString &target, unsigned flags, QString *errorMessage)
+namespace {
+
+struct TranslationCatalogJob {
+    TranslationCatalogJob() : success(false) {}
+
+    QString targetFilePath;
+    QStringList qmFiles; // Relative to the translations directory.
+    QString cacheKey;
+    QByteArray stamp;
+    bool success;
+    QString errorMessage;
+};
+
+// Merges the catalogs of every stride-th language.
+class TranslationCatalogTask : public QRunnable
 {
-    // Find available languages prefixes by checking on qtbase.
+public:
+    TranslationCatalogTask(const QString &sourcePath, QVector<TranslationCatalogJob> *jobs, int first, int stride)
+        : m_sourcePath(sourcePath), m_jobs(jobs), m_first(first), m_stride(stride)
+        , m_logContext(currentLogContext()) {}
+
+    void run() Q_DECL_OVERRIDE
+    {
+        const LogScope logScope(m_logContext);
+        for (int i = m_first; i < m_jobs->size(); i += m_stride) {
+            TranslationCatalogJob &job = (*m_jobs)[i];
+            QStringList inputFiles;
+            foreach (const QString &qmFile, job.qmFiles)
+                inputFiles.append(m_sourcePath + QLatin1Char('/') + qmFile);
+            job.success = mergeQmFiles(inputFiles, job.targetFilePath, &job.errorMessage);
+        }
+    }
+
+private:
+    const QString m_sourcePath;
+    QVector<TranslationCatalogJob> *m_jobs;
+    const int m_first;
+    const int m_stride;
+    const LogContext m_logContext;
+};
+
+} // namespace
+
+// The list of input files a translation catalog was merged from is recorded in
+// the cache directory, so that a catalog is rebuilt when the modules or the
+// available translations change even if none of its inputs is newer.
+static QString translationStampFileName(const QString &targetFilePath)
+{
+    const QString cacheLocation = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (cacheLocation.isEmpty())
+        return QString();
+    const QByteArray hash = QCryptographicHash::hash(targetFilePath.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return cacheLocation + QStringLiteral("/translations-") + QString::fromLatin1(hash.left(16))
+        + QStringLiteral(".txt");
+}
+
+static QByteArray translationStamp(const QString &sourcePath, const QStringList &qmFiles)
+{
+    return (sourcePath + QLatin1Char('\n') + qmFiles.join(QLatin1Char('\n'))).toUtf8();
+}
+
+static bool matchesTranslationStamp(const QString &targetFilePath, const QByteArray &stamp)
+{
+    const QString stampFileName = translationStampFileName(targetFilePath);
+    if (stampFileName.isEmpty())
+        return false;
+    QFile file(stampFileName);
+    return file.open(QIODevice::ReadOnly) && file.readAll() == stamp;
+}
+
+// Failing to write the stamp only causes the catalog to be rebuilt next time.
+static void writeTranslationStamp(const QString &targetFilePath, const QByteArray &stamp)
+{
+    const QString stampFileName = translationStampFileName(targetFilePath);
+    if (stampFileName.isEmpty() || !QDir().mkpath(QFileInfo(stampFileName).absolutePath()))
+        return;
+    QSaveFile file(stampFileName);
+    if (file.open(QIODevice::WriteOnly) && file.write(stamp) == stamp.size())
+        file.commit();
+}
+
+// Return the existing files of a list of translation file names, checking
+// them individually instead of listing the translations directory.
+static QStringList existingTranslations(const QDir &sourceDir, const QtInstallationIndex *index,
+                                        const QStringList &fileNames)
+{
+    if (index)
+        return index->translations(fileNames);
+    QStringList result;
+    foreach (const QString &fileName, fileNames) {
+        const QString filePath = sourceDir.absoluteFilePath(fileName);
+        ioEvent(IoStat, filePath);
+        if (QFileInfo(filePath).isFile())
+            result.append(fileName);
+    }
+    countEvent(FilesStatedCounter, fileNames.size());
+    return result;
+}
+
+bool Deployment::deployTranslations(const QString &sourcePath, quint64 usedQtModules, const QString &target,
+                                    const QStringList &languages, unsigned flags, QString *errorMessage)
+{
+    // Find available languages prefixes by checking on qtbase, or check the requested ones.
+    // The index of the Qt installation lists QT_INSTALL_TRANSLATIONS.
     QStringList prefixes;
     QDir sourceDir(sourcePath);
-    const QStringList qmFilter = QStringList(QStringLiteral("qtbase_*.qm"));
-    foreach (QString qmFile, sourceDir.entryList(qmFilter)) {
-        qmFile.chop(3);
-        qmFile.remove(0, 7);
-        prefixes.push_back(qmFile);
+    const QtInstallationIndex *index = m_cache->qtIndex();
+    if (languages.isEmpty()) {
+        const QStringList qmFilter = QStringList(QStringLiteral("qtbase_*.qm"));
+        foreach (QString qmFile, index ? index->translations(qmFilter) : sourceDir.entryList(qmFilter)) {
+            qmFile.chop(3);
+            qmFile.remove(0, 7);
+            prefixes.push_back(qmFile);
+        }
+    } else {
+        foreach (const QString &language, languages) {
+            const QString qtBaseFile = QStringLiteral("qtbase_") + language + QStringLiteral(".qm");
+            if (existingTranslations(sourceDir, index, QStringList(qtBaseFile)).isEmpty()) {
+                errorStream() << "Warning: Could not find translations for " << language << " in "
+                           << QDir::toNativeSeparators(sourcePath) << ".\n";
+            } else {
+                prefixes.push_back(language);
+            }
+        }
     }
     if (prefixes.isEmpty()) {
-        std::wcerr << "Warning: Could not find any translations in "
-                   << QDir::toNativeSeparators(sourcePath) << " (developer build?)\n.";
+        errorStream() << "Warning: Could not find any translations in "
+                   << QDir::toNativeSeparators(sourcePath) << " (developer build?).\n";
         return true;
     }
-    // Run lconvert to concatenate all files into a single named "qt_<prefix>.qm" in the application folder
-    // Use QT_INSTALL_TRANSLATIONS as working directory to keep the command line short.
+    // Merge all files into a single catalog named "qt_<prefix>.qm" in the application folder,
+    // the languages in parallel. Catalogs already built for another application with the same
+    // modules are copied, catalogs merged from the same inputs and newer than all of them are kept.
     const QString absoluteTarget = QFileInfo(target).absoluteFilePath();
-    const QString binary = QStringLiteral("lconvert");
-    QStringList arguments;
+    QVector<TranslationCatalogJob> jobs;
     foreach (const QString &prefix, prefixes) {
         const QString targetFile = QStringLiteral("qt_") + prefix + QStringLiteral(".qm");
-        arguments.append(QStringLiteral("-o"));
-        arguments.append(QDir::toNativeSeparators(absoluteTarget + QLatin1Char('/') + targetFile));
-        foreach (const QString &qmFile, sourceDir.entryList(translationNameFilters(usedQtModules, prefix)))
-            arguments.append(qmFile);
-        if (optVerboseLevel)
-            std::wcout << "Creating " << targetFile << "...\n";
-        unsigned long exitCode;
-        if (!(flags & SkipUpdateFile)
-                && (!runProcess(binary, arguments, sourcePath, &exitCode, 0, 0, errorMessage) || exitCode)) {
-            return false;
+        const QString targetFilePath = absoluteTarget + QLatin1Char('/') + targetFile;
+        const QString cacheKey = sourcePath + QLatin1Char('|') + QString::number(usedQtModules)
+                + QLatin1Char('|') + prefix;
+        const QString cachedCatalog = m_cache->translationCatalog(cacheKey);
+        if (!cachedCatalog.isEmpty() && cachedCatalog != targetFilePath && QFileInfo(cachedCatalog).isFile()) {
+            if (!updateFile(cachedCatalog, absoluteTarget, flags, 0, m_options.store, errorMessage))
+                return false;
+            continue;
         }
+        const QStringList qmFilters = translationNameFilters(usedQtModules, prefix);
+        const QStringList qmFiles = existingTranslations(sourceDir, index, qmFilters);
+        const QByteArray stamp = translationStamp(sourcePath, qmFiles);
+        const QFileInfo targetFileInfo(targetFilePath);
+        countEvent(FilesStatedCounter);
+        ioEvent(IoStat, targetFilePath);
+        if (!(flags & ForceUpdateFile) && targetFileInfo.exists()
+            && matchesTranslationStamp(targetFilePath, stamp)) {
+            const QDateTime targetTime = targetFileInfo.lastModified();
+            bool upToDate = true;
+            foreach (const QString &qmFile, qmFiles) {
+                countEvent(FilesStatedCounter);
+                ioEvent(IoStat, sourceDir.absoluteFilePath(qmFile));
+                if (QFileInfo(sourceDir, qmFile).lastModified() > targetTime) {
+                    upToDate = false;
+                    break;
+                }
+            }
+            if (upToDate) {
+                if (verboseLevel())
+                    logStream() << targetFile << " is up to date.\n";
+                countEvent(UpToDateCounter);
+                m_cache->addTranslationCatalog(cacheKey, targetFilePath);
+                continue;
+            }
+        }
+        if (verboseLevel())
+            logStream() << "Creating " << targetFile << "...\n";
+        TranslationCatalogJob job;
+        job.targetFilePath = targetFilePath;
+        job.qmFiles = qmFiles;
+        job.cacheKey = cacheKey;
+        job.stamp = stamp;
+        jobs.append(job);
     } // for prefixes.
+    if ((flags & SkipUpdateFile) || jobs.isEmpty())
+        return true;
+
+    const int threadCount = m_options.jobs > 0 ? m_options.jobs : QThread::idealThreadCount();
+    const int taskCount = qBound(1, jobs.size(), qMax(1, threadCount));
+    QThreadPool pool;
+    pool.setMaxThreadCount(taskCount);
+    for (int t = 0; t < taskCount; ++t)
+        pool.start(new TranslationCatalogTask(sourcePath, &jobs, t, taskCount));
+    pool.waitForDone();
+    // Run lconvert for the catalogs the builtin merger cannot handle. Use
+    // QT_INSTALL_TRANSLATIONS as working directory to keep the command line short.
+    QHash<int, ProcessFuture> lconvertRuns;
+    for (int j = 0; j < jobs.size(); ++j) {
+        const TranslationCatalogJob &job = jobs.at(j);
+        if (!job.success) {
+            if (verboseLevel() > 1)
+                logStream() << job.errorMessage << ", running lconvert.\n";
+            QStringList arguments;
+            arguments << QStringLiteral("-o") << QDir::toNativeSeparators(job.targetFilePath) << job.qmFiles;
+            lconvertRuns.insert(j, m_cache->processPool()->start(QStringLiteral("lconvert"), arguments, sourcePath));
+        }
+    }
+    for (int j = 0; j < jobs.size(); ++j) {
+        const TranslationCatalogJob &job = jobs.at(j);
+        if (!job.success) {
+            const ProcessResult &lconvertResult = lconvertRuns.value(j).result();
+            if (!lconvertResult.started) {
+                *errorMessage = lconvertResult.errorMessage;
+                return false;
+            }
+            if (lconvertResult.exitCode) {
+                *errorMessage = QString::fromLatin1("lconvert failed to create %1: %2")
+                                .arg(QDir::toNativeSeparators(job.targetFilePath),
+                                     QString::fromLocal8Bit(lconvertResult.stdErr).trimmed());
+                return false;
+            }
+        }
+        writeTranslationStamp(job.targetFilePath, job.stamp);
+        m_cache->addTranslationCatalog(job.cacheKey, job.targetFilePath);
+    }
     return true;
 }
 
+// Update a file of the shared runtime directory (once per run, also for the
+// entries of a batch) and link it into the target directory unless that is empty.
+bool Deployment::deploySharedRuntimeFile(const Options &options, const QString &sourceFileName,
+                                         const QString &sharedDirectory, const QString &targetDirectory,
+                                         bool patch, QString *errorMessage)
+{
+    const QString sharedFileName = sharedDirectory + QLatin1Char('/') + QFileInfo(sourceFileName).fileName();
+    {
+        QMutexLocker locker(m_cache->sharedRuntimeMutex());
+        if (!m_cache->containsSharedFile(sharedFileName)) {
+            if (!createDirectory(sharedDirectory, errorMessage)
+                || !updateFile(sourceFileName, sharedDirectory, options.updateFileFlags, options.json,
+                               options.store, errorMessage)) {
+                return false;
+            }
+            // Patch before linking, the links share the content.
+            if (patch && !patchQtCore(sharedFileName, errorMessage))
+                return false;
+            m_cache->addSharedFile(sharedFileName);
+        }
+    }
+    return targetDirectory.isEmpty()
+        || linkSharedFile(sharedFileName, targetDirectory, options.updateFileFlags, options.json, errorMessage);
+}
+
 QStringList Deployment::compilerRunTimeLibs(Platform platform, bool isDebug, unsigned wordSize)
 {
     QStringList result;
@@ -593,7 +1154,7 @@ QStringList Deployment::compilerRunTimeLibs(Platform platform, bool isDebug, uns
         static const char *minGwRuntimes[] = {"*gcc_", "*stdc++", "*winpthread"};
         const QString gcc = findInPath(QStringLiteral("g++.exe"));
         if (gcc.isEmpty()) {
-            std::wcerr << "Warning: Cannot find GCC installation directory. g++.exe must be in the path.\n";
+            errorStream() << "Warning: Cannot find GCC installation directory. g++.exe must be in the path.\n";
             break;
         }
         const QString binPath = QFileInfo(gcc).absolutePath();
@@ -612,7 +1173,7 @@ QStringList Deployment::compilerRunTimeLibs(Platform platform, bool isDebug, uns
         const QChar slash(QLatin1Char('/'));
         QString vcRedistDirName = QDir::cleanPath(QFile::decodeName(qgetenv(vcDirVar)));
         if (vcRedistDirName.isEmpty()) {
-            std::wcerr << "Warning: Cannot find Visual Studio installation directory, " << vcDirVar << " is not set.\n";
+            errorStream() << "Warning: Cannot find Visual Studio installation directory, " << vcDirVar << " is not set.\n";
             break;
         }
         if (!vcRedistDirName.endsWith(slash))
@@ -620,7 +1181,7 @@ QStringList Deployment::compilerRunTimeLibs(Platform platform, bool isDebug, uns
         vcRedistDirName.append(QStringLiteral("redist"));
         QDir vcRedistDir(vcRedistDirName);
         if (!vcRedistDir.exists()) {
-            std::wcerr << "Warning: Cannot find Visual Studio redist directory, "
+            errorStream() << "Warning: Cannot find Visual Studio redist directory, "
                        << QDir::toNativeSeparators(vcRedistDirName).toStdWString() << ".\n";
             break;
         }
@@ -646,7 +1207,7 @@ QStringList Deployment::compilerRunTimeLibs(Platform platform, bool isDebug, uns
             }
         }
         if (redistFiles.isEmpty()) {
-            std::wcerr << "Warning: Cannot find Visual Studio " << (isDebug ? "debug" : "release")
+            errorStream() << "Warning: Cannot find Visual Studio " << (isDebug ? "debug" : "release")
                        << " redistributable files in " << QDir::toNativeSeparators(vcRedistDirName).toStdWString() << ".\n";
             break;
         }
@@ -658,8 +1219,13 @@ QStringList Deployment::compilerRunTimeLibs(Platform platform, bool isDebug, uns
     return result;
 }
 
-Deployment::Deployment(const Options &options, const QMap<QString, QString> &qmakeVariables) :
-    m_options(options), m_qmakeVariables(qmakeVariables)
+Deployment::Deployment(const Options &options, const QMap<QString, QString> &qmakeVariables,
+                       DeploymentCache *cache) :
+    m_options(options), m_qmakeVariables(qmakeVariables), m_ownCache(cache ? 0 : new DeploymentCache),
+    m_cache(cache ? cache : m_ownCache.data())
+{}
+
+Deployment::~Deployment()
 {}
 
 DeployResult Deployment::deploy(const Options &options, QString *errorMessage)
@@ -673,27 +1239,19 @@ DeployResult Deployment::deploy(const Options &options, QString *errorMessage)
     const int version = qtVersion(m_qmakeVariables);
     Q_UNUSED(version)
 
-    if (optVerboseLevel > 1)
-        std::wcout << "Qt binaries in " << QDir::toNativeSeparators(qtBinDir) << '\n';
+    if (verboseLevel() > 1)
+        logStream() << "Qt binaries in " << QDir::toNativeSeparators(qtBinDir) << '\n';
 
+    reportProgress(QStringLiteral("Analyzing binaries"));
+    PhaseTimer phaseTimer(DependencyPhase);
     QStringList dependentQtLibs;
     bool detectedDebug;
     unsigned wordSize;
     int directDependencyCount = 0;
-    if (!findDependentQtLibraries(libraryLocation, options.binaries.first(), options.platform, errorMessage, &dependentQtLibs, &wordSize,
-                                  &detectedDebug, &directDependencyCount)) {
+    if (!m_cache->findDependentQtLibraries(libraryLocation, options.binaries.first(), options.platform, errorMessage, &dependentQtLibs, &wordSize,
+                                           &detectedDebug, &directDependencyCount)) {
         return result;
     }
-    for (int b = 1; b < options.binaries.size(); ++b) {
-        if (!findDependentQtLibraries(libraryLocation, options.binaries.at(b), options.platform, errorMessage, &dependentQtLibs,
-                                      Q_NULLPTR, Q_NULLPTR, Q_NULLPTR)) {
-            return result;
-        }
-    }
-
-    const bool isDebug = options.debugDetection == Options::DebugDetectionAuto ? detectedDebug: options.debugDetection == Options::DebugDetectionForceDebug;
-    const DebugMatchMode debugMatchMode = options.debugMatchAll
-            ? MatchDebugOrRelease : (isDebug ? MatchDebug : MatchRelease);
 
     // Determine application type, check Quick2 is used by looking at the
     // direct dependencies (do not be fooled by QtWebKit depending on it).
@@ -709,13 +1267,41 @@ DeployResult Deployment::deploy(const Options &options, QString *errorMessage)
             && ((result.directlyUsedQtLibraries & (QtQmlModule | QtQuickModule | Qt3DQuickModule))
                 || (options.additionalLibraries & QtQmlModule));
 
-    if (optVerboseLevel) {
-        std::wcout << QDir::toNativeSeparators(options.binaries.first()) << ' '
+    // Start an external scan of the QML directories now so that it runs while the
+    // remaining binaries are analyzed.
+    QStringList qmlDirectories;
+    PendingQmlImportScan pendingQmlScan;
+    if (options.quickImports && usesQml2) {
+        phaseTimer.setPhase(QmlScanPhase);
+        qmlDirectories = options.qmlDirectories;
+        if (qmlDirectories.isEmpty()) {
+            const QString qmlDirectory = findQmlDirectory(options.platform, options.directory);
+            if (!qmlDirectory.isEmpty())
+                qmlDirectories.append(qmlDirectory);
+        }
+        pendingQmlScan = startQmlImportScanner(qmlDirectories, m_qmakeVariables.value(QStringLiteral("QT_INSTALL_QML")),
+                                               options, m_cache->processPool());
+        phaseTimer.setPhase(DependencyPhase);
+    }
+
+    for (int b = 1; b < options.binaries.size(); ++b) {
+        if (!m_cache->findDependentQtLibraries(libraryLocation, options.binaries.at(b), options.platform, errorMessage, &dependentQtLibs,
+                                               Q_NULLPTR, Q_NULLPTR, Q_NULLPTR)) {
+            return result;
+        }
+    }
+
+    const bool isDebug = options.debugDetection == Options::DebugDetectionAuto ? detectedDebug: options.debugDetection == Options::DebugDetectionForceDebug;
+    const DebugMatchMode debugMatchMode = options.debugMatchAll
+            ? MatchDebugOrRelease : (isDebug ? MatchDebug : MatchRelease);
+
+    if (verboseLevel()) {
+        logStream() << QDir::toNativeSeparators(options.binaries.first()) << ' '
                    << wordSize << " bit, " << (isDebug ? "debug" : "release")
                    << " executable";
         if (usesQml2)
-            std::wcout << " [QML]";
-        std::wcout << '\n';
+            logStream() << " [QML]";
+        logStream() << '\n';
     }
 
     if (dependentQtLibs.isEmpty()) {
@@ -729,7 +1315,7 @@ DeployResult Deployment::deploy(const Options &options, QString *errorMessage)
         const QStringList qtLibs = dependentQtLibs.filter(QStringLiteral("Qt5Core"), Qt::CaseInsensitive)
                 + dependentQtLibs.filter(QStringLiteral("Qt5WebKit"), Qt::CaseInsensitive);
         foreach (const QString &qtLib, qtLibs) {
-            QStringList icuLibs = findDependentLibraries(qtLib, options.platform, errorMessage).filter(QStringLiteral("ICU"), Qt::CaseInsensitive);
+            QStringList icuLibs = findDependentLibraries(m_cache, qtLib, options.platform, errorMessage).filter(QStringLiteral("ICU"), Qt::CaseInsensitive);
             if (!icuLibs.isEmpty()) {
                 // Find out the ICU version to add the data library icudtXX.dll, which does not show
                 // as a dependency.
@@ -738,8 +1324,8 @@ DeployResult Deployment::deploy(const Options &options, QString *errorMessage)
                 const int index = numberExpression.indexIn(icuLibs.front());
                 if (index >= 0)  {
                     const QString icuVersion = icuLibs.front().mid(index, numberExpression.matchedLength());
-                    if (optVerboseLevel > 1)
-                        std::wcout << "Adding ICU version " << icuVersion << '\n';
+                    if (verboseLevel() > 1)
+                        logStream() << "Adding ICU version " << icuVersion << '\n';
                     icuLibs.push_back(QStringLiteral("icudt") + icuVersion + QLatin1String(windowsSharedLibrarySuffix));
                 }
                 foreach (const QString &icuLib, icuLibs) {
@@ -756,43 +1342,44 @@ DeployResult Deployment::deploy(const Options &options, QString *errorMessage)
     } // Windows
 
     // Scan Quick2 imports
+    reportProgress(QStringLiteral("Scanning QML imports"));
+    phaseTimer.setPhase(QmlScanPhase);
     QmlImportScanResult qmlScanResult;
+    QSet<QString> reachableQmlFiles;
     if (options.quickImports && usesQml2) {
-        QStringList qmlDirectories = options.qmlDirectories;
-        if (qmlDirectories.isEmpty()) {
-            const QString qmlDirectory = findQmlDirectory(options.platform, options.directory);
-            if (!qmlDirectory.isEmpty())
-                qmlDirectories.append(qmlDirectory);
-        }
-        foreach (const QString &qmlDirectory, qmlDirectories) {
-            if (optVerboseLevel >= 1)
-                std::wcout << "Scanning " << QDir::toNativeSeparators(qmlDirectory) << ":\n";
-            const QmlImportScanResult scanResult = runQmlImportScanner(qmlDirectory, m_qmakeVariables.value(QStringLiteral("QT_INSTALL_QML")), options.platform,
-                                                                       debugMatchMode, errorMessage);
-            if (!scanResult.ok)
+        if (!qmlDirectories.isEmpty()) {
+            // Scan all roots in one pass and analyze the unique plugins once.
+            if (verboseLevel() >= 1)
+                logStream() << "Scanning " << QDir::toNativeSeparators(qmlDirectories.join(QStringLiteral(", "))) << ":\n";
+            qmlScanResult = runQmlImportScanner(qmlDirectories, m_qmakeVariables.value(QStringLiteral("QT_INSTALL_QML")), options,
+                                                debugMatchMode, m_cache->qtIndex(), pendingQmlScan, errorMessage);
+            if (!qmlScanResult.ok)
                 return result;
-            qmlScanResult.append(scanResult);
+            if (options.pruneQml)
+                reachableQmlFiles = findReachableQmlFiles(qmlDirectories, m_qmakeVariables.value(QStringLiteral("QT_INSTALL_QML")));
             // Additional dependencies of QML plugins.
             foreach (const QString &plugin, qmlScanResult.plugins) {
-                if (!findDependentQtLibraries(libraryLocation, plugin, options.platform, errorMessage, &dependentQtLibs, &wordSize, &detectedDebug))
+                if (!m_cache->findDependentQtLibraries(libraryLocation, plugin, options.platform, errorMessage, &dependentQtLibs, &wordSize, &detectedDebug))
                     return result;
             }
-            if (optVerboseLevel >= 1) {
-                std::wcout << "QML imports:\n";
+            if (verboseLevel() >= 1) {
+                logStream() << "QML imports:\n";
                 foreach (const QmlImportScanResult::Module &mod, qmlScanResult.modules) {
-                    std::wcout << "  '" << mod.name << "' "
+                    logStream() << "  '" << mod.name << "' "
                                << QDir::toNativeSeparators(mod.sourcePath) << '\n';
                 }
-                if (optVerboseLevel >= 2) {
-                    std::wcout << "QML plugins:\n";
+                if (verboseLevel() >= 2) {
+                    logStream() << "QML plugins:\n";
                     foreach (const QString &p, qmlScanResult.plugins)
-                        std::wcout << "  " << QDir::toNativeSeparators(p) << '\n';
+                        logStream() << "  " << QDir::toNativeSeparators(p) << '\n';
                 }
             }
         }
     }
 
     // Find the plugins and check whether ANGLE, D3D are required on the platform plugin.
+    reportProgress(QStringLiteral("Finding plugins"));
+    phaseTimer.setPhase(PluginDiscoveryPhase);
     QString platformPlugin;
     // Sort apart Qt 5 libraries in the ones that are represented by the
     // QtModule enumeration (and thus controlled by flags) and others.
@@ -806,7 +1393,7 @@ DeployResult Deployment::deploy(const Options &options, QString *errorMessage)
     result.deployedQtLibraries = (result.usedQtLibraries | options.additionalLibraries) & ~options.disabledLibraries;
 
     const QStringList plugins =
-            findQtPlugins(&result.deployedQtLibraries,
+            findQtPlugins(m_cache, &result.deployedQtLibraries,
                           // For non-QML applications, disable QML to prevent it from being pulled in by the qtaccessiblequick plugin.
                           options.disabledLibraries | (usesQml2 ? 0 : (QtQmlModule | QtQuickModule)),
                           m_qmakeVariables.value(QStringLiteral("QT_INSTALL_PLUGINS")), libraryLocation,
@@ -823,14 +1410,14 @@ DeployResult Deployment::deploy(const Options &options, QString *errorMessage)
         }
     }
 
-    if (optVerboseLevel >= 1) {
-        std::wcout << "Direct dependencies: " << formatQtModules(result.directlyUsedQtLibraries).constData()
+    if (verboseLevel() >= 1) {
+        logStream() << "Direct dependencies: " << formatQtModules(result.directlyUsedQtLibraries).constData()
                    << "\nAll dependencies   : " << formatQtModules(result.usedQtLibraries).constData()
                    << "\nTo be deployed     : " << formatQtModules(result.deployedQtLibraries).constData() << '\n';
     }
 
-    if (optVerboseLevel > 1)
-        std::wcout << "Plugins: " << plugins.join(QLatin1Char(',')) << '\n';
+    if (verboseLevel() > 1)
+        logStream() << "Plugins: " << plugins.join(QLatin1Char(',')) << '\n';
 
     if ((result.deployedQtLibraries & QtGuiModule) && platformPlugin.isEmpty()) {
         *errorMessage =QStringLiteral("Unable to find the platform plugin.");
@@ -844,7 +1431,7 @@ DeployResult Deployment::deploy(const Options &options, QString *errorMessage)
         if (isDebug)
             libGlesName += QLatin1Char('d');
         libGlesName += QLatin1String(windowsSharedLibrarySuffix);
-        const QStringList guiLibraries = findDependentLibraries(qtGuiLibrary, options.platform, errorMessage);
+        const QStringList guiLibraries = findDependentLibraries(m_cache, qtGuiLibrary, options.platform, errorMessage);
         const bool dependsOnAngle = !guiLibraries.filter(libGlesName, Qt::CaseInsensitive).isEmpty();
         const bool dependsOnOpenGl = !guiLibraries.filter(QStringLiteral("opengl32"), Qt::CaseInsensitive).isEmpty();
         if (options.angleDetection != Options::AngleDetectionForceOff
@@ -860,7 +1447,7 @@ DeployResult Deployment::deploy(const Options &options, QString *errorMessage)
             if (options.systemD3dCompiler && !options.isWinRtOrWinPhone()) {
                 const QString d3dCompiler = findD3dCompiler(options.platform, qtBinDir, wordSize);
                 if (d3dCompiler.isEmpty()) {
-                    std::wcerr << "Warning: Cannot find any version of the d3dcompiler DLL.\n";
+                    errorStream() << "Warning: Cannot find any version of the d3dcompiler DLL.\n";
                 } else {
                     deployedQtLibraries.push_back(d3dCompiler);
                 }
@@ -874,71 +1461,116 @@ DeployResult Deployment::deploy(const Options &options, QString *errorMessage)
     } // Windows
 
     // Update libraries
+    reportProgress(QStringLiteral("Deploying libraries and plugins"));
+    phaseTimer.setPhase(LibraryCopyPhase);
     if (options.libraries) {
         const QString targetPath = options.libraryDirectory.isEmpty() ?
                     options.directory : options.libraryDirectory;
         QStringList libraries = deployedQtLibraries;
         if (options.compilerRunTime)
             libraries.append(compilerRunTimeLibs(options.platform, isDebug, wordSize));
-        foreach (const QString &qtLib, libraries) {
-            if (!updateFile(qtLib, targetPath, options.updateFileFlags, options.json, errorMessage))
-                return result;
-        }
-
-        if (!options.isWinRtOrWinPhone()) {
-            const QString qt5CoreName = QFileInfo(libraryPath(libraryLocation, "Qt5Core", qtLibInfix,
-                                                              options.platform, isDebug)).fileName();
+        const QString qt5CoreName = QFileInfo(libraryPath(libraryLocation, "Qt5Core", qtLibInfix,
+                                                          options.platform, isDebug)).fileName();
+        const bool patchCore = !options.isWinRtOrWinPhone();
+        if (!options.sharedRuntimeDirectory.isEmpty()) {
+            foreach (const QString &qtLib, libraries) {
+                const bool patch = patchCore && QFileInfo(qtLib).fileName() == qt5CoreName;
+                if (!deploySharedRuntimeFile(options, qtLib, options.sharedRuntimeDirectory, targetPath,
+                                             patch, errorMessage)) {
+                    return result;
+                }
+            }
+        } else {
+            foreach (const QString &qtLib, libraries) {
+                if (!updateFile(qtLib, targetPath, options.updateFileFlags, options.json, options.store, errorMessage))
+                    return result;
+            }
 
-            if (!patchQtCore(targetPath + QLatin1Char('/') + qt5CoreName, errorMessage))
+            if (patchCore && !patchQtCore(targetPath + QLatin1Char('/') + qt5CoreName, errorMessage))
                 return result;
         }
     } // optLibraries
 
     // Update plugins
-    if (options.plugins) {
+    phaseTimer.setPhase(PluginCopyPhase);
+    if (options.plugins && !options.sharedRuntimeDirectory.isEmpty()) {
+        // Only the shared runtime contains the plugins in qt.conf mode.
+        const bool linkPlugins = options.sharedRuntimeMode == Options::SharedRuntimeHardLinks;
+        foreach (const QString &plugin, plugins) {
+            const QString targetDirName = plugin.section(slash, -2, -2);
+            const QString targetPath = options.directory + slash + targetDirName;
+            if (linkPlugins && !createDirectory(targetPath, errorMessage))
+                return result;
+            if (!deploySharedRuntimeFile(options, plugin, options.sharedRuntimeDirectory + slash + targetDirName,
+                                         linkPlugins ? targetPath : QString(), false, errorMessage)) {
+                return result;
+            }
+        }
+        if (!linkPlugins && !writeSharedRuntimeQtConf(options.directory, options.sharedRuntimeDirectory,
+                                                      options.updateFileFlags, errorMessage)) {
+            return result;
+        }
+    } else if (options.plugins) {
         QDir dir(options.directory);
         foreach (const QString &plugin, plugins) {
             const QString targetDirName = plugin.section(slash, -2, -2);
             if (!dir.exists(targetDirName)) {
-                if (optVerboseLevel)
-                    std::wcout << "Creating directory " << targetDirName << ".\n";
+                if (verboseLevel())
+                    logStream() << "Creating directory " << targetDirName << ".\n";
                 if (!(options.updateFileFlags & SkipUpdateFile) && !dir.mkdir(targetDirName)) {
-                    std::wcerr << "Cannot create " << targetDirName << ".\n";
+                    errorStream() << "Cannot create " << targetDirName << ".\n";
                     *errorMessage = QStringLiteral("Cannot create ") + targetDirName +  QLatin1Char('.');
                     return result;
                 }
             }
             const QString targetPath = options.directory + slash + targetDirName;
-            if (!updateFile(plugin, targetPath, options.updateFileFlags, options.json, errorMessage))
+            if (!updateFile(plugin, targetPath, options.updateFileFlags, options.json, options.store, errorMessage))
                 return result;
         }
     } // optPlugins
 
     // Update Quick imports
+    reportProgress(QStringLiteral("Deploying QML imports"));
+    phaseTimer.setPhase(QmlCopyPhase);
     const bool usesQuick1 = result.deployedQtLibraries & QtDeclarativeModule;
     // Do not be fooled by QtWebKit.dll depending on Quick into always installing Quick imports
     // for WebKit1-applications. Check direct dependency only.
     if (options.quickImports && (usesQuick1 || usesQml2)) {
         const QmlDirectoryFileEntryFunction qmlFileEntryFunction(options.platform, debugMatchMode);
         if (usesQml2) {
+            QStringList qmlSourceFiles;
+            QStringList *qmlCacheSources = options.qmlCache ? &qmlSourceFiles : 0;
+            const QSet<QString> *reachableFiles = options.pruneQml ? &reachableQmlFiles : 0;
+            const QmlDirectoryFileEntryFunction qml2FileEntryFunction(options.platform, debugMatchMode, false, reachableFiles);
             foreach (const QmlImportScanResult::Module &module, qmlScanResult.modules) {
                 const QString installPath = module.installPath(options.directory);
-                if (optVerboseLevel > 1)
-                    std::wcout << "Installing: '" << module.name
+                if (verboseLevel() > 1)
+                    logStream() << "Installing: '" << module.name
                                << "' from " << module.sourcePath << " to "
                                << QDir::toNativeSeparators(installPath) << '\n';
                 if (installPath != options.directory && !createDirectory(installPath, errorMessage))
                     return result;
                 const bool updateResult = module.sourcePath.contains(QLatin1String("QtQuick/Controls"))
                         || module.sourcePath.contains(QLatin1String("QtQuick/Dialogs")) ?
-                            updateFile(module.sourcePath, QmlDirectoryFileEntryFunction(options.platform, debugMatchMode, true),
-                                       installPath, options.updateFileFlags | RemoveEmptyQmlDirectories,
-                                       options.json, errorMessage) :
-                            updateFile(module.sourcePath, qmlFileEntryFunction, installPath, options.updateFileFlags,
-                                       options.json, errorMessage);
+                            updateQmlImportTree(module.sourcePath, QmlDirectoryFileEntryFunction(options.platform, debugMatchMode, true, reachableFiles),
+                                                installPath, options.updateFileFlags | RemoveEmptyQmlDirectories,
+                                                options.jobs, options.json, options.store, qmlCacheSources, errorMessage) :
+                            updateQmlImportTree(module.sourcePath, qml2FileEntryFunction, installPath, options.updateFileFlags,
+                                                options.jobs, options.json, options.store, qmlCacheSources, errorMessage);
                 if (!updateResult)
                     return result;
             }
+            if (options.qmlCache && !qmlSourceFiles.isEmpty()) {
+                const QString qmlCacheGenerator = findQmlCacheGenerator(qtBinDir);
+                if (qmlCacheGenerator.isEmpty()) {
+                    if (verboseLevel())
+                        logStream() << "Skipping QML cache generation, qmlcachegen not found in "
+                                   << QDir::toNativeSeparators(qtBinDir) << ".\n";
+                } else {
+                    generateQmlCache(qmlCacheGenerator, qmlSourceFiles, m_cache->processPool(),
+                                     options.updateFileFlags, options.json);
+                }
+            }
         } // Quick 2
         if (usesQuick1) {
             const QString quick1ImportPath = m_qmakeVariables.value(QStringLiteral("QT_INSTALL_IMPORTS"));
@@ -947,17 +1579,20 @@ DeployResult Deployment::deploy(const Options &options, QString *errorMessage)
                 quick1Imports << QStringLiteral("QtWebKit");
             foreach (const QString &quick1Import, quick1Imports) {
                 const QString sourceFile = quick1ImportPath + slash + quick1Import;
-                if (!updateFile(sourceFile, qmlFileEntryFunction, options.directory, options.updateFileFlags, options.json, errorMessage))
+                if (!updateQmlImportTree(sourceFile, qmlFileEntryFunction, options.directory, options.updateFileFlags,
+                                         options.jobs, options.json, options.store, 0, errorMessage))
                     return result;
             }
         } // Quick 1
     } // optQuickImports
 
     if (options.translations) {
+        reportProgress(QStringLiteral("Deploying translations"));
+        phaseTimer.setPhase(TranslationPhase);
         if (!createDirectory(options.translationsDirectory, errorMessage)
                 || !deployTranslations(m_qmakeVariables.value(QStringLiteral("QT_INSTALL_TRANSLATIONS")),
                                        result.deployedQtLibraries, options.translationsDirectory,
-                                       options.updateFileFlags, errorMessage)) {
+                                       options.languages, options.updateFileFlags, errorMessage)) {
             return result;
         }
     }
@@ -972,7 +1607,7 @@ bool Deployment::deployWebProcess(const char *binaryName, QString *errorMessage)
     const QString webProcess = webProcessBinary(binaryName, m_options.platform);
     const QString webProcessSource = m_qmakeVariables.value(QStringLiteral("QT_INSTALL_LIBEXECS")) +
             QLatin1Char('/') + webProcess;
-    if (!updateFile(webProcessSource, m_options.directory, m_options.updateFileFlags, m_options.json, errorMessage))
+    if (!updateFile(webProcessSource, m_options.directory, m_options.updateFileFlags, m_options.json, m_options.store, errorMessage))
         return false;
 
     Options options(m_options);
@@ -989,30 +1624,101 @@ bool Deployment::deployWebEngine(QString *errorMessage)
                                              "qtwebengine_resources_100p.pak",
                                              "qtwebengine_resources_200p.pak"};
 
-    std::wcout << "Deploying: " << Options::webEngineProcessC << "...\n";
+    logStream() << "Deploying: " << Options::webEngineProcessC << "...\n";
     if (!deployWebProcess(Options::webEngineProcessC, errorMessage)) {
-        std::wcerr << errorMessage << '\n';
+        errorStream() << errorMessage << '\n';
         return false;
     }
     const QString installData = m_qmakeVariables.value(QStringLiteral("QT_INSTALL_DATA")) + QLatin1Char('/');
     for (size_t i = 0; i < sizeof(installDataFiles)/sizeof(installDataFiles[0]); ++i) {
         if (!updateFile(installData + QLatin1String(installDataFiles[i]),
-                        m_options.directory, m_options.updateFileFlags, m_options.json, errorMessage)) {
-            std::wcerr << errorMessage << '\n';
+                        m_options.directory, m_options.updateFileFlags, m_options.json, m_options.store, errorMessage)) {
+            errorStream() << errorMessage << '\n';
             return false;
         }
     }
     const QFileInfo translations(m_qmakeVariables.value(QStringLiteral("QT_INSTALL_TRANSLATIONS"))
                                  + QStringLiteral("/qtwebengine_locales"));
     if (!translations.isDir()) {
-        std::wcerr << "Warning: Cannot find the translation files of the QtWebEngine module at "
-                   << QDir::toNativeSeparators(translations.absoluteFilePath()) << '.';
+        errorStream() << "Warning: Cannot find the translation files of the QtWebEngine module at "
+                   << QDir::toNativeSeparators(translations.absoluteFilePath()) << ".\n";
         return true;
     }
     // Missing translations may cause crashes, ignore --no-translations.
     return createDirectory(m_options.translationsDirectory, errorMessage)
             && updateFile(translations.absoluteFilePath(), m_options.translationsDirectory,
-                          m_options.updateFileFlags, m_options.json, errorMessage);
+                          m_options.updateFileFlags, m_options.json, m_options.store, errorMessage);
+}
+
+// Register the storage locations the I/O calls are accounted to.
+static void addIoRoots(IoStatistics *ioStatistics, const Options &options,
+                       const QMap<QString, QString> &qmakeVariables)
+{
+    static const char *qtDirectoryVariables[] = {
+        "QT_INSTALL_PREFIX", "QT_INSTALL_BINS", "QT_INSTALL_LIBS", "QT_INSTALL_PLUGINS",
+        "QT_INSTALL_QML", "QT_INSTALL_IMPORTS", "QT_INSTALL_TRANSLATIONS"
+    };
+    for (size_t i = 0; i < sizeof(qtDirectoryVariables) / sizeof(qtDirectoryVariables[0]); ++i)
+        ioStatistics->addRoot(QtInstallationRoot, qmakeVariables.value(QLatin1String(qtDirectoryVariables[i])));
+    foreach (const QString &binary, options.binaries)
+        ioStatistics->addRoot(ApplicationRoot, QFileInfo(binary).absolutePath());
+    foreach (const QString &qmlDirectory, options.qmlDirectories)
+        ioStatistics->addRoot(ApplicationRoot, qmlDirectory);
+    ioStatistics->addRoot(TargetRoot, options.directory);
+    ioStatistics->addRoot(TargetRoot, options.libraryDirectory);
+    ioStatistics->addRoot(TargetRoot, options.translationsDirectory);
+    ioStatistics->addRoot(TargetRoot, options.sharedRuntimeDirectory);
+}
+
+DeployResult deployApplication(const Options &optionsIn, const QMap<QString, QString> &qmakeVariables,
+                               DeploymentCache *cache, QString *errorMessage)
+{
+    Options options(optionsIn);
+    DeployResult result;
+    LogContext logContext(options.verboseLevel, currentLogContext().sink, options.statistics, options.trace);
+    logContext.ioStatistics = options.ioStatistics;
+    logContext.memoryStatistics = options.memoryStatistics;
+    const LogScope logScope(logContext);
+    if (options.ioStatistics)
+        addIoRoots(options.ioStatistics, options, qmakeVariables);
+
+    // Create directories
+    if (!createDirectory(options.directory, errorMessage))
+        return result;
+    if (!options.libraryDirectory.isEmpty() && options.libraryDirectory != options.directory
+        && !createDirectory(options.libraryDirectory, errorMessage)) {
+        return result;
+    }
+    if (!options.sharedRuntimeDirectory.isEmpty() && !createDirectory(options.sharedRuntimeDirectory, errorMessage))
+        return result;
+
+    if (options.webKit2 != Options::WebKit2DeploymentAuto)
+        options.additionalLibraries |= QtWebKitModule;
+
+    Deployment worker(options, qmakeVariables, cache);
+    result = worker.deploy(options, errorMessage);
+    if (!result)
+        return result;
+
+    if ((options.webKit2 != Options::WebKit2DeploymentForceOff)
+        && (options.webKit2 == Options::WebKit2DeploymentForceOn
+            || ((result.deployedQtLibraries & QtWebKitModule)
+                && (result.directlyUsedQtLibraries & QtQuickModule)))) {
+        if (verboseLevel())
+            logStream() << "Deploying: " << Options::webKitProcessC << "...\n";
+        if (!worker.deployWebProcess(Options::webKitProcessC, errorMessage)) {
+            result.success = false;
+            return result;
+        }
+    }
+
+    if (result.deployedQtLibraries & QtWebEngineModule) {
+        if (!worker.deployWebEngine(errorMessage)) {
+            result.success = false;
+            return result;
+        }
+    }
+    return result;
 }
 
 QT_END_NAMESPACE
@@ -69,10 +69,15 @@
 #include "types.h"
 #include "options.h"
 
+#include <QtCore/QScopedPointer>
+
 class JsonOutput;
+class DeploymentCache;
 
 QT_BEGIN_NAMESPACE
 
+class DeploymentStore;
+
 struct DeployResult
 {
     DeployResult() : success(false), directlyUsedQtLibraries(0), usedQtLibraries(0), deployedQtLibraries(0) {}
@@ -82,12 +87,15 @@ struct DeployResult
     quint64 directlyUsedQtLibraries;
     quint64 usedQtLibraries;
     quint64 deployedQtLibraries;
+    QList<QPair<QString, QString> > files; // Source file, target directory (Deployer only).
 };
 
 class Deployment
 {
 public:
-    Deployment(const Options &options, const QMap<QString, QString> &qmakeVariables);
+    Deployment(const Options &options, const QMap<QString, QString> &qmakeVariables,
+               DeploymentCache *cache = 0);
+    ~Deployment();
 
     DeployResult deploy(const Options &options, QString *errorMessage);
     bool deployWebProcess(const char *binaryName, QString *errorMessage);
@@ -96,13 +104,34 @@ public:
 private:
     QStringList compilerRunTimeLibs(Platform platform, bool isDebug, unsigned wordSize);
     bool deployTranslations(const QString &sourcePath, quint64 usedQtModules,
-                            const QString &target, unsigned flags, QString *errorMessage);
+                            const QString &target, const QStringList &languages,
+                            unsigned flags, QString *errorMessage);
+    bool deploySharedRuntimeFile(const Options &options, const QString &sourceFileName,
+                                 const QString &sharedDirectory, const QString &targetDirectory,
+                                 bool patch, QString *errorMessage);
 
 private:
+    Q_DISABLE_COPY(Deployment)
+
     Options m_options;
     QMap<QString, QString> m_qmakeVariables;
+    QScopedPointer<DeploymentCache> m_ownCache;
+    DeploymentCache *m_cache;
 };
 
+// Update a file or directory tree in the target directory (copying or placing
+// by the store) unless it is up to date.
+bool updateFile(const QString &sourceFileName, const QString &targetDirectory,
+                unsigned flags, JsonOutput *json, DeploymentStore *store, QString *errorMessage);
+// Link a file of the shared runtime directory into an application directory.
+bool linkSharedFile(const QString &sharedFileName, const QString &targetDirectory,
+                    unsigned flags, JsonOutput *json, QString *errorMessage);
+
+// Deploy an application including the WebKit2/WebEngine processes, creating the
+// target directories.
+DeployResult deployApplication(const Options &options, const QMap<QString, QString> &qmakeVariables,
+                               DeploymentCache *cache, QString *errorMessage);
+
 QT_END_NAMESPACE
 
 #endif // DEPLOYMENT_H
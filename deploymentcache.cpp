@@ -0,0 +1,169 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "deploymentcache.h"
+#include "utils.h"
+#include "qtmodules.h"
+#include "tracing.h"
+
+#include <QtCore/QMutexLocker>
+
+QT_BEGIN_NAMESPACE
+
+// The lookups are done under the lock, the (potentially expensive) computation
+// outside of it. Two threads may compute the same entry concurrently, which is
+// harmless since the results are identical.
+
+bool DeploymentCache::readExecutable(const QString &executableFileName, Platform platform,
+                                     QString *errorMessage, QStringList *dependentLibraries,
+                                     unsigned *wordSize, bool *isDebug)
+{
+    // readElfExecutable() fails for binaries without dependencies when they are
+    // requested, so the key needs to reflect that.
+    const QString key = executableFileName + QLatin1Char(dependentLibraries ? 'D' : 'N')
+            + QString::number(platform);
+    ExecutableInfo info;
+    bool cached = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        const QHash<QString, ExecutableInfo>::const_iterator it = m_executables.constFind(key);
+        if (it != m_executables.constEnd()) {
+            info = it.value();
+            cached = true;
+        }
+    }
+    if (!cached) {
+        info.success = QT_PREPEND_NAMESPACE(readExecutable)(executableFileName, platform, &info.errorMessage,
+                                                            dependentLibraries ? &info.dependentLibraries : 0,
+                                                            &info.wordSize, &info.isDebug);
+        QMutexLocker locker(&m_mutex);
+        m_executables.insert(key, info);
+    }
+    if (!info.success) {
+        *errorMessage = info.errorMessage;
+        return false;
+    }
+    if (dependentLibraries)
+        *dependentLibraries = info.dependentLibraries;
+    if (wordSize)
+        *wordSize = info.wordSize;
+    if (isDebug)
+        *isDebug = info.isDebug;
+    return true;
+}
+
+// Helper for recursively finding all dependent Qt libraries.
+bool DeploymentCache::findDependentQtLibraries(const QString &qtBinDir, const QString &binary,
+                                               Platform platform, QString *errorMessage, QStringList *result,
+                                               unsigned *wordSize, bool *isDebug,
+                                               int *directDependencyCount, int recursionDepth)
+{
+    QStringList dependentLibs;
+    if (directDependencyCount)
+        *directDependencyCount = 0;
+    if (!readExecutable(binary, platform, errorMessage, &dependentLibs, wordSize, isDebug)) {
+        errorMessage->prepend(QLatin1String("Unable to find dependent libraries of ") +
+                              QDir::toNativeSeparators(binary) + QLatin1String(" :"));
+        return false;
+    }
+    // Filter out the Qt libraries. Note that depends.exe finds libs from optDirectory if we
+    // are run the 2nd time (updating). We want to check against the Qt bin dir libraries
+    const int start = result->size();
+    foreach (const QString &lib, dependentLibs) {
+        if (isQtModule(lib)) {
+            const QString path = normalizeFileName(qtBinDir + QLatin1Char('/') + QFileInfo(lib).fileName());
+            if (!result->contains(path))
+                result->append(path);
+        }
+    }
+    const int end = result->size();
+    if (directDependencyCount)
+        *directDependencyCount = end - start;
+    // Recurse
+    for (int i = start; i < end; ++i)
+        if (!findDependentQtLibraries(qtBinDir, result->at(i), platform, errorMessage, result, 0, 0, 0, recursionDepth + 1))
+            return false;
+    return true;
+}
+
+QStringList DeploymentCache::findSharedLibraries(const QDir &directory, Platform platform,
+                                                 DebugMatchMode debugMatchMode,
+                                                 const QString &prefix)
+{
+    const QString key = directory.absolutePath() + QLatin1Char('|') + QString::number(platform)
+            + QLatin1Char('|') + QString::number(debugMatchMode) + QLatin1Char('|') + prefix;
+    {
+        QMutexLocker locker(&m_mutex);
+        const QHash<QString, QStringList>::const_iterator it = m_directoryListings.constFind(key);
+        if (it != m_directoryListings.constEnd())
+            return it.value();
+    }
+    const TraceSpan span("findSharedLibraries", "directory", "directory", directory.absolutePath());
+    const QStringList result = QT_PREPEND_NAMESPACE(findSharedLibraries)(directory, platform, debugMatchMode, prefix);
+    QMutexLocker locker(&m_mutex);
+    m_directoryListings.insert(key, result);
+    return result;
+}
+
+QStringList DeploymentCache::subDirectories(const QDir &directory)
+{
+    const QString key = directory.absolutePath() + QStringLiteral("|dirs");
+    {
+        QMutexLocker locker(&m_mutex);
+        const QHash<QString, QStringList>::const_iterator it = m_directoryListings.constFind(key);
+        if (it != m_directoryListings.constEnd())
+            return it.value();
+    }
+    const TraceSpan span("subDirectories", "directory", "directory", directory.absolutePath());
+    const QStringList result = directory.entryList(QStringList(QLatin1String("*")), QDir::Dirs | QDir::NoDotAndDotDot);
+    QMutexLocker locker(&m_mutex);
+    m_directoryListings.insert(key, result);
+    return result;
+}
+
+// Translation catalogs ("qt_<prefix>.qm") only depend on the source directory,
+// the module mask and the language, so a catalog built for one application can
+// be copied for the next one.
+QString DeploymentCache::translationCatalog(const QString &key) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_translationCatalogs.value(key);
+}
+
+void DeploymentCache::addTranslationCatalog(const QString &key, const QString &fileName)
+{
+    QMutexLocker locker(&m_mutex);
+    m_translationCatalogs.insert(key, fileName);
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,111 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef DEPLOYMENTCACHE_H
+#define DEPLOYMENTCACHE_H
+
+#include "types.h"
+#include "processpool.h"
+
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QSet>
+
+QT_BEGIN_NAMESPACE
+
+class QtInstallationIndex;
+
+// Thread-safe cache of the information gathered about the Qt installation while
+// deploying: dependencies of binaries, listings of the plugin directories and the
+// generated translation catalogs. A single instance can be shared by several
+// Deployment instances running in parallel (batch mode).
+class DeploymentCache
+{
+public:
+    DeploymentCache() : m_qtIndex(0) {}
+
+    // Optional index of the Qt installation replacing the directory scans.
+    const QtInstallationIndex *qtIndex() const { return m_qtIndex; }
+    void setQtIndex(const QtInstallationIndex *qtIndex) { m_qtIndex = qtIndex; }
+
+    // Runs the external tools, bounded by "--jobs" for all deployments.
+    ProcessPool *processPool() { return &m_processPool; }
+
+    bool readExecutable(const QString &executableFileName, Platform platform,
+                        QString *errorMessage, QStringList *dependentLibraries = 0,
+                        unsigned *wordSize = 0, bool *isDebug = 0);
+    bool findDependentQtLibraries(const QString &qtBinDir, const QString &binary, Platform platform,
+                                  QString *errorMessage, QStringList *result,
+                                  unsigned *wordSize = 0, bool *isDebug = 0,
+                                  int *directDependencyCount = 0, int recursionDepth = 0);
+
+    QStringList findSharedLibraries(const QDir &directory, Platform platform,
+                                    DebugMatchMode debugMatchMode,
+                                    const QString &prefix = QString());
+    QStringList subDirectories(const QDir &directory);
+
+    QString translationCatalog(const QString &key) const;
+    void addTranslationCatalog(const QString &key, const QString &fileName);
+
+    // Files of the shared runtime directory are updated once per run. The
+    // functions below must be called with sharedRuntimeMutex() locked.
+    QMutex *sharedRuntimeMutex() { return &m_sharedRuntimeMutex; }
+    bool containsSharedFile(const QString &fileName) const { return m_sharedFiles.contains(fileName); }
+    void addSharedFile(const QString &fileName) { m_sharedFiles.insert(fileName); }
+
+private:
+    Q_DISABLE_COPY(DeploymentCache)
+
+    struct ExecutableInfo {
+        ExecutableInfo() : success(false), wordSize(0), isDebug(false) {}
+
+        bool success;
+        QString errorMessage;
+        QStringList dependentLibraries;
+        unsigned wordSize;
+        bool isDebug;
+    };
+
+    const QtInstallationIndex *m_qtIndex;
+    mutable QMutex m_mutex;
+    QHash<QString, ExecutableInfo> m_executables;
+    QHash<QString, QStringList> m_directoryListings;
+    QHash<QString, QString> m_translationCatalogs;
+    QMutex m_sharedRuntimeMutex;
+    QSet<QString> m_sharedFiles;
+    ProcessPool m_processPool;
+};
+
+QT_END_NAMESPACE
+
+#endif // DEPLOYMENTCACHE_H
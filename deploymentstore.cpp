@@ -0,0 +1,418 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "deploymentstore.h"
+#include "utils.h"
+#include "statistics.h"
+#include "iostats.h"
+
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDirIterator>
+#include <QtCore/QLockFile>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QSaveFile>
+#include <QtCore/QSet>
+#include <QtCore/QTemporaryFile>
+
+#if defined(Q_OS_LINUX)
+#  include <sys/ioctl.h>
+#  include <sys/stat.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <linux/fs.h>
+#endif
+
+QT_BEGIN_NAMESPACE
+
+static const char indexFileC[] = "/index";
+static const char referencesFileC[] = "/references";
+static const char lockFileC[] = "/lock";
+static const char objectsDirectoryC[] = "/objects";
+
+// Objects younger than this are not removed by collectGarbage() since a
+// concurrently running deployment might not have saved its references yet.
+static const qint64 garbageCollectionGracePeriodSecs = 3600;
+
+// Create a copy-on-write clone of a file (btrfs, XFS). Fails on other file systems.
+static bool cloneFile(const QString &source, const QString &target)
+{
+#if defined(Q_OS_LINUX) && defined(FICLONE)
+    const int sourceFd = ::open(QFile::encodeName(source).constData(), O_RDONLY | O_CLOEXEC);
+    if (sourceFd < 0)
+        return false;
+    struct stat sourceStat;
+    if (fstat(sourceFd, &sourceStat)) {
+        close(sourceFd);
+        return false;
+    }
+    const QByteArray encodedTarget = QFile::encodeName(target);
+    // The clone does not share the inode with the object, so it can be writable.
+    const int targetFd = ::open(encodedTarget.constData(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC,
+                                (sourceStat.st_mode & 0777) | S_IWUSR);
+    if (targetFd < 0) {
+        close(sourceFd);
+        return false;
+    }
+    const bool success = ioctl(targetFd, FICLONE, sourceFd) == 0;
+    close(targetFd);
+    close(sourceFd);
+    if (!success)
+        unlink(encodedTarget.constData());
+    return success;
+#else
+    Q_UNUSED(source)
+    Q_UNUSED(target)
+    return false;
+#endif
+}
+
+DeploymentStore::DeploymentStore(const QString &directory) :
+    m_directory(QDir::cleanPath(QFileInfo(directory).absoluteFilePath()))
+{}
+
+QString DeploymentStore::objectFileName(const QString &hash) const
+{
+    return m_directory + QLatin1String(objectsDirectoryC) + QLatin1Char('/')
+        + hash.left(2) + QLatin1Char('/') + hash.mid(2);
+}
+
+// Index lines: "<size>\t<modification time>\t<hash>\t<source file>",
+// reference lines: "<hash>\t<target file>".
+bool DeploymentStore::read(HashIndex *index, References *references, QString *errorMessage) const
+{
+    QFile indexFile(m_directory + QLatin1String(indexFileC));
+    if (indexFile.exists()) {
+        if (!indexFile.open(QIODevice::ReadOnly)) {
+            *errorMessage = QString::fromLatin1("Unable to read %1: %2")
+                            .arg(QDir::toNativeSeparators(indexFile.fileName()), indexFile.errorString());
+            return false;
+        }
+        while (!indexFile.atEnd()) {
+            const QString line = QString::fromUtf8(indexFile.readLine()).trimmed();
+            const QStringList fields = line.split(QLatin1Char('\t'));
+            if (fields.size() != 4)
+                continue;
+            HashEntry entry;
+            entry.size = fields.at(0).toLongLong();
+            entry.lastModified = fields.at(1).toLongLong();
+            entry.hash = fields.at(2);
+            index->insert(fields.at(3), entry);
+        }
+    }
+    QFile referencesFile(m_directory + QLatin1String(referencesFileC));
+    if (referencesFile.exists()) {
+        if (!referencesFile.open(QIODevice::ReadOnly)) {
+            *errorMessage = QString::fromLatin1("Unable to read %1: %2")
+                            .arg(QDir::toNativeSeparators(referencesFile.fileName()), referencesFile.errorString());
+            return false;
+        }
+        while (!referencesFile.atEnd()) {
+            const QString line = QString::fromUtf8(referencesFile.readLine()).trimmed();
+            const int tabPos = line.indexOf(QLatin1Char('\t'));
+            if (tabPos > 0)
+                references->insert(line.mid(tabPos + 1), line.left(tabPos));
+        }
+    }
+    return true;
+}
+
+bool DeploymentStore::write(const HashIndex &index, const References &references, QString *errorMessage) const
+{
+    QByteArray indexData;
+    for (HashIndex::const_iterator it = index.constBegin(); it != index.constEnd(); ++it) {
+        indexData += QByteArray::number(it.value().size) + '\t'
+            + QByteArray::number(it.value().lastModified) + '\t'
+            + it.value().hash.toLatin1() + '\t' + it.key().toUtf8() + '\n';
+    }
+    QByteArray referencesData;
+    for (References::const_iterator it = references.constBegin(); it != references.constEnd(); ++it)
+        referencesData += it.value().toLatin1() + '\t' + it.key().toUtf8() + '\n';
+
+    QSaveFile indexFile(m_directory + QLatin1String(indexFileC));
+    QSaveFile referencesFile(m_directory + QLatin1String(referencesFileC));
+    if (!indexFile.open(QIODevice::WriteOnly) || indexFile.write(indexData) != indexData.size()
+        || !indexFile.commit()) {
+        *errorMessage = QString::fromLatin1("Unable to write %1: %2")
+                        .arg(QDir::toNativeSeparators(indexFile.fileName()), indexFile.errorString());
+        return false;
+    }
+    if (!referencesFile.open(QIODevice::WriteOnly) || referencesFile.write(referencesData) != referencesData.size()
+        || !referencesFile.commit()) {
+        *errorMessage = QString::fromLatin1("Unable to write %1: %2")
+                        .arg(QDir::toNativeSeparators(referencesFile.fileName()), referencesFile.errorString());
+        return false;
+    }
+    return true;
+}
+
+bool DeploymentStore::open(QString *errorMessage)
+{
+    if (!createDirectory(m_directory + QLatin1String(objectsDirectoryC), errorMessage))
+        return false;
+    QLockFile lockFile(m_directory + QLatin1String(lockFileC));
+    if (!lockFile.lock()) {
+        *errorMessage = QString::fromLatin1("Unable to lock the deployment store %1.")
+                        .arg(QDir::toNativeSeparators(m_directory));
+        return false;
+    }
+    return read(&m_index, &m_references, errorMessage);
+}
+
+// Merge the hashes and references of this run into the lists on disk, which may
+// have been modified by other processes meanwhile.
+bool DeploymentStore::save(QString *errorMessage)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_newHashes.isEmpty() && m_newReferences.isEmpty())
+        return true;
+    QLockFile lockFile(m_directory + QLatin1String(lockFileC));
+    if (!lockFile.lock()) {
+        *errorMessage = QString::fromLatin1("Unable to lock the deployment store %1.")
+                        .arg(QDir::toNativeSeparators(m_directory));
+        return false;
+    }
+    HashIndex index;
+    References references;
+    if (!read(&index, &references, errorMessage))
+        return false;
+    for (HashIndex::const_iterator it = m_newHashes.constBegin(); it != m_newHashes.constEnd(); ++it)
+        index.insert(it.key(), it.value());
+    for (References::const_iterator it = m_newReferences.constBegin(); it != m_newReferences.constEnd(); ++it)
+        references.insert(it.key(), it.value());
+    if (!write(index, references, errorMessage))
+        return false;
+    m_index = index;
+    m_references = references;
+    m_newHashes.clear();
+    m_newReferences.clear();
+    return true;
+}
+
+// Return the hash of a file, reading it only if size or modification time changed.
+bool DeploymentStore::contentHash(const QString &fileName, QString *hash, QString *errorMessage)
+{
+    const QFileInfo fileInfo(fileName);
+    const QString key = fileInfo.absoluteFilePath();
+    const qint64 size = fileInfo.size();
+    const qint64 lastModified = fileInfo.lastModified().toMSecsSinceEpoch();
+    {
+        QMutexLocker locker(&m_mutex);
+        HashEntry entry = m_newHashes.value(key);
+        if (entry.hash.isEmpty())
+            entry = m_index.value(key);
+        if (!entry.hash.isEmpty() && entry.size == size && entry.lastModified == lastModified) {
+            *hash = entry.hash;
+            return true;
+        }
+    }
+    QFile file(fileName);
+    QCryptographicHash cryptographicHash(QCryptographicHash::Sha256);
+    if (!file.open(QIODevice::ReadOnly) || !cryptographicHash.addData(&file)) {
+        *errorMessage = QString::fromLatin1("Unable to read %1: %2")
+                        .arg(QDir::toNativeSeparators(fileName), file.errorString());
+        return false;
+    }
+    HashEntry entry;
+    entry.size = size;
+    entry.lastModified = lastModified;
+    entry.hash = QString::fromLatin1(cryptographicHash.result().toHex());
+    *hash = entry.hash;
+    QMutexLocker locker(&m_mutex);
+    m_newHashes.insert(key, entry);
+    return true;
+}
+
+// Copy a file into the store via a temporary file, so that concurrent readers
+// never see incomplete objects.
+bool DeploymentStore::addObject(const QString &sourceFileName, const QString &objectFileName, QString *errorMessage)
+{
+    const QString objectDirectory = QFileInfo(objectFileName).absolutePath();
+    if (!QDir().mkpath(objectDirectory)) {
+        *errorMessage = QString::fromLatin1("Could not create directory %1.")
+                        .arg(QDir::toNativeSeparators(objectDirectory));
+        return false;
+    }
+    LOG_MESSAGE(LogDebug) << "Adding " << QDir::toNativeSeparators(sourceFileName) << " to the store."
+        << LogField("file", sourceFileName) << LogField("object", objectFileName);
+    QFile source(sourceFileName);
+    if (!source.open(QIODevice::ReadOnly)) {
+        *errorMessage = QString::fromLatin1("Unable to read %1: %2")
+                        .arg(QDir::toNativeSeparators(sourceFileName), source.errorString());
+        return false;
+    }
+    QTemporaryFile temporaryFile(objectDirectory + QStringLiteral("/ingest-XXXXXX"));
+    if (!temporaryFile.open()) {
+        *errorMessage = QString::fromLatin1("Unable to create a temporary file in %1: %2")
+                        .arg(QDir::toNativeSeparators(objectDirectory), temporaryFile.errorString());
+        return false;
+    }
+    QByteArray buffer(1024 * 1024, Qt::Uninitialized);
+    while (!source.atEnd()) {
+        const qint64 read = source.read(buffer.data(), buffer.size());
+        if (read < 0 || temporaryFile.write(buffer.constData(), read) != read) {
+            *errorMessage = QString::fromLatin1("Unable to add %1 to the store: %2")
+                            .arg(QDir::toNativeSeparators(sourceFileName),
+                                 read < 0 ? source.errorString() : temporaryFile.errorString());
+            return false;
+        }
+    }
+    countEvent(BytesCopiedCounter, source.size());
+    ioCopyEvent(sourceFileName, objectFileName, source.size());
+    // Objects are shared by hard links and must not be modified via a target.
+    temporaryFile.setPermissions(source.permissions()
+                                 & ~(QFile::WriteOwner | QFile::WriteUser | QFile::WriteGroup | QFile::WriteOther));
+    temporaryFile.close();
+    // The object may have been added concurrently, which is fine.
+    temporaryFile.setAutoRemove(false);
+    if (!temporaryFile.rename(objectFileName)) {
+        QString removeErrorMessage;
+        removeFile(temporaryFile.fileName(), &removeErrorMessage);
+        if (!QFileInfo(objectFileName).isFile()) {
+            *errorMessage = QString::fromLatin1("Unable to add %1 to the store.")
+                            .arg(QDir::toNativeSeparators(sourceFileName));
+            return false;
+        }
+    }
+    return true;
+}
+
+// Place a file into the target, which must not exist. Hard linked targets share
+// the read-only object; cloned and copied targets are writable.
+bool DeploymentStore::place(const QString &sourceFileName, const QString &targetFileName, QString *errorMessage)
+{
+    QString hash;
+    if (!contentHash(sourceFileName, &hash, errorMessage))
+        return false;
+    const QString object = objectFileName(hash);
+    const QFileInfo objectInfo(object);
+    if (!objectInfo.isFile()) {
+        if (!addObject(sourceFileName, object, errorMessage))
+            return false;
+    } else if (objectInfo.permissions() & QFile::WriteOwner) {
+        // Removing or patching a hard linked target on Windows cleared the read-only
+        // attribute shared with the object (makeFileWritable()).
+        QFile::setPermissions(object, objectInfo.permissions()
+                              & ~(QFile::WriteOwner | QFile::WriteUser | QFile::WriteGroup | QFile::WriteOther));
+    }
+    QString linkErrorMessage;
+    if (cloneFile(object, targetFileName) || createHardLink(object, targetFileName, &linkErrorMessage)) {
+        ioEvent(IoWrite, targetFileName);
+    } else {
+        LOG_MESSAGE(LogDebug) << linkErrorMessage << ", copying."
+            << LogField("object", object) << LogField("target", targetFileName);
+        QFile file(object);
+        if (!file.copy(targetFileName)) {
+            *errorMessage = QString::fromLatin1("Cannot copy %1 to %2: %3")
+                    .arg(QDir::toNativeSeparators(object),
+                         QDir::toNativeSeparators(targetFileName),
+                         file.errorString());
+            return false;
+        }
+        countEvent(BytesCopiedCounter, file.size());
+        ioCopyEvent(object, targetFileName, file.size());
+        QFile targetFile(targetFileName);
+        if (!targetFile.setPermissions(targetFile.permissions() | QFile::WriteUser)) {
+            *errorMessage = QString::fromLatin1("Cannot set write permission on %1: %2")
+                    .arg(QDir::toNativeSeparators(targetFileName), targetFile.errorString());
+            return false;
+        }
+    }
+    QMutexLocker locker(&m_mutex);
+    m_newReferences.insert(QFileInfo(targetFileName).absoluteFilePath(), hash);
+    return true;
+}
+
+// Drop the references to target files which no longer exist or were replaced,
+// the hashes of source files which no longer exist and remove the objects which
+// are not referenced anymore.
+bool DeploymentStore::collectGarbage(QString *errorMessage)
+{
+    QMutexLocker locker(&m_mutex);
+    QLockFile lockFile(m_directory + QLatin1String(lockFileC));
+    if (!lockFile.lock()) {
+        *errorMessage = QString::fromLatin1("Unable to lock the deployment store %1.")
+                        .arg(QDir::toNativeSeparators(m_directory));
+        return false;
+    }
+    HashIndex index;
+    References references;
+    if (!read(&index, &references, errorMessage))
+        return false;
+
+    QSet<QString> liveHashes;
+    References liveReferences;
+    for (References::const_iterator it = references.constBegin(); it != references.constEnd(); ++it) {
+        const QFileInfo target(it.key());
+        const QFileInfo object(objectFileName(it.value()));
+        if (target.isFile() && object.isFile() && target.size() == object.size()) {
+            liveReferences.insert(it.key(), it.value());
+            liveHashes.insert(it.value());
+        }
+    }
+    HashIndex liveIndex;
+    for (HashIndex::const_iterator it = index.constBegin(); it != index.constEnd(); ++it) {
+        if (QFileInfo(it.key()).isFile())
+            liveIndex.insert(it.key(), it.value());
+    }
+
+    const QString objectsDirectory = m_directory + QLatin1String(objectsDirectoryC);
+    const QDateTime threshold = QDateTime::currentDateTime().addSecs(-garbageCollectionGracePeriodSecs);
+    int removedCount = 0;
+    qint64 removedSize = 0;
+    QDirIterator it(objectsDirectory, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        const QFileInfo object = it.fileInfo();
+        const QString hash = object.dir().dirName() + object.fileName();
+        if (liveHashes.contains(hash) || object.lastModified() > threshold)
+            continue;
+        LOG_MESSAGE(LogDebug) << "Removing " << QDir::toNativeSeparators(object.absoluteFilePath()) << '.'
+            << LogField("object", object.absoluteFilePath());
+        QString removeErrorMessage;
+        if (removeFile(object.absoluteFilePath(), &removeErrorMessage)) {
+            ++removedCount;
+            removedSize += object.size();
+        }
+    }
+    if (verboseLevel()) {
+        logStream() << "Removed " << removedCount << " objects (" << removedSize << " bytes), "
+                   << liveHashes.size() << " objects are referenced.\n";
+    }
+    if (!write(liveIndex, liveReferences, errorMessage))
+        return false;
+    m_index = liveIndex;
+    m_references = liveReferences;
+    return true;
+}
+
+QT_END_NAMESPACE
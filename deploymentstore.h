@@ -0,0 +1,95 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef DEPLOYMENTSTORE_H
+#define DEPLOYMENTSTORE_H
+
+#include "types.h"
+
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+
+QT_BEGIN_NAMESPACE
+
+// Local content-addressed store of deployed files. Source files are hashed once
+// (the hashes are cached by size and modification time), kept by content hash
+// under "objects" and placed into the target directories by reflink, hard link
+// or, as a last resort, by copying. The placed target files are recorded as
+// references, which collectGarbage() uses to remove unreferenced objects.
+// The instance is thread-safe; concurrent processes synchronize by a lock file
+// when writing the index and reference lists.
+class DeploymentStore
+{
+public:
+    explicit DeploymentStore(const QString &directory);
+
+    QString directory() const { return m_directory; }
+
+    bool open(QString *errorMessage);
+    bool save(QString *errorMessage);
+
+    bool place(const QString &sourceFileName, const QString &targetFileName, QString *errorMessage);
+
+    bool collectGarbage(QString *errorMessage);
+
+private:
+    Q_DISABLE_COPY(DeploymentStore)
+
+    struct HashEntry {
+        HashEntry() : size(0), lastModified(0) {}
+
+        qint64 size;
+        qint64 lastModified;
+        QString hash;
+    };
+
+    typedef QHash<QString, HashEntry> HashIndex; // Source file -> content hash.
+    typedef QHash<QString, QString> References; // Target file -> content hash.
+
+    bool contentHash(const QString &fileName, QString *hash, QString *errorMessage);
+    bool addObject(const QString &sourceFileName, const QString &objectFileName, QString *errorMessage);
+    QString objectFileName(const QString &hash) const;
+    bool read(HashIndex *index, References *references, QString *errorMessage) const;
+    bool write(const HashIndex &index, const References &references, QString *errorMessage) const;
+
+    const QString m_directory;
+    QMutex m_mutex;
+    HashIndex m_index;
+    References m_references;
+    HashIndex m_newHashes;
+    References m_newReferences;
+};
+
+QT_END_NAMESPACE
+
+#endif // DEPLOYMENTSTORE_H
@@ -0,0 +1,222 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "directorywalker.h"
+#include "utils.h"
+#include "statistics.h"
+#include "tracing.h"
+#include "iostats.h"
+
+#include <QtCore/QMap>
+#include <QtCore/QMutex>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QRunnable>
+#include <QtCore/QThreadPool>
+
+#if defined(Q_OS_WIN)
+#  include <QtCore/qt_windows.h>
+#else // Q_OS_WIN
+#  include <sys/types.h>
+#  include <sys/stat.h>
+#  include <dirent.h>
+#  include <errno.h>
+#  include <string.h>
+#endif  // !Q_OS_WIN
+
+QT_BEGIN_NAMESPACE
+
+#ifdef Q_OS_WIN
+
+#ifndef FIND_FIRST_EX_LARGE_FETCH
+#  define FIND_FIRST_EX_LARGE_FETCH 2
+#endif
+
+bool readDirectory(const QString &directory, DirectoryEntries *entries, QString *errorMessage)
+{
+    const TraceSpan span("readDirectory", "directory", "directory", directory);
+    ioEvent(IoListDirectory, directory);
+    const QString pattern = QDir::toNativeSeparators(directory) + QStringLiteral("\\*");
+    WIN32_FIND_DATAW data;
+    const HANDLE handle = FindFirstFileExW(reinterpret_cast<LPCWSTR>(pattern.utf16()), FindExInfoStandard,
+                                           &data, FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH);
+    if (handle == INVALID_HANDLE_VALUE) {
+        *errorMessage = QString::fromLatin1("Cannot read directory %1: %2")
+                        .arg(QDir::toNativeSeparators(directory), winErrorMessage(GetLastError()));
+        return false;
+    }
+    do {
+        const QString name = QString::fromWCharArray(data.cFileName);
+        if (name == QLatin1String(".") || name == QLatin1String("..")
+            || (data.dwFileAttributes & FILE_ATTRIBUTE_HIDDEN)) {
+            continue;
+        }
+        const bool isDirectory = data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY;
+        const bool isSymLink = (data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT)
+            && data.dwReserved0 == IO_REPARSE_TAG_SYMLINK;
+        if (isDirectory)
+            (isSymLink ? entries->symLinkDirectories : entries->directories).append(name);
+        else
+            (isSymLink ? entries->symLinks : entries->files).append(name);
+    } while (FindNextFileW(handle, &data));
+    FindClose(handle);
+    return true;
+}
+
+#else // Q_OS_WIN
+
+// Classify by d_type, falling back to stat() for file systems that do not
+// provide it and for symbolic links.
+bool readDirectory(const QString &directory, DirectoryEntries *entries, QString *errorMessage)
+{
+    const TraceSpan span("readDirectory", "directory", "directory", directory);
+    ioEvent(IoListDirectory, directory);
+    const QByteArray nativeDirectory = QFile::encodeName(directory);
+    DIR *dir = opendir(nativeDirectory.constData());
+    if (!dir) {
+        *errorMessage = QString::fromLatin1("Cannot read directory %1: %2")
+                        .arg(QDir::toNativeSeparators(directory), QString::fromLocal8Bit(strerror(errno)));
+        return false;
+    }
+    while (const dirent *entry = readdir(dir)) {
+        if (entry->d_name[0] == '.') // ".", ".." and hidden files
+            continue;
+        const QString name = QFile::decodeName(entry->d_name);
+        unsigned char type = entry->d_type;
+        bool isSymLink = type == DT_LNK;
+        if (type == DT_UNKNOWN || isSymLink) {
+            const QByteArray path = nativeDirectory + '/' + entry->d_name;
+            struct stat st;
+            countEvent(FilesStatedCounter);
+            if (isIoAccountingEnabled())
+                ioEvent(IoStat, QFile::decodeName(path));
+            if (type == DT_UNKNOWN && lstat(path.constData(), &st) == 0 && S_ISLNK(st.st_mode))
+                isSymLink = true;
+            if (stat(path.constData(), &st) != 0)
+                continue; // Dangling link.
+            type = S_ISDIR(st.st_mode) ? DT_DIR : (S_ISREG(st.st_mode) ? DT_REG : DT_UNKNOWN);
+        }
+        if (type == DT_DIR)
+            (isSymLink ? entries->symLinkDirectories : entries->directories).append(name);
+        else if (type == DT_REG)
+            (isSymLink ? entries->symLinks : entries->files).append(name);
+    }
+    closedir(dir);
+    return true;
+}
+
+#endif // !Q_OS_WIN
+
+namespace {
+
+struct DirectoryWalk {
+    DirectoryWalk(const QString &r) : root(r), logContext(currentLogContext()) {}
+
+    const QString root;
+    const LogContext logContext;
+    QThreadPool pool;
+    QMutex mutex;
+    QMap<QString, DirectoryEntries> directories; // Sort key -> entries.
+    QString errorMessage;
+};
+
+// Sort key placing subdirectories right after their parent.
+static inline QString sortKey(const QString &relativePath)
+{
+    QString result = relativePath;
+    result.replace(QLatin1Char('/'), QChar(1));
+    return result;
+}
+
+class DirectoryWalkTask : public QRunnable
+{
+public:
+    DirectoryWalkTask(DirectoryWalk *walk, const QString &relativePath)
+        : m_walk(walk), m_relativePath(relativePath) {}
+
+    void run() Q_DECL_OVERRIDE
+    {
+        const LogScope logScope(m_walk->logContext);
+        const QString path = m_relativePath.isEmpty()
+            ? m_walk->root : m_walk->root + QLatin1Char('/') + m_relativePath;
+        DirectoryEntries entries;
+        QString errorMessage;
+        const bool ok = readDirectory(path, &entries, &errorMessage);
+        entries.files.sort();
+        entries.symLinks.sort();
+        entries.directories.sort();
+        entries.symLinkDirectories.sort();
+        {
+            QMutexLocker locker(&m_walk->mutex);
+            if (!ok) {
+                if (m_walk->errorMessage.isEmpty())
+                    m_walk->errorMessage = errorMessage;
+                return;
+            }
+            m_walk->directories.insert(sortKey(m_relativePath), entries);
+        }
+        const QString prefix = m_relativePath.isEmpty() ? QString() : m_relativePath + QLatin1Char('/');
+        foreach (const QString &subDirectory, entries.directories)
+            m_walk->pool.start(new DirectoryWalkTask(m_walk, prefix + subDirectory));
+    }
+
+private:
+    DirectoryWalk *m_walk;
+    const QString m_relativePath;
+};
+
+} // namespace
+
+bool walkDirectoryTree(const QString &root, int jobs, QList<WalkedDirectory> *result,
+                       QString *errorMessage)
+{
+    DirectoryWalk walk(root);
+    if (jobs > 0)
+        walk.pool.setMaxThreadCount(jobs);
+    walk.pool.start(new DirectoryWalkTask(&walk, QString()));
+    walk.pool.waitForDone();
+    if (!walk.errorMessage.isEmpty()) {
+        *errorMessage = walk.errorMessage;
+        return false;
+    }
+    for (QMap<QString, DirectoryEntries>::const_iterator it = walk.directories.constBegin();
+         it != walk.directories.constEnd(); ++it) {
+        WalkedDirectory directory;
+        directory.relativePath = it.key();
+        directory.relativePath.replace(QChar(1), QLatin1Char('/'));
+        directory.entries = it.value();
+        result->append(directory);
+    }
+    return true;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,64 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef DIRECTORYWALKER_H
+#define DIRECTORYWALKER_H
+
+#include "types.h"
+
+QT_BEGIN_NAMESPACE
+
+// Entries of a directory classified in one pass. Hidden entries are skipped
+// as by QDir::entryList().
+struct DirectoryEntries {
+    QStringList files;              // Regular files.
+    QStringList symLinks;           // Symbolic links to files.
+    QStringList directories;        // Subdirectories.
+    QStringList symLinkDirectories; // Symbolic links to directories (not walked).
+};
+
+struct WalkedDirectory {
+    QString relativePath; // Empty for the root.
+    DirectoryEntries entries;
+};
+
+bool readDirectory(const QString &directory, DirectoryEntries *entries, QString *errorMessage);
+
+// Read a directory tree using a pool of jobs threads (0: number of processors).
+// The result is ordered depth-first, parents before their subdirectories.
+bool walkDirectoryTree(const QString &root, int jobs, QList<WalkedDirectory> *result,
+                       QString *errorMessage);
+
+QT_END_NAMESPACE
+
+#endif // DIRECTORYWALKER_H
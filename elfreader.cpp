@@ -32,6 +32,7 @@
 ****************************************************************************/
 
 #include "elfreader.h"
+#include "iostats.h"
 
 #include <QDir>
 
@@ -115,6 +116,7 @@ public:
     {
         if (!file.open(QIODevice::ReadOnly))
             return false;
+        ioEvent(IoOpen, file.fileName());
 
         fdlen = file.size();
         ustart = file.map(0, fdlen);
@@ -123,6 +125,9 @@ public:
             raw = file.readAll();
             start = raw.constData();
             fdlen = raw.size();
+            ioEvent(IoRead, file.fileName(), raw.size());
+        } else {
+            ioEvent(IoMap, file.fileName(), qint64(fdlen));
         }
         return true;
     }
@@ -0,0 +1,205 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "iostats.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QJsonObject>
+#include <QtCore/QReadLocker>
+#include <QtCore/QWriteLocker>
+
+QT_BEGIN_NAMESPACE
+
+// Also the keys of the JSON output.
+static const char *operationNames[IoOperationCount] = {
+    "stat", "open", "read", "write", "mmap", "readdir"
+};
+
+static const char *rootNames[IoRootCount] = {
+    "qt", "application", "target", "other"
+};
+
+static inline bool hasBytes(IoOperation operation)
+{
+    return operation == IoRead || operation == IoWrite || operation == IoMap;
+}
+
+#ifdef Q_OS_WIN
+static const Qt::CaseSensitivity pathCaseSensitivity = Qt::CaseInsensitive;
+#else
+static const Qt::CaseSensitivity pathCaseSensitivity = Qt::CaseSensitive;
+#endif
+
+IoStatistics::IoStatistics() : m_currentDirectory(QDir::currentPath())
+{
+    for (int p = 0; p < PhaseCount; ++p) {
+        for (int r = 0; r < IoRootCount; ++r) {
+            for (int o = 0; o < IoOperationCount; ++o) {
+                m_calls[p][r][o].store(0);
+                m_bytes[p][r][o].store(0);
+            }
+        }
+    }
+}
+
+const char *IoStatistics::operationName(IoOperation operation)
+{
+    return operationNames[operation];
+}
+
+const char *IoStatistics::rootName(IoRoot root)
+{
+    return rootNames[root];
+}
+
+void IoStatistics::addRoot(IoRoot root, const QString &directory)
+{
+    if (directory.isEmpty())
+        return;
+    QString path = QDir::cleanPath(QDir(m_currentDirectory).absoluteFilePath(directory));
+    if (!path.endsWith(QLatin1Char('/')))
+        path += QLatin1Char('/');
+    QWriteLocker locker(&m_rootLock);
+    for (int i = 0; i < m_roots.size(); ++i) {
+        if (m_roots.at(i).first.compare(path, pathCaseSensitivity) == 0) {
+            if (root == TargetRoot) // The application is deployed in place.
+                m_roots[i].second = TargetRoot;
+            return;
+        }
+    }
+    int pos = 0;
+    while (pos < m_roots.size() && m_roots.at(pos).first.size() >= path.size())
+        ++pos;
+    m_roots.insert(pos, RootEntry(path, root));
+}
+
+IoRoot IoStatistics::classify(const QString &pathIn) const
+{
+    // Cheap normalization, the paths used by the deployment are mostly absolute and clean.
+    QString path = QDir::isAbsolutePath(pathIn)
+        ? pathIn : m_currentDirectory + QLatin1Char('/') + pathIn;
+    if (path.contains(QLatin1String("/.")) || path.contains(QLatin1Char('\\')))
+        path = QDir::cleanPath(QDir::fromNativeSeparators(path));
+    path += QLatin1Char('/');
+    QReadLocker locker(&m_rootLock);
+    foreach (const RootEntry &root, m_roots) {
+        if (path.startsWith(root.first, pathCaseSensitivity))
+            return root.second;
+    }
+    return OtherRoot;
+}
+
+void IoStatistics::add(DeploymentPhase phase, IoOperation operation, const QString &path, qint64 bytes)
+{
+    const IoRoot root = classify(path);
+    m_calls[phase][root][operation].fetchAndAddRelaxed(1);
+    if (bytes)
+        m_bytes[phase][root][operation].fetchAndAddRelaxed(bytes);
+}
+
+QString IoStatistics::format() const
+{
+    QList<QStringList> rows;
+    QStringList row;
+    row << QStringLiteral("Phase") << QStringLiteral("Root");
+    for (int o = 0; o < IoOperationCount; ++o) {
+        row.append(QLatin1String(operationNames[o]));
+        if (hasBytes(IoOperation(o)))
+            row.append(QLatin1String(operationNames[o]) + QStringLiteral(" bytes"));
+    }
+    rows.append(row);
+
+    qint64 totalCalls[IoRootCount][IoOperationCount] = {{0}};
+    qint64 totalBytes[IoRootCount][IoOperationCount] = {{0}};
+    for (int p = 0; p < PhaseCount; ++p) {
+        for (int r = 0; r < IoRootCount; ++r) {
+            bool used = false;
+            for (int o = 0; o < IoOperationCount && !used; ++o)
+                used = calls(DeploymentPhase(p), IoRoot(r), IoOperation(o)) != 0;
+            if (!used)
+                continue;
+            row.clear();
+            row << QLatin1String(DeploymentStatistics::phaseName(DeploymentPhase(p)))
+                << QLatin1String(rootNames[r]);
+            for (int o = 0; o < IoOperationCount; ++o) {
+                const qint64 c = calls(DeploymentPhase(p), IoRoot(r), IoOperation(o));
+                const qint64 b = bytes(DeploymentPhase(p), IoRoot(r), IoOperation(o));
+                totalCalls[r][o] += c;
+                totalBytes[r][o] += b;
+                row.append(QString::number(c));
+                if (hasBytes(IoOperation(o)))
+                    row.append(QString::number(b));
+            }
+            rows.append(row);
+        }
+    }
+    for (int r = 0; r < IoRootCount; ++r) {
+        row.clear();
+        row << QStringLiteral("total") << QLatin1String(rootNames[r]);
+        for (int o = 0; o < IoOperationCount; ++o) {
+            row.append(QString::number(totalCalls[r][o]));
+            if (hasBytes(IoOperation(o)))
+                row.append(QString::number(totalBytes[r][o]));
+        }
+        rows.append(row);
+    }
+    return formatStatisticsTable(rows, 2);
+}
+
+QJsonArray IoStatistics::toJson() const
+{
+    QJsonArray result;
+    for (int p = 0; p < PhaseCount; ++p) {
+        for (int r = 0; r < IoRootCount; ++r) {
+            QJsonObject object;
+            for (int o = 0; o < IoOperationCount; ++o) {
+                const qint64 c = calls(DeploymentPhase(p), IoRoot(r), IoOperation(o));
+                if (!c)
+                    continue;
+                object.insert(QLatin1String(operationNames[o]), double(c));
+                if (hasBytes(IoOperation(o))) {
+                    object.insert(QLatin1String(operationNames[o]) + QStringLiteral("Bytes"),
+                                  double(bytes(DeploymentPhase(p), IoRoot(r), IoOperation(o))));
+                }
+            }
+            if (object.isEmpty())
+                continue;
+            object.insert(QStringLiteral("phase"), QLatin1String(DeploymentStatistics::phaseName(DeploymentPhase(p))));
+            object.insert(QStringLiteral("root"), QLatin1String(rootNames[r]));
+            result.append(object);
+        }
+    }
+    return result;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,131 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef IOSTATS_H
+#define IOSTATS_H
+
+#include "statistics.h"
+
+#include <QtCore/QJsonArray>
+#include <QtCore/QPair>
+#include <QtCore/QReadWriteLock>
+#include <QtCore/QVector>
+
+QT_BEGIN_NAMESPACE
+
+// Calls of the file primitives made by the deployment. Qt internals are not
+// seen, for example QFile::copy() counts as one read and one write of the file.
+enum IoOperation {
+    IoStat,
+    IoOpen,
+    IoRead,
+    IoWrite,
+    IoMap,
+    IoListDirectory,
+    IoOperationCount
+};
+
+// Storage the files are on, by the longest matching registered root.
+enum IoRoot {
+    QtInstallationRoot,
+    ApplicationRoot,  // Directories of the binaries and QML sources.
+    TargetRoot,       // Deployment directories, preferred if equal to the application's.
+    OtherRoot,
+    IoRootCount
+};
+
+// I/O calls and bytes per phase and root, reported by "--io-stats".
+// Thread-safe, batch deployments add up in one instance.
+class IoStatistics
+{
+public:
+    IoStatistics();
+
+    void addRoot(IoRoot root, const QString &directory);
+    IoRoot classify(const QString &path) const;
+
+    void add(DeploymentPhase phase, IoOperation operation, const QString &path, qint64 bytes);
+
+    qint64 calls(DeploymentPhase phase, IoRoot root, IoOperation operation) const
+        { return m_calls[phase][root][operation].load(); }
+    qint64 bytes(DeploymentPhase phase, IoRoot root, IoOperation operation) const
+        { return m_bytes[phase][root][operation].load(); }
+
+    static const char *operationName(IoOperation operation);
+    static const char *rootName(IoRoot root);
+
+    QString format() const;
+    QJsonArray toJson() const;
+
+private:
+    Q_DISABLE_COPY(IoStatistics)
+
+    typedef QPair<QString, IoRoot> RootEntry; // Clean absolute path with trailing slash.
+
+    const QString m_currentDirectory;
+    mutable QReadWriteLock m_rootLock;
+    QVector<RootEntry> m_roots; // Longest first.
+    QAtomicInteger<qint64> m_calls[PhaseCount][IoRootCount][IoOperationCount];
+    QAtomicInteger<qint64> m_bytes[PhaseCount][IoRootCount][IoOperationCount];
+};
+
+inline bool isIoAccountingEnabled()
+{
+    return currentLogContext().ioStatistics != 0;
+}
+
+// Adds a call in the current phase if the log context of the thread has I/O
+// statistics (see LogContext), a no-op otherwise.
+inline void ioEvent(IoOperation operation, const QString &path, qint64 bytes = 0)
+{
+    const LogContext context = currentLogContext();
+    if (context.ioStatistics)
+        context.ioStatistics->add(DeploymentPhase(context.phase), operation, path, bytes);
+}
+
+// A file copied by reading and writing it as a whole.
+inline void ioCopyEvent(const QString &source, const QString &target, qint64 bytes)
+{
+    const LogContext context = currentLogContext();
+    if (IoStatistics *ioStatistics = context.ioStatistics) {
+        const DeploymentPhase phase = DeploymentPhase(context.phase);
+        ioStatistics->add(phase, IoOpen, source, 0);
+        ioStatistics->add(phase, IoRead, source, bytes);
+        ioStatistics->add(phase, IoOpen, target, 0);
+        ioStatistics->add(phase, IoWrite, target, bytes);
+    }
+}
+
+QT_END_NAMESPACE
+
+#endif // IOSTATS_H
@@ -39,15 +39,24 @@
 // Container class for JSON output
 class JsonOutput
 {
+public:
     typedef QPair<QString, QString> SourceTargetMapping;
     typedef QList<SourceTargetMapping> SourceTargetMappings;
 
-public:
+    SourceTargetMappings files() const { return m_files; }
+
     void addFile(const QString &source, const QString &target)
     {
         m_files.append(SourceTargetMapping(source, target));
     }
 
+    // "--timings", see DeploymentStatistics::toJson().
+    void setTimings(const QJsonObject &timings) { m_timings = timings; }
+    // "--io-stats", see IoStatistics::toJson().
+    void setIoStatistics(const QJsonArray &ioStatistics) { m_ioStatistics = ioStatistics; }
+    // "--memstats", see MemoryStatistics::toJson().
+    void setMemoryStatistics(const QJsonObject &memoryStatistics) { m_memoryStatistics = memoryStatistics; }
+
     void removeTargetDirectory(const QString &targetDirectory)
     {
         for (int i = m_files.size() - 1; i >= 0; --i) {
@@ -67,6 +76,12 @@ public:
             files.append(object);
         }
         document.insert(QStringLiteral("files"), files);
+        if (!m_timings.isEmpty())
+            document.insert(QStringLiteral("timings"), m_timings);
+        if (!m_ioStatistics.isEmpty())
+            document.insert(QStringLiteral("io"), m_ioStatistics);
+        if (!m_memoryStatistics.isEmpty())
+            document.insert(QStringLiteral("memory"), m_memoryStatistics);
         return QJsonDocument(document).toJson();
     }
     QByteArray toList(ListOption option, const QDir &base) const
@@ -97,6 +112,9 @@ public:
     }
 private:
     SourceTargetMappings m_files;
+    QJsonObject m_timings;
+    QJsonArray m_ioStatistics;
+    QJsonObject m_memoryStatistics;
 };
 
 #endif // JSONOUTPUT_H
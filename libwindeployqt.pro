@@ -0,0 +1,11 @@
+# Deployment library for embedding, see deployer.h.
+TEMPLATE = lib
+TARGET = windeployqt
+
+CONFIG += staticlib
+CONFIG -= app_bundle
+
+QT += core
+QT -= gui
+
+include(windeployqt.pri)
@@ -0,0 +1,366 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "logging.h"
+#ifdef WINDEPLOYQT_MEMSTATS
+#  include "memstats.h"
+#endif
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QMutex>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QSemaphore>
+#include <QtCore/QThread>
+#include <QtCore/QThreadStorage>
+#include <QtCore/QWaitCondition>
+
+#include <iostream>
+#include <streambuf>
+#include <string>
+
+QT_BEGIN_NAMESPACE
+
+namespace {
+
+// Positions wrap around, compare them modulo 2^32.
+static inline int sequenceDifference(int s1, int s2)
+{
+    return int(unsigned(s1) - unsigned(s2));
+}
+
+struct LogEntry
+{
+    LogEntry() : sink(0), progress(false) {}
+
+    LogRecord record;
+    LogSink *sink;
+    bool progress; // record.text is the stage.
+};
+
+// Bounded multi-producer/single-consumer queue (after D. Vyukov): each slot
+// has a sequence number telling whether it is free for the producer claiming
+// position pos (sequence == pos) or holds the entry of pos (sequence == pos + 1).
+class LogQueue
+{
+public:
+    enum { Capacity = 4096, Mask = Capacity - 1 };
+
+    LogQueue() : m_enqueuePosition(0), m_dequeuePosition(0)
+    {
+        for (int i = 0; i < Capacity; ++i)
+            m_slots[i].sequence.store(i);
+    }
+
+    bool tryPush(const LogEntry &entry)
+    {
+        int position = m_enqueuePosition.load();
+        Slot *slot;
+        forever {
+            slot = m_slots + (position & Mask);
+            const int difference = sequenceDifference(slot->sequence.loadAcquire(), position);
+            if (difference == 0) {
+                if (m_enqueuePosition.testAndSetRelaxed(position, int(unsigned(position) + 1)))
+                    break;
+                position = m_enqueuePosition.load();
+            } else if (difference < 0) {
+                return false; // Full.
+            } else {
+                position = m_enqueuePosition.load();
+            }
+        }
+        slot->entry = entry;
+        slot->sequence.storeRelease(int(unsigned(position) + 1));
+        return true;
+    }
+
+    // Consumer only.
+    bool tryPop(LogEntry *entry)
+    {
+        Slot *slot = m_slots + (m_dequeuePosition & Mask);
+        if (sequenceDifference(slot->sequence.loadAcquire(), int(m_dequeuePosition + 1)) < 0)
+            return false; // Empty or not published yet.
+        *entry = slot->entry;
+        slot->entry = LogEntry();
+        slot->sequence.storeRelease(int(m_dequeuePosition + Capacity));
+        ++m_dequeuePosition;
+        return true;
+    }
+
+    int enqueuePosition() const { return m_enqueuePosition.loadAcquire(); }
+
+private:
+    struct Slot {
+        QAtomicInt sequence;
+        LogEntry entry;
+    };
+
+    Slot m_slots[Capacity];
+    QAtomicInt m_enqueuePosition;
+    unsigned m_dequeuePosition;
+};
+
+static inline void writeLine(std::wostream &str, const QString &text)
+{
+#ifdef Q_OS_WIN
+    str << reinterpret_cast<const wchar_t *>(text.utf16()) << L'\n';
+#else
+    str << text.toStdWString() << L'\n';
+#endif
+}
+
+// Background thread writing the queued records to the sinks or the console.
+class LogWriter : public QThread
+{
+public:
+    LogWriter() : m_written(0), m_stopping(false) { start(); }
+
+    ~LogWriter()
+    {
+        m_stopping.storeRelease(1);
+        m_available.release();
+        wait();
+    }
+
+    // Records logged by a sink are written directly, waiting for the queue to
+    // drain would wait for the calling thread itself.
+    void push(const LogEntry &entry)
+    {
+        if (QThread::currentThread() == this) {
+            write(entry);
+            return;
+        }
+        while (!m_queue.tryPush(entry))
+            QThread::yieldCurrentThread(); // Full, the writer is draining it.
+        m_available.release();
+    }
+
+    void flush()
+    {
+        if (QThread::currentThread() == this)
+            return; // Called by a sink, the preceding records are being written.
+        const int position = m_queue.enqueuePosition();
+        QMutexLocker locker(&m_flushMutex);
+        while (sequenceDifference(m_written, position) < 0)
+            m_flushed.wait(&m_flushMutex);
+    }
+
+protected:
+    void run() Q_DECL_OVERRIDE
+    {
+        forever {
+            m_available.acquire();
+            LogEntry entry;
+            while (!m_queue.tryPop(&entry)) {
+                if (m_stopping.loadAcquire())
+                    return;
+                QThread::yieldCurrentThread(); // Claimed, but not published yet.
+            }
+            write(entry);
+            QMutexLocker locker(&m_flushMutex);
+            m_written = int(unsigned(m_written) + 1);
+            m_flushed.wakeAll();
+        }
+    }
+
+private:
+    static void write(const LogEntry &entry)
+    {
+        if (entry.sink) {
+            if (entry.progress)
+                entry.sink->progress(entry.record.text);
+            else
+                entry.sink->message(entry.record);
+        } else if (!entry.progress) {
+            std::wostream &str = entry.record.level == LogWarning ? std::wcerr : std::wcout;
+            writeLine(str, entry.record.text);
+        }
+    }
+
+    LogQueue m_queue;
+    QSemaphore m_available;
+    QMutex m_flushMutex;
+    QWaitCondition m_flushed;
+    int m_written;
+    QAtomicInt m_stopping;
+};
+
+// Collects the characters written to a stream and queues complete lines.
+class LineStreamBuffer : public std::wstreambuf
+{
+public:
+    LineStreamBuffer(LogLevel level, const LogContext *context) : m_level(level), m_context(context) {}
+
+    // Queue an unterminated last line.
+    void flushLine()
+    {
+        if (!m_line.empty())
+            queueLine();
+    }
+
+protected:
+    int_type overflow(int_type c) Q_DECL_OVERRIDE
+    {
+        if (traits_type::eq_int_type(c, traits_type::eof()))
+            return traits_type::not_eof(c);
+        if (traits_type::to_char_type(c) == L'\n')
+            queueLine();
+        else
+            m_line.push_back(traits_type::to_char_type(c));
+        return c;
+    }
+
+private:
+    void queueLine();
+
+    const LogLevel m_level;
+    const LogContext *m_context; // Of the owning ThreadLog.
+    std::wstring m_line;
+};
+
+struct ThreadLog
+{
+    ThreadLog() : infoBuffer(LogInfo, &context), errorBuffer(LogWarning, &context), info(&infoBuffer), error(&errorBuffer) {}
+    ~ThreadLog();
+
+    void flushLines()
+    {
+        infoBuffer.flushLine();
+        errorBuffer.flushLine();
+    }
+
+    LogContext context;
+    LineStreamBuffer infoBuffer;
+    LineStreamBuffer errorBuffer;
+    std::wostream info;
+    std::wostream error;
+};
+
+} // namespace
+
+Q_GLOBAL_STATIC(LogWriter, logWriter)
+
+// Does not use the thread's log, which may be in destruction.
+void LineStreamBuffer::queueLine()
+{
+    LogEntry entry;
+    entry.record = LogRecord(m_level);
+    entry.record.text = QString::fromStdWString(m_line);
+    entry.sink = m_context->sink;
+    m_line.clear();
+    logWriter()->push(entry);
+}
+
+ThreadLog::~ThreadLog()
+{
+    if (!logWriter.isDestroyed())
+        flushLines();
+}
+
+static QThreadStorage<ThreadLog *> threadLogs;
+
+static ThreadLog *threadLog()
+{
+    if (!threadLogs.hasLocalData())
+        threadLogs.setLocalData(new ThreadLog);
+    return threadLogs.localData();
+}
+
+LogContext currentLogContext()
+{
+    return threadLog()->context;
+}
+
+int verboseLevel()
+{
+    return threadLog()->context.verboseLevel;
+}
+
+void logRecord(const LogRecord &record)
+{
+    LogEntry entry;
+    entry.record = record;
+    entry.sink = threadLog()->context.sink;
+    logWriter()->push(entry);
+}
+
+void reportProgress(const QString &stage)
+{
+    if (LogSink *sink = threadLog()->context.sink) {
+        LogEntry entry;
+        entry.record.text = stage;
+        entry.sink = sink;
+        entry.progress = true;
+        logWriter()->push(entry);
+    }
+}
+
+void flushLog()
+{
+    if (threadLogs.hasLocalData())
+        threadLogs.localData()->flushLines();
+    logWriter()->flush();
+}
+
+std::wostream &logStream()
+{
+    return threadLog()->info;
+}
+
+std::wostream &errorStream()
+{
+    return threadLog()->error;
+}
+
+// Unterminated lines are queued before switching, they belong to the sink of the
+// context they were written in.
+LogScope::LogScope(const LogContext &context) : m_previous(currentLogContext())
+{
+    ThreadLog *log = threadLog();
+    log->flushLines();
+    log->context = context;
+#ifdef WINDEPLOYQT_MEMSTATS
+    setAllocationContext(context.memoryStatistics, context.phase);
+#endif
+}
+
+LogScope::~LogScope()
+{
+    ThreadLog *log = threadLog();
+    log->flushLines();
+    log->context = m_previous;
+#ifdef WINDEPLOYQT_MEMSTATS
+    setAllocationContext(m_previous.memoryStatistics, m_previous.phase);
+#endif
+}
+
+QT_END_NAMESPACE
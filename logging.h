@@ -0,0 +1,166 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef LOGGING_H
+#define LOGGING_H
+
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+#include <iosfwd>
+
+QT_BEGIN_NAMESPACE
+
+class DeploymentStatistics;
+class TraceRecorder;
+class IoStatistics;
+class MemoryStatistics;
+
+// Levels correspond to the verbose level at which records are output.
+enum LogLevel {
+    LogWarning = 0, // Also errors, always output.
+    LogInfo = 1,
+    LogDebug = 2,
+    LogTrace = 3
+};
+
+struct LogField
+{
+    LogField() : name(0) {}
+    LogField(const char *n, const QString &v) : name(n), value(v) {}
+
+    const char *name; // Static string.
+    QString value;
+};
+
+struct LogRecord
+{
+    LogRecord() : level(LogInfo) {}
+    explicit LogRecord(LogLevel l) : level(l) {}
+
+    LogLevel level;
+    QString text; // Without trailing newline.
+    QVector<LogField> fields;
+};
+
+// Receives the records of deployments and their progress instead of
+// std::wcout/std::wcerr. Called from the log writer thread only, in the order
+// the records were logged by each thread. Records logged by a sink are passed
+// on directly, ahead of the queued ones, and flushLog() returns immediately.
+class LogSink
+{
+public:
+    virtual ~LogSink() {}
+
+    virtual void message(const LogRecord &record) = 0;
+    virtual void progress(const QString &stage) { Q_UNUSED(stage) }
+};
+
+struct LogContext
+{
+    LogContext() : verboseLevel(1), sink(0), statistics(0), phase(0), trace(0), ioStatistics(0)
+                 , memoryStatistics(0) {}
+    explicit LogContext(int v, LogSink *s = 0, DeploymentStatistics *st = 0, TraceRecorder *t = 0)
+        : verboseLevel(v), sink(s), statistics(st), phase(0), trace(t), ioStatistics(0)
+        , memoryStatistics(0) {}
+
+    int verboseLevel;
+    LogSink *sink;
+    DeploymentStatistics *statistics; // "--timings", see statistics.h.
+    int phase; // DeploymentPhase the counters are added to.
+    TraceRecorder *trace; // "--trace", see tracing.h.
+    IoStatistics *ioStatistics; // "--io-stats", see iostats.h.
+    MemoryStatistics *memoryStatistics; // "--memstats", see memstats.h.
+};
+
+// Log context of the current thread, replacing a global verbose level so that
+// deployments can run concurrently with their own settings. Tasks running on
+// other threads take the context of the thread creating them (LogScope).
+LogContext currentLogContext();
+int verboseLevel();
+inline bool isLogEnabled(LogLevel level) { return level == LogWarning || int(level) <= verboseLevel(); }
+
+// Records are queued in a lock-free ring buffer and written by a background
+// thread, so that logging threads do not contend on the console.
+void logRecord(const LogRecord &record);
+void reportProgress(const QString &stage);
+// Queue the calling thread's unterminated stream lines and wait until all
+// records queued so far are written.
+void flushLog();
+
+// Streams for code formatting lines with std::wostream, queuing a record per line.
+std::wostream &logStream();
+std::wostream &errorStream();
+
+// Sets the log context of the current thread for its lifetime.
+class LogScope
+{
+public:
+    explicit LogScope(const LogContext &context);
+    ~LogScope();
+
+private:
+    Q_DISABLE_COPY(LogScope)
+
+    const LogContext m_previous;
+};
+
+// Builds a record, queued on destruction. Use by LOG_MESSAGE(level) so that
+// no formatting takes place when the level is disabled:
+// LOG_MESSAGE(LogInfo) << "Updating " << fileName << '.' << LogField("file", filePath);
+class LogMessage
+{
+public:
+    explicit LogMessage(LogLevel level) : m_record(level) {}
+    ~LogMessage() { logRecord(m_record); }
+
+    LogMessage &operator<<(const QString &s) { m_record.text += s; return *this; }
+    LogMessage &operator<<(const char *s) { m_record.text += QLatin1String(s); return *this; }
+    LogMessage &operator<<(char c) { m_record.text += QLatin1Char(c); return *this; }
+    LogMessage &operator<<(QChar c) { m_record.text += c; return *this; }
+    LogMessage &operator<<(int n) { m_record.text += QString::number(n); return *this; }
+    LogMessage &operator<<(unsigned n) { m_record.text += QString::number(n); return *this; }
+    LogMessage &operator<<(qint64 n) { m_record.text += QString::number(n); return *this; }
+    LogMessage &operator<<(const LogField &field) { m_record.fields.append(field); return *this; }
+
+private:
+    Q_DISABLE_COPY(LogMessage)
+
+    LogRecord m_record;
+};
+
+#define LOG_MESSAGE(level) if (!isLogEnabled(level)) {} else LogMessage(level)
+
+QT_END_NAMESPACE
+
+#endif // LOGGING_H
@@ -36,9 +36,38 @@
 #include "jsonoutput.h"
 #include "commandlineparser.h"
 #include "deployment.h"
+#include "batchdeployment.h"
+#include "deploymentstore.h"
+#include "deploymentcache.h"
+#include "qtindex.h"
+#include "qmakequery.h"
+#include "statistics.h"
+#include "tracing.h"
+#include "iostats.h"
+#include "memstats.h"
+
+#include <QtCore/QScopedPointer>
 
 QT_BEGIN_NAMESPACE
 
+// Writes the trace on any return from main().
+class TraceFileWriter
+{
+public:
+    TraceFileWriter(const TraceRecorder *recorder, const QString &fileName)
+        : m_recorder(recorder), m_fileName(fileName) {}
+    ~TraceFileWriter()
+    {
+        QString errorMessage;
+        if (!m_recorder->save(m_fileName, &errorMessage))
+            errorStream() << errorMessage << '\n';
+    }
+
+private:
+    const TraceRecorder *m_recorder;
+    const QString m_fileName;
+};
+
 int main(int argc, char **argv)
 {
     QCoreApplication a(argc, argv);
@@ -55,16 +84,39 @@ int main(int argc, char **argv)
     CommandLineParser clParser;
     Options options;
     QString errorMessage;
-    const QMap<QString, QString> qmakeVariables = queryQMakeAll(&errorMessage);
+    const QStringList arguments = QCoreApplication::arguments();
+    const QString qtPrefix = preParsedArgument(arguments, QStringLiteral("qt-prefix"));
+    // The query runs before "--timings" and "--memstats" are known, its statistics
+    // are always collected.
+    DeploymentStatistics statistics;
+    MemoryStatistics memoryStatistics;
+    const QString traceFile = preParsedArgument(arguments, QStringLiteral("trace"));
+    QScopedPointer<TraceRecorder> trace;
+    QScopedPointer<TraceFileWriter> traceWriter;
+    if (!traceFile.isEmpty()) {
+        trace.reset(new TraceRecorder);
+        traceWriter.reset(new TraceFileWriter(trace.data(), traceFile));
+    }
+    QMap<QString, QString> qmakeVariables;
+    {
+        LogContext queryContext(1, 0, &statistics, trace.data());
+        queryContext.memoryStatistics = &memoryStatistics;
+        const LogScope queryScope(queryContext);
+        const PhaseTimer phaseTimer(QMakeQueryPhase);
+        qmakeVariables = qtPrefix.isEmpty()
+            ? queryQMakeAllCached(preParsedArgument(arguments, QStringLiteral("qmake-query")), &errorMessage)
+            : qmakeVariablesFromPrefix(qtPrefix, &errorMessage);
+    }
     const QString xSpec = qmakeVariables.value(QStringLiteral("QMAKE_XSPEC"));
     options.platform = platformFromMkSpec(xSpec);
     if (options.platform == WindowsMinGW || options.platform == Windows)
         options.compilerRunTime = true;
 
     {   // Command line
-        const int result = clParser.parseArguments(QCoreApplication::arguments(), &options, &errorMessage);
+        const int result = clParser.parseArguments(arguments, &options, &errorMessage);
         if (result & CommandLineParser::CommandLineParseError)
-            std::wcerr << errorMessage << "\n\n";
+            errorStream() << errorMessage << "\n\n";
+        flushLog();
         if (result & CommandLineParser::CommandLineParseHelpRequested)
             std::fputs(qPrintable(clParser.helpText()), stdout);
         if (result & CommandLineParser::CommandLineParseError)
@@ -72,58 +124,140 @@ int main(int argc, char **argv)
         if (result & CommandLineParser::CommandLineParseHelpRequested)
             return 0;
     }
+    if (options.timings)
+        options.statistics = &statistics;
+    options.trace = trace.data();
+    IoStatistics ioStatistics;
+    if (options.ioStats)
+        options.ioStatistics = &ioStatistics;
+    if (options.memoryStats)
+        options.memoryStatistics = &memoryStatistics;
+    LogContext logContext(options.verboseLevel, 0, options.statistics, options.trace);
+    logContext.ioStatistics = options.ioStatistics;
+    logContext.memoryStatistics = options.memoryStatistics;
+    const LogScope logScope(logContext);
 
     if (qmakeVariables.isEmpty() || xSpec.isEmpty() || !qmakeVariables.contains(QStringLiteral("QT_INSTALL_BINS"))) {
-        std::wcerr << "Unable to query qmake: " << errorMessage << '\n';
+        errorStream() << "Unable to query qmake: " << errorMessage << '\n';
         return 1;
     }
 
     if (options.platform == UnknownPlatform) {
-        std::wcerr << "Unsupported platform " << xSpec << '\n';
+        errorStream() << "Unsupported platform " << xSpec << '\n';
         return 1;
     }
 
-    // Create directories
-    if (!createDirectory(options.directory, &errorMessage)) {
-        std::wcerr << errorMessage << '\n';
-        return 1;
-    }
-    if (!options.libraryDirectory.isEmpty() && options.libraryDirectory != options.directory
-        && !createDirectory(options.libraryDirectory, &errorMessage)) {
-        std::wcerr << errorMessage << '\n';
-        return 1;
+    // The index of the Qt installation replaces the scans of the plugin, QML
+    // and translation directories. A stale default index is ignored.
+    DeploymentCache cache;
+    cache.processPool()->setMaxProcesses(options.jobs);
+    const QString qtIndexFile = options.qtIndexFile.isEmpty()
+        ? QtInstallationIndex::defaultFileName(qmakeVariables) : options.qtIndexFile;
+    if (options.createQtIndex) {
+        if (qtIndexFile.isEmpty()) {
+            errorStream() << "Unable to determine the location of the Qt installation index.\n";
+            return 1;
+        }
+        if (!QtInstallationIndex::create(qtIndexFile, qmakeVariables, options.platform, &cache, &errorMessage)) {
+            errorStream() << errorMessage << '\n';
+            return 1;
+        }
+        return 0;
     }
-
-    if (clParser.optWebKit2())
-        options.additionalLibraries |= QtWebKitModule;
-
-    Deployment worker(options, qmakeVariables);
-    const DeployResult result = worker.deploy(options, &errorMessage);
-    if (!result) {
-        std::wcerr << errorMessage << '\n';
+    QtInstallationIndex qtIndex;
+    if (!qtIndexFile.isEmpty() && QFileInfo(qtIndexFile).isFile()) {
+        if (qtIndex.load(qtIndexFile, qmakeVariables, options.platform, &errorMessage)) {
+            cache.setQtIndex(&qtIndex);
+            if (verboseLevel() > 1)
+                logStream() << "Using " << QDir::toNativeSeparators(qtIndexFile) << ".\n";
+        } else if (!options.qtIndexFile.isEmpty()) {
+            errorStream() << errorMessage << '\n';
+            return 1;
+        } else if (verboseLevel()) {
+            logStream() << "Ignoring index: " << errorMessage << '\n';
+        }
+    } else if (!options.qtIndexFile.isEmpty()) {
+        errorStream() << "The Qt installation index " << QDir::toNativeSeparators(qtIndexFile)
+                   << " does not exist.\n";
         return 1;
     }
 
-    if ((clParser.optWebKit2() != CommandLineParser::OptionDisabled)
-        && (clParser.optWebKit2() == CommandLineParser::OptionEnabled
-            || ((result.deployedQtLibraries & QtWebKitModule)
-                && (result.directlyUsedQtLibraries & QtQuickModule)))) {
-        if (optVerboseLevel)
-            std::wcout << "Deploying: " << Options::webKitProcessC << "...\n";
-        if (!worker.deployWebProcess(Options::webKitProcessC, &errorMessage)) {
-            std::wcerr << errorMessage << '\n';
+    QScopedPointer<DeploymentStore> store;
+    if (!options.storeDirectory.isEmpty()) {
+        store.reset(new DeploymentStore(options.storeDirectory));
+        if (options.storeGarbageCollection) {
+            if (!store->collectGarbage(&errorMessage)) {
+                errorStream() << errorMessage << '\n';
+                return 1;
+            }
+            return 0;
+        }
+        if (!store->open(&errorMessage)) {
+            errorStream() << errorMessage << '\n';
             return 1;
         }
+        options.store = store.data();
     }
 
-    if (result.deployedQtLibraries & QtWebEngineModule) {
-        if (!worker.deployWebEngine( &errorMessage)) {
-            std::wcerr << errorMessage << '\n';
+    if (!options.batchManifest.isEmpty()) {
+        QList<BatchEntry> entries;
+        if (!readBatchManifest(options.batchManifest, options.platform, options.verboseLevel, &entries, &errorMessage)) {
+            errorStream() << errorMessage << '\n';
+            return 1;
+        }
+        // The store and the diagnostics are shared by all entries.
+        for (int e = 0; e < entries.size(); ++e) {
+            entries[e].options.store = options.store;
+            entries[e].options.statistics = options.statistics;
+            entries[e].options.trace = options.trace;
+            entries[e].options.ioStatistics = options.ioStatistics;
+            entries[e].options.memoryStatistics = options.memoryStatistics;
+        }
+        const bool success = runBatchDeployment(&entries, qmakeVariables, &cache, options.jobs);
+        if (store && !store->save(&errorMessage)) {
+            errorStream() << errorMessage << '\n';
             return 1;
         }
+        if (options.statistics)
+            logStream() << options.statistics->format();
+        if (options.ioStatistics)
+            logStream() << options.ioStatistics->format();
+        if (options.memoryStatistics)
+            logStream() << options.memoryStatistics->format();
+        return success ? 0 : 1;
+    }
+
+    const DeployResult result = deployApplication(options, qmakeVariables, &cache, &errorMessage);
+    if (store && !store->save(&errorMessage)) {
+        errorStream() << errorMessage << '\n';
+        return 1;
+    }
+    if (!result) {
+        errorStream() << errorMessage << '\n';
+        return 1;
+    }
+
+    if (options.statistics) {
+        if (options.json)
+            options.json->setTimings(options.statistics->toJson());
+        else
+            logStream() << options.statistics->format();
+    }
+    if (options.ioStatistics) {
+        if (options.json)
+            options.json->setIoStatistics(options.ioStatistics->toJson());
+        else
+            logStream() << options.ioStatistics->format();
+    }
+    if (options.memoryStatistics) {
+        if (options.json)
+            options.json->setMemoryStatistics(options.memoryStatistics->toJson());
+        else
+            logStream() << options.memoryStatistics->format();
     }
 
     if (options.json) {
+        flushLog();
         if (options.list)
             std::fputs(options.json->toList(options.list, options.directory).constData(), stdout);
         else
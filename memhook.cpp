@@ -0,0 +1,104 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+// Counting allocator hook of the "CONFIG+=memstats" build, see memstats.h.
+// With glibc, malloc() and friends are interposed, which also covers the
+// containers of QtCore and operator new. Elsewhere, operator new is replaced,
+// which counts the allocations of this executable only.
+
+#include "memstats.h"
+
+#include <new>
+#include <stdlib.h>
+
+#ifdef __GLIBC__
+
+extern "C" {
+
+// The glibc implementations, which also serve memalign() and friends.
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *pointer, size_t size);
+void __libc_free(void *pointer);
+
+void *malloc(size_t size) Q_DECL_NOTHROW
+{
+    QT_PREPEND_NAMESPACE(countAllocation)(size);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) Q_DECL_NOTHROW
+{
+    QT_PREPEND_NAMESPACE(countAllocation)(count * size);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, size_t size) Q_DECL_NOTHROW
+{
+    QT_PREPEND_NAMESPACE(countAllocation)(size);
+    return __libc_realloc(pointer, size);
+}
+
+void free(void *pointer) Q_DECL_NOTHROW
+{
+    __libc_free(pointer);
+}
+
+} // extern "C"
+
+#else // __GLIBC__
+
+void *operator new(size_t size)
+{
+    QT_PREPEND_NAMESPACE(countAllocation)(size);
+    if (void *result = malloc(size ? size : 1))
+        return result;
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *pointer) Q_DECL_NOTHROW
+{
+    free(pointer);
+}
+
+void operator delete[](void *pointer) Q_DECL_NOTHROW
+{
+    free(pointer);
+}
+
+#endif // !__GLIBC__
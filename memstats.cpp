@@ -0,0 +1,182 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "memstats.h"
+
+#include <QtCore/QJsonArray>
+
+#ifdef Q_OS_WIN
+#  include <qt_windows.h>
+#  include <psapi.h>
+#else
+#  include <sys/resource.h>
+#  include <sys/time.h>
+#endif
+
+#ifdef Q_CC_MSVC
+#  define WINDEPLOYQT_THREAD_LOCAL __declspec(thread)
+#else
+#  define WINDEPLOYQT_THREAD_LOCAL __thread
+#endif
+
+QT_BEGIN_NAMESPACE
+
+MemoryStatistics::MemoryStatistics()
+{
+    for (int p = 0; p < PhaseCount; ++p) {
+        m_allocations[p].store(0);
+        m_allocatedBytes[p].store(0);
+        m_peakResidentSizes[p].store(0);
+    }
+}
+
+bool MemoryStatistics::isAllocationCountingAvailable()
+{
+#ifdef WINDEPLOYQT_MEMSTATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+void MemoryStatistics::updatePeakResidentSize(DeploymentPhase phase)
+{
+    const qint64 peak = peakResidentSetSize();
+    forever {
+        const qint64 previous = m_peakResidentSizes[phase].load();
+        if (peak <= previous || m_peakResidentSizes[phase].testAndSetRelaxed(previous, peak))
+            break;
+    }
+}
+
+QString MemoryStatistics::format() const
+{
+    const bool counting = isAllocationCountingAvailable();
+    QList<QStringList> rows;
+    QStringList row;
+    row << QStringLiteral("Phase") << QStringLiteral("Peak RSS");
+    if (counting)
+        row << QStringLiteral("Allocations") << QStringLiteral("Allocated bytes");
+    rows.append(row);
+    for (int p = 0; p < PhaseCount; ++p) {
+        const DeploymentPhase phase = DeploymentPhase(p);
+        if (!peakResidentSize(phase) && !allocations(phase))
+            continue;
+        row.clear();
+        row << QLatin1String(DeploymentStatistics::phaseName(phase))
+            << QString::number(peakResidentSize(phase));
+        if (counting)
+            row << QString::number(allocations(phase)) << QString::number(allocatedBytes(phase));
+        rows.append(row);
+    }
+    QString result = formatStatisticsTable(rows, 1);
+    result += QStringLiteral("Peak RSS: ") + QString::number(peakResidentSetSize()) + QStringLiteral(" bytes");
+    if (!counting)
+        result += QStringLiteral(" (build with CONFIG+=memstats to count allocations)");
+    result += QLatin1Char('\n');
+    return result;
+}
+
+QJsonObject MemoryStatistics::toJson() const
+{
+    QJsonArray phases;
+    for (int p = 0; p < PhaseCount; ++p) {
+        const DeploymentPhase phase = DeploymentPhase(p);
+        if (!peakResidentSize(phase) && !allocations(phase))
+            continue;
+        QJsonObject object;
+        object.insert(QStringLiteral("name"), QLatin1String(DeploymentStatistics::phaseName(phase)));
+        object.insert(QStringLiteral("peakRss"), double(peakResidentSize(phase)));
+        if (isAllocationCountingAvailable()) {
+            object.insert(QStringLiteral("allocations"), double(allocations(phase)));
+            object.insert(QStringLiteral("allocatedBytes"), double(allocatedBytes(phase)));
+        }
+        phases.append(object);
+    }
+    QJsonObject result;
+    result.insert(QStringLiteral("peakRss"), double(peakResidentSetSize()));
+    result.insert(QStringLiteral("allocationCounting"), isAllocationCountingAvailable());
+    result.insert(QStringLiteral("phases"), phases);
+    return result;
+}
+
+qint64 peakResidentSetSize()
+{
+#ifdef Q_OS_WIN
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return 0;
+    return qint64(counters.PeakWorkingSetSize);
+#else // Q_OS_WIN
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+#  ifdef Q_OS_MAC
+    return qint64(usage.ru_maxrss); // Bytes.
+#  else
+    return qint64(usage.ru_maxrss) * 1024; // Kilobytes.
+#  endif
+#endif // !Q_OS_WIN
+}
+
+namespace {
+
+// Plain data, initialized without running code on thread creation.
+struct AllocationContext
+{
+    MemoryStatistics *statistics;
+    int phase;
+    bool counting; // Guards against allocations made while counting.
+};
+
+} // namespace
+
+static WINDEPLOYQT_THREAD_LOCAL AllocationContext allocationContext;
+
+void setAllocationContext(MemoryStatistics *statistics, int phase)
+{
+    allocationContext.statistics = statistics;
+    allocationContext.phase = phase;
+}
+
+void countAllocation(size_t size)
+{
+    AllocationContext &context = allocationContext;
+    if (context.statistics && !context.counting) {
+        context.counting = true;
+        context.statistics->addAllocation(DeploymentPhase(context.phase), qint64(size));
+        context.counting = false;
+    }
+}
+
+QT_END_NAMESPACE
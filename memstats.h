@@ -0,0 +1,88 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef MEMSTATS_H
+#define MEMSTATS_H
+
+#include "statistics.h"
+
+#include <stddef.h>
+
+QT_BEGIN_NAMESPACE
+
+// Peak resident set size and allocations per phase, reported by "--memstats".
+// Allocations are counted in builds configured with "CONFIG+=memstats" only,
+// which link a counting allocator hook (memhook.cpp) into the application.
+class MemoryStatistics
+{
+public:
+    MemoryStatistics();
+
+    static bool isAllocationCountingAvailable();
+
+    void addAllocation(DeploymentPhase phase, qint64 bytes)
+    {
+        m_allocations[phase].fetchAndAddRelaxed(1);
+        m_allocatedBytes[phase].fetchAndAddRelaxed(bytes);
+    }
+    // Record the peak resident set size of the process at the end of a phase.
+    void updatePeakResidentSize(DeploymentPhase phase);
+
+    qint64 allocations(DeploymentPhase phase) const { return m_allocations[phase].load(); }
+    qint64 allocatedBytes(DeploymentPhase phase) const { return m_allocatedBytes[phase].load(); }
+    qint64 peakResidentSize(DeploymentPhase phase) const { return m_peakResidentSizes[phase].load(); }
+
+    QString format() const;
+    QJsonObject toJson() const;
+
+private:
+    Q_DISABLE_COPY(MemoryStatistics)
+
+    QAtomicInteger<qint64> m_allocations[PhaseCount];
+    QAtomicInteger<qint64> m_allocatedBytes[PhaseCount];
+    QAtomicInteger<qint64> m_peakResidentSizes[PhaseCount];
+};
+
+// Peak resident set size (working set on Windows) of the process in bytes.
+qint64 peakResidentSetSize();
+
+// Called by LogScope to mirror the memory statistics and the phase of the
+// log context into native thread-local storage, which the allocator hook can
+// read without allocating.
+void setAllocationContext(MemoryStatistics *statistics, int phase);
+// Called by the allocator hook.
+void countAllocation(size_t size);
+
+QT_END_NAMESPACE
+
+#endif // MEMSTATS_H
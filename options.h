@@ -39,6 +39,11 @@
 QT_BEGIN_NAMESPACE
 
 class JsonOutput;
+class DeploymentStore;
+class DeploymentStatistics;
+class TraceRecorder;
+class IoStatistics;
+class MemoryStatistics;
 
 struct Options {
     enum DebugDetection {
@@ -53,10 +58,30 @@ struct Options {
         AngleDetectionForceOff
     };
 
+    enum WebKit2Deployment {
+        WebKit2DeploymentAuto,
+        WebKit2DeploymentForceOn,
+        WebKit2DeploymentForceOff
+    };
+
+    enum SharedRuntimeMode {
+        SharedRuntimeHardLinks, // Hard link libraries and plugins into the application directory.
+        SharedRuntimeQtConf     // Hard link libraries, point to the plugins by qt.conf.
+    };
+
+    enum QmlImportScanner {
+        QmlImportScannerExternal, // qmlimportscanner
+        QmlImportScannerBuiltin
+    };
+
     Options() : plugins(true), libraries(true), quickImports(true), translations(true), systemD3dCompiler(true), compilerRunTime(false)
               , angleDetection(AngleDetectionAuto), platform(Windows), additionalLibraries(0), disabledLibraries(0)
               , updateFileFlags(0), json(0), list(ListNone), debugDetection(DebugDetectionAuto)
-              , debugMatchAll(false) {}
+              , debugMatchAll(false), webKit2(WebKit2DeploymentAuto), verboseLevel(1), jobs(0)
+              , sharedRuntimeMode(SharedRuntimeHardLinks), storeGarbageCollection(false), store(0)
+              , createQtIndex(false), qmlImportScanner(QmlImportScannerExternal)
+              , qmlScanCache(true), pruneQml(false), qmlCache(false), timings(false), statistics(0), trace(0)
+              , ioStats(false), ioStatistics(0), memoryStats(false), memoryStatistics(0) {}
 
     bool plugins;
     bool libraries;
@@ -72,12 +97,36 @@ struct Options {
     QStringList qmlDirectories; // Project's QML files.
     QString directory;
     QString translationsDirectory; // Translations target directory
+    QStringList languages; // Translation languages to deploy, all if empty.
     QString libraryDirectory;
     QStringList binaries;
     JsonOutput *json;
     ListOption list;
     DebugDetection debugDetection;
     bool debugMatchAll;
+    WebKit2Deployment webKit2;
+    QString batchManifest; // JSON file listing applications to be deployed in one run.
+    int verboseLevel;
+    int jobs; // Maximum number of parallel jobs, 0: number of processors.
+    QString sharedRuntimeDirectory; // Qt libraries and plugins shared by several applications.
+    SharedRuntimeMode sharedRuntimeMode;
+    QString storeDirectory; // Content-addressed store of deployed files.
+    bool storeGarbageCollection;
+    DeploymentStore *store;
+    QString qtIndexFile; // Index of the Qt installation, default: in the cache location.
+    bool createQtIndex;
+    QmlImportScanner qmlImportScanner;
+    bool qmlScanCache; // Reuse the QML import scan results of unchanged directories.
+    bool pruneQml; // Deploy only the QML files reachable from the application.
+    bool qmlCache; // Compile the deployed QML files ahead of time.
+    bool timings; // Report the time and counters per phase.
+    DeploymentStatistics *statistics;
+    QString traceFile; // Chrome trace event file.
+    TraceRecorder *trace;
+    bool ioStats; // Report the I/O calls per phase and storage.
+    IoStatistics *ioStatistics;
+    bool memoryStats; // Report the peak RSS and the allocations per phase.
+    MemoryStatistics *memoryStatistics;
 
     static const char webKitProcessC[];
     static const char webEngineProcessC[];
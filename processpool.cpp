@@ -0,0 +1,136 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "processpool.h"
+#include "utils.h"
+
+#include <QtCore/QMutex>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QRunnable>
+#include <QtCore/QThread>
+#include <QtCore/QWaitCondition>
+
+QT_BEGIN_NAMESPACE
+
+struct ProcessFuture::Data {
+    Data() : finished(false) {}
+
+    mutable QMutex mutex;
+    mutable QWaitCondition condition;
+    bool finished;
+    ProcessResult result;
+};
+
+bool ProcessFuture::isFinished() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->finished;
+}
+
+void ProcessFuture::waitForFinished() const
+{
+    QMutexLocker locker(&d->mutex);
+    while (!d->finished)
+        d->condition.wait(&d->mutex);
+}
+
+const ProcessResult &ProcessFuture::result() const
+{
+    waitForFinished();
+    return d->result; // Not modified after finishing.
+}
+
+namespace {
+
+class ProcessTask : public QRunnable
+{
+public:
+    ProcessTask(const QString &binary, const QStringList &arguments, const QString &workingDirectory,
+                const QSharedPointer<ProcessFuture::Data> &data)
+        : m_binary(binary), m_arguments(arguments), m_workingDirectory(workingDirectory), m_data(data)
+        , m_logContext(currentLogContext()) {}
+
+    void run() Q_DECL_OVERRIDE
+    {
+        const LogScope logScope(m_logContext);
+        ProcessResult result;
+        result.started = runProcess(m_binary, m_arguments, m_workingDirectory, &result.exitCode,
+                                    &result.stdOut, &result.stdErr, &result.errorMessage);
+        QMutexLocker locker(&m_data->mutex);
+        m_data->result = result;
+        m_data->finished = true;
+        m_data->condition.wakeAll();
+    }
+
+private:
+    const QString m_binary;
+    const QStringList m_arguments;
+    const QString m_workingDirectory;
+    const QSharedPointer<ProcessFuture::Data> m_data;
+    const LogContext m_logContext;
+};
+
+} // namespace
+
+ProcessPool::ProcessPool(int maxProcesses)
+{
+    setMaxProcesses(maxProcesses);
+}
+
+ProcessPool::~ProcessPool()
+{
+    waitForDone();
+}
+
+void ProcessPool::setMaxProcesses(int maxProcesses)
+{
+    m_threadPool.setMaxThreadCount(maxProcesses > 0 ? maxProcesses : QThread::idealThreadCount());
+}
+
+ProcessFuture ProcessPool::start(const QString &binary, const QStringList &arguments,
+                                 const QString &workingDirectory)
+{
+    ProcessFuture future;
+    future.d = QSharedPointer<ProcessFuture::Data>(new ProcessFuture::Data);
+    if (verboseLevel() > 1)
+        logStream() << "Starting " << binary << ' ' << arguments.join(QLatin1Char(' ')) << '\n';
+    m_threadPool.start(new ProcessTask(binary, arguments, workingDirectory, future.d));
+    return future;
+}
+
+void ProcessPool::waitForDone()
+{
+    m_threadPool.waitForDone();
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,98 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef PROCESSPOOL_H
+#define PROCESSPOOL_H
+
+#include "types.h"
+
+#include <QtCore/QSharedPointer>
+#include <QtCore/QThreadPool>
+
+QT_BEGIN_NAMESPACE
+
+struct ProcessResult {
+    ProcessResult() : started(false), exitCode(0) {}
+
+    bool started; // false: errorMessage tells why.
+    unsigned long exitCode;
+    QByteArray stdOut;
+    QByteArray stdErr;
+    QString errorMessage;
+};
+
+// Handle to a process run by ProcessPool. Default-constructed handles are invalid.
+class ProcessFuture
+{
+public:
+    ProcessFuture() {}
+
+    bool isValid() const { return !d.isNull(); }
+    bool isFinished() const;
+    void waitForFinished() const;
+    // Waits for the process to finish.
+    const ProcessResult &result() const;
+
+    struct Data; // Shared with the running task.
+
+private:
+    friend class ProcessPool;
+
+    QSharedPointer<Data> d;
+};
+
+// Runs external tools (runProcess()) asynchronously, at most maxProcesses at a
+// time (0: number of processors), capturing their output per job. Independent
+// tool runs overlap with each other and with the caller's work. Thread-safe.
+class ProcessPool
+{
+public:
+    explicit ProcessPool(int maxProcesses = 0);
+    ~ProcessPool();
+
+    int maxProcesses() const { return m_threadPool.maxThreadCount(); }
+    void setMaxProcesses(int maxProcesses);
+
+    ProcessFuture start(const QString &binary, const QStringList &arguments,
+                        const QString &workingDirectory = QString());
+    void waitForDone();
+
+private:
+    Q_DISABLE_COPY(ProcessPool)
+
+    QThreadPool m_threadPool;
+};
+
+QT_END_NAMESPACE
+
+#endif // PROCESSPOOL_H
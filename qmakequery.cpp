@@ -0,0 +1,265 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qmakequery.h"
+#include "utils.h"
+
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDataStream>
+#include <QtCore/QSaveFile>
+#include <QtCore/QSettings>
+#include <QtCore/QStandardPaths>
+#include <QtCore/QTextStream>
+
+QT_BEGIN_NAMESPACE
+
+static const quint32 queryCacheMagic = 0x51514341; // "QQCA"
+static const quint32 queryCacheVersion = 1;
+
+static inline QString fileKey(const QFileInfo &fileInfo)
+{
+    return fileInfo.exists()
+        ? QString::number(fileInfo.lastModified().toMSecsSinceEpoch()) + QLatin1Char(',') + QString::number(fileInfo.size())
+        : QStringLiteral("-");
+}
+
+static bool readQMakeQueryFile(const QString &fileName, QMap<QString, QString> *variables,
+                               QString *errorMessage)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *errorMessage = QString::fromLatin1("Cannot open %1: %2")
+                        .arg(QDir::toNativeSeparators(fileName), file.errorString());
+        return false;
+    }
+    *variables = parseQMakeQuery(file.readAll());
+    if (variables->isEmpty()) {
+        *errorMessage = QString::fromLatin1("%1 does not contain any qmake variables.")
+                        .arg(QDir::toNativeSeparators(fileName));
+        return false;
+    }
+    return true;
+}
+
+QMap<QString, QString> queryQMakeAllCached(const QString &queryFile, QString *errorMessage)
+{
+    QMap<QString, QString> result;
+    const QString fileName = queryFile.isEmpty()
+        ? QString::fromLocal8Bit(qgetenv("WINDEPLOYQT_QMAKE_QUERY")) : queryFile;
+    if (!fileName.isEmpty()) {
+        if (!readQMakeQueryFile(fileName, &result, errorMessage))
+            result.clear();
+        return result;
+    }
+
+#ifdef Q_OS_WIN
+    const QString qmake = findInPath(QStringLiteral("qmake.exe"));
+#else // Q_OS_WIN
+    const QString qmake = findInPath(QStringLiteral("qmake"));
+#endif // !Q_OS_WIN
+    const QString cacheLocation = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (qmake.isEmpty() || cacheLocation.isEmpty())
+        return queryQMakeAll(errorMessage);
+
+    // qmake reads the qt.conf next to its (resolved) binary.
+    const QFileInfo qmakeInfo(QFileInfo(qmake).canonicalFilePath());
+    const QString key = qmakeInfo.absoluteFilePath() + QLatin1Char('|') + fileKey(qmakeInfo)
+        + QLatin1Char('|') + fileKey(QFileInfo(qmakeInfo.absolutePath() + QStringLiteral("/qt.conf")));
+    const QByteArray hash = QCryptographicHash::hash(qmakeInfo.absoluteFilePath().toUtf8(), QCryptographicHash::Sha1).toHex();
+    const QString cacheFileName = cacheLocation + QStringLiteral("/qmake-") + QString::fromLatin1(hash.left(16))
+                                  + QStringLiteral(".dat");
+
+    QFile cacheFile(cacheFileName);
+    if (cacheFile.open(QIODevice::ReadOnly)) {
+        QDataStream str(&cacheFile);
+        str.setVersion(QDataStream::Qt_5_0);
+        quint32 magic;
+        quint32 version;
+        QString cachedKey;
+        str >> magic >> version >> cachedKey;
+        if (str.status() == QDataStream::Ok && magic == queryCacheMagic
+            && version == queryCacheVersion && cachedKey == key) {
+            str >> result;
+            if (str.status() == QDataStream::Ok && !result.isEmpty())
+                return result;
+        }
+        result.clear();
+        cacheFile.close();
+    }
+
+    result = queryQMakeAll(errorMessage);
+    if (result.isEmpty())
+        return result;
+    // Failing to write the cache is not an error.
+    QDir().mkpath(cacheLocation);
+    QSaveFile saveFile(cacheFileName);
+    if (saveFile.open(QIODevice::WriteOnly)) {
+        QDataStream str(&saveFile);
+        str.setVersion(QDataStream::Qt_5_0);
+        str << queryCacheMagic << queryCacheVersion << key << result;
+        if (str.status() == QDataStream::Ok)
+            saveFile.commit();
+    }
+    return result;
+}
+
+// Read the plain "NAME = value" assignments of a qmake project include file,
+// ignoring scopes.
+static QMap<QString, QString> readPriAssignments(const QString &fileName)
+{
+    QMap<QString, QString> result;
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return result;
+    QTextStream str(&file);
+    while (!str.atEnd()) {
+        const QString line = str.readLine().trimmed();
+        const int equalsPos = line.indexOf(QLatin1Char('='));
+        if (line.startsWith(QLatin1Char('#')) || equalsPos <= 0)
+            continue;
+        const QString name = line.left(equalsPos).trimmed();
+        if (name.contains(QLatin1Char(' ')) || name.endsWith(QLatin1Char('+'))
+            || name.endsWith(QLatin1Char('-')) || name.endsWith(QLatin1Char('*'))) {
+            continue; // Scoped or modifying assignment.
+        }
+        result.insert(name, line.mid(equalsPos + 1).trimmed());
+    }
+    return result;
+}
+
+static QString xSpecFromLibraries(const QString &binDir, const QString &libDir)
+{
+    if (!QDir(binDir).entryList(QStringList(QStringLiteral("Qt5Core*.dll")), QDir::Files).isEmpty()) {
+        // MinGW builds have import libraries "libQt5Core.a".
+        return QDir(libDir).entryList(QStringList(QStringLiteral("libQt5Core*.a")), QDir::Files).isEmpty()
+            ? QStringLiteral("win32-msvc") : QStringLiteral("win32-g++");
+    }
+    if (!QDir(libDir).entryList(QStringList(QStringLiteral("libQt5Core*.so*")), QDir::Files).isEmpty())
+        return QStringLiteral("linux-g++");
+    return QString();
+}
+
+QMap<QString, QString> qmakeVariablesFromPrefix(const QString &prefix, QString *errorMessage)
+{
+    QMap<QString, QString> result;
+    const QDir prefixDir(QDir::cleanPath(QFileInfo(prefix).absoluteFilePath()));
+    const QString mkspecs = prefixDir.filePath(QStringLiteral("mkspecs"));
+    const QString qconfigPri = mkspecs + QStringLiteral("/qconfig.pri");
+    if (!QFileInfo(qconfigPri).isFile()) {
+        *errorMessage = QString::fromLatin1("%1 does not appear to be a Qt installation (%2 not found).")
+                        .arg(QDir::toNativeSeparators(prefixDir.absolutePath()),
+                             QDir::toNativeSeparators(qconfigPri));
+        return result;
+    }
+
+    // Paths of the qt.conf the installation's tools would read, relative to the prefix.
+    QMap<QString, QString> qtConfPaths;
+    const QString qtConf = prefixDir.filePath(QStringLiteral("bin/qt.conf"));
+    if (QFileInfo(qtConf).isFile()) {
+        QSettings settings(qtConf, QSettings::IniFormat);
+        settings.beginGroup(QStringLiteral("Paths"));
+        foreach (const QString &key, settings.childKeys())
+            qtConfPaths.insert(key, settings.value(key).toString());
+        settings.endGroup();
+    }
+
+    struct PathEntry {
+        const char *variable;
+        const char *qtConfKey;
+        const char *defaultPath;
+    };
+    static const PathEntry pathEntries[] = {
+        {"QT_INSTALL_ARCHDATA", "ArchData", "."},
+        {"QT_INSTALL_DATA", "Data", "."},
+        {"QT_INSTALL_DOCS", "Documentation", "doc"},
+        {"QT_INSTALL_HEADERS", "Headers", "include"},
+        {"QT_INSTALL_LIBS", "Libraries", "lib"},
+#ifdef Q_OS_WIN
+        {"QT_INSTALL_LIBEXECS", "LibraryExecutables", "bin"},
+#else // Q_OS_WIN
+        {"QT_INSTALL_LIBEXECS", "LibraryExecutables", "libexec"},
+#endif // !Q_OS_WIN
+        {"QT_INSTALL_BINS", "Binaries", "bin"},
+        {"QT_INSTALL_TESTS", "Tests", "tests"},
+        {"QT_INSTALL_PLUGINS", "Plugins", "plugins"},
+        {"QT_INSTALL_IMPORTS", "Imports", "imports"},
+        {"QT_INSTALL_QML", "Qml2Imports", "qml"},
+        {"QT_INSTALL_TRANSLATIONS", "Translations", "translations"},
+        {"QT_INSTALL_CONFIGURATION", "Settings", "."},
+        {"QT_INSTALL_EXAMPLES", "Examples", "examples"},
+        {"QT_INSTALL_DEMOS", "Examples", "examples"}
+    };
+    const QString prefixPath = prefixDir.absolutePath();
+    result.insert(QStringLiteral("QT_INSTALL_PREFIX"), prefixPath);
+    result.insert(QStringLiteral("QT_HOST_PREFIX"), prefixPath);
+    for (size_t i = 0; i < sizeof(pathEntries) / sizeof(pathEntries[0]); ++i) {
+        const QString path = qtConfPaths.value(QLatin1String(pathEntries[i].qtConfKey),
+                                               QLatin1String(pathEntries[i].defaultPath));
+        result.insert(QLatin1String(pathEntries[i].variable),
+                      QDir::cleanPath(QDir::isAbsolutePath(path) ? path : prefixDir.filePath(path)));
+    }
+    result.insert(QStringLiteral("QT_HOST_DATA"), result.value(QStringLiteral("QT_INSTALL_ARCHDATA")));
+    result.insert(QStringLiteral("QT_HOST_BINS"), result.value(QStringLiteral("QT_INSTALL_BINS")));
+    result.insert(QStringLiteral("QT_HOST_LIBS"), result.value(QStringLiteral("QT_INSTALL_LIBS")));
+
+    const QMap<QString, QString> qconfig = readPriAssignments(qconfigPri);
+    QString version = qconfig.value(QStringLiteral("QT_VERSION"));
+    if (version.isEmpty()) {
+        const QMap<QString, QString> corePri = readPriAssignments(mkspecs + QStringLiteral("/modules/qt_lib_core.pri"));
+        version = corePri.value(QStringLiteral("QT.core.VERSION"));
+    }
+    if (version.isEmpty()) {
+        *errorMessage = QString::fromLatin1("Unable to determine the Qt version from %1.")
+                        .arg(QDir::toNativeSeparators(qconfigPri));
+        result.clear();
+        return result;
+    }
+    result.insert(QStringLiteral("QT_VERSION"), version);
+
+    QString xSpec = qtConfPaths.value(QStringLiteral("TargetSpec"));
+    if (xSpec.isEmpty())
+        xSpec = xSpecFromLibraries(result.value(QStringLiteral("QT_INSTALL_BINS")),
+                                   result.value(QStringLiteral("QT_INSTALL_LIBS")));
+    if (xSpec.isEmpty()) {
+        *errorMessage = QString::fromLatin1("Unable to determine the target platform of %1, "
+                                            "specify \"TargetSpec\" in %2.")
+                        .arg(QDir::toNativeSeparators(prefixPath), QDir::toNativeSeparators(qtConf));
+        result.clear();
+        return result;
+    }
+    result.insert(QStringLiteral("QMAKE_XSPEC"), xSpec);
+    result.insert(QStringLiteral("QMAKE_SPEC"), qtConfPaths.value(QStringLiteral("HostSpec"), xSpec));
+    return result;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,60 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QMAKEQUERY_H
+#define QMAKEQUERY_H
+
+#include "types.h"
+
+QT_BEGIN_NAMESPACE
+
+// Return the qmake variables ("qmake -query") without necessarily running qmake:
+// They are read from queryFile or, if that is empty, from the file named by the
+// environment variable WINDEPLOYQT_QMAKE_QUERY (both containing the output of
+// "qmake -query"). Otherwise, the result of running qmake is cached in the
+// cache location, keyed by the qmake binary found in PATH, its modification
+// time and that of the qt.conf next to it. Properties set by "qmake -set" are
+// not tracked.
+QMap<QString, QString> queryQMakeAllCached(const QString &queryFile, QString *errorMessage);
+
+// Compute the qmake variables of the Qt installation in prefix from its files
+// instead of running qmake: The installation paths are taken from the
+// "[Paths]" of bin/qt.conf relative to prefix or the default layout, the
+// version from mkspecs/qconfig.pri or the QtCore module .pri file. QMAKE_XSPEC
+// is taken from the "TargetSpec" of qt.conf or determined from the QtCore
+// libraries present.
+QMap<QString, QString> qmakeVariablesFromPrefix(const QString &prefix, QString *errorMessage);
+
+QT_END_NAMESPACE
+
+#endif // QMAKEQUERY_H
@@ -0,0 +1,201 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qmcatalog.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QSaveFile>
+#include <QtCore/QVector>
+#include <QtCore/QtEndian>
+
+#include <algorithm>
+
+#include <string.h>
+
+QT_BEGIN_NAMESPACE
+
+// Format as written by lrelease (see QTranslator): magic followed by sections
+// of a tag byte, a big endian 32bit length and the data.
+static const uchar qmMagic[16] = {
+    0x3c, 0xb8, 0x64, 0x18, 0xca, 0xef, 0x9c, 0x95,
+    0xcd, 0x21, 0x1c, 0xbf, 0x60, 0xa1, 0xbd, 0xdd
+};
+
+enum QmSectionTag {
+    QmContexts = 0x2f,
+    QmHashes = 0x42,
+    QmMessages = 0x69,
+    QmNumerusRules = 0x88,
+    QmDependencies = 0x96,
+    QmLanguage = 0xa7
+};
+
+struct QmCatalog {
+    QByteArray language;
+    QByteArray numerusRules;
+    QByteArray hashes; // Pairs of (hash, offset into messages) sorted by hash.
+    QByteArray messages;
+};
+
+struct QmHashEntry {
+    QmHashEntry() : hash(0), offset(0) {}
+    QmHashEntry(quint32 h, quint32 o) : hash(h), offset(o) {}
+
+    quint32 hash;
+    quint32 offset;
+};
+
+static inline bool hashLessThan(const QmHashEntry &e1, const QmHashEntry &e2)
+{
+    return e1.hash < e2.hash;
+}
+
+static bool readQmCatalog(const QString &fileName, QmCatalog *catalog, QString *errorMessage)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *errorMessage = QString::fromLatin1("Cannot open %1: %2")
+                        .arg(QDir::toNativeSeparators(fileName), file.errorString());
+        return false;
+    }
+    const QByteArray data = file.readAll();
+    const uchar *begin = reinterpret_cast<const uchar *>(data.constData());
+    const uchar *end = begin + data.size();
+    if (data.size() < int(sizeof(qmMagic)) || memcmp(begin, qmMagic, sizeof(qmMagic))) {
+        *errorMessage = QString::fromLatin1("%1 is not a translation catalog.")
+                        .arg(QDir::toNativeSeparators(fileName));
+        return false;
+    }
+    for (const uchar *p = begin + sizeof(qmMagic); p < end; ) {
+        if (end - p < 5) {
+            *errorMessage = QString::fromLatin1("%1 is truncated.").arg(QDir::toNativeSeparators(fileName));
+            return false;
+        }
+        const uchar tag = *p;
+        const quint32 length = qFromBigEndian<quint32>(p + 1);
+        p += 5;
+        if (quint32(end - p) < length) {
+            *errorMessage = QString::fromLatin1("%1 is truncated.").arg(QDir::toNativeSeparators(fileName));
+            return false;
+        }
+        const QByteArray section(reinterpret_cast<const char *>(p), int(length));
+        switch (tag) {
+        case QmLanguage:
+            catalog->language = section;
+            break;
+        case QmNumerusRules:
+            catalog->numerusRules = section;
+            break;
+        case QmHashes:
+            catalog->hashes = section;
+            break;
+        case QmMessages:
+            catalog->messages = section;
+            break;
+        case QmContexts:
+            break;
+        case QmDependencies:
+            *errorMessage = QString::fromLatin1("%1 has dependencies.").arg(QDir::toNativeSeparators(fileName));
+            return false;
+        default:
+            *errorMessage = QString::fromLatin1("%1 has an unknown section 0x%2.")
+                            .arg(QDir::toNativeSeparators(fileName)).arg(uint(tag), 0, 16);
+            return false;
+        }
+        p += length;
+    }
+    if (catalog->hashes.size() % 8) {
+        *errorMessage = QString::fromLatin1("%1 has an invalid hash table.").arg(QDir::toNativeSeparators(fileName));
+        return false;
+    }
+    return true;
+}
+
+static void writeQmSection(QByteArray *data, QmSectionTag tag, const QByteArray &section)
+{
+    uchar header[5];
+    header[0] = uchar(tag);
+    qToBigEndian<quint32>(quint32(section.size()), header + 1);
+    data->append(reinterpret_cast<const char *>(header), sizeof(header));
+    data->append(section);
+}
+
+bool mergeQmFiles(const QStringList &inputFiles, const QString &outputFile, QString *errorMessage)
+{
+    QByteArray language;
+    QByteArray numerusRules;
+    QByteArray messages;
+    QVector<QmHashEntry> hashes;
+    foreach (const QString &inputFile, inputFiles) {
+        QmCatalog catalog;
+        if (!readQmCatalog(inputFile, &catalog, errorMessage))
+            return false;
+        if (language.isEmpty())
+            language = catalog.language;
+        if (numerusRules.isEmpty())
+            numerusRules = catalog.numerusRules;
+        const quint32 base = quint32(messages.size());
+        const uchar *entry = reinterpret_cast<const uchar *>(catalog.hashes.constData());
+        for (int i = 0, count = catalog.hashes.size() / 8; i < count; ++i, entry += 8)
+            hashes.append(QmHashEntry(qFromBigEndian<quint32>(entry), base + qFromBigEndian<quint32>(entry + 4)));
+        messages += catalog.messages;
+    }
+    // QTranslator does a binary search on the hashes and then checks all messages
+    // of equal hash in order, keep the order of the input files for those.
+    std::stable_sort(hashes.begin(), hashes.end(), hashLessThan);
+    QByteArray hashData(hashes.size() * 8, Qt::Uninitialized);
+    uchar *entry = reinterpret_cast<uchar *>(hashData.data());
+    foreach (const QmHashEntry &hashEntry, hashes) {
+        qToBigEndian<quint32>(hashEntry.hash, entry);
+        qToBigEndian<quint32>(hashEntry.offset, entry + 4);
+        entry += 8;
+    }
+
+    QByteArray data(reinterpret_cast<const char *>(qmMagic), sizeof(qmMagic));
+    if (!language.isEmpty())
+        writeQmSection(&data, QmLanguage, language);
+    if (!numerusRules.isEmpty())
+        writeQmSection(&data, QmNumerusRules, numerusRules);
+    writeQmSection(&data, QmHashes, hashData);
+    writeQmSection(&data, QmMessages, messages);
+
+    QSaveFile file(outputFile);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+        *errorMessage = QString::fromLatin1("Cannot write %1: %2")
+                        .arg(QDir::toNativeSeparators(outputFile), file.errorString());
+        return false;
+    }
+    return true;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,101 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qmlcachegen.h"
+#include "jsonoutput.h"
+#include "processpool.h"
+#include "utils.h"
+
+QT_BEGIN_NAMESPACE
+
+QString findQmlCacheGenerator(const QString &qtBinDir)
+{
+#ifdef Q_OS_WIN
+    const QString binary = qtBinDir + QStringLiteral("/qmlcachegen.exe");
+#else // Q_OS_WIN
+    const QString binary = qtBinDir + QStringLiteral("/qmlcachegen");
+#endif // !Q_OS_WIN
+    return QFileInfo(binary).isFile() ? binary : QString();
+}
+
+static inline QString cacheFileName(const QString &fileName)
+{
+    return fileName + QLatin1Char('c'); // "main.qml" -> "main.qmlc", "code.js" -> "code.jsc"
+}
+
+void generateQmlCache(const QString &qmlCacheGenerator, const QStringList &files, ProcessPool *pool,
+                      unsigned updateFileFlags, JsonOutput *json)
+{
+    QStringList outdatedFiles;
+    QStringList upToDate;
+    foreach (const QString &fileName, files) {
+        const QFileInfo cacheFileInfo(cacheFileName(fileName));
+        if (!(updateFileFlags & ForceUpdateFile) && cacheFileInfo.exists()
+            && cacheFileInfo.lastModified() >= QFileInfo(fileName).lastModified()) {
+            upToDate.append(fileName);
+        } else {
+            outdatedFiles.append(fileName);
+        }
+    }
+    if (verboseLevel())
+        logStream() << "Generating QML cache for " << outdatedFiles.size() << " of " << files.size() << " files...\n";
+
+    foreach (const QString &fileName, upToDate) {
+        if (json)
+            json->addFile(cacheFileName(fileName), QFileInfo(fileName).absolutePath());
+    }
+    if (updateFileFlags & SkipUpdateFile)
+        return;
+    QList<ProcessFuture> futures;
+    foreach (const QString &fileName, outdatedFiles) {
+        QStringList arguments;
+        arguments << QStringLiteral("-o") << QDir::toNativeSeparators(cacheFileName(fileName))
+                  << QDir::toNativeSeparators(fileName);
+        futures.append(pool->start(qmlCacheGenerator, arguments));
+    }
+    for (int f = 0; f < futures.size(); ++f) {
+        const QString &fileName = outdatedFiles.at(f);
+        const ProcessResult &result = futures.at(f).result();
+        if (result.started && !result.exitCode) {
+            if (json)
+                json->addFile(cacheFileName(fileName), QFileInfo(fileName).absolutePath());
+        } else {
+            const QString errorMessage = result.started
+                ? QString::fromLocal8Bit(result.stdErr).trimmed() : result.errorMessage;
+            errorStream() << "Warning: Cannot generate QML cache for " << QDir::toNativeSeparators(fileName)
+                       << ": " << errorMessage << '\n';
+        }
+    }
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,57 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QMLCACHEGEN_H
+#define QMLCACHEGEN_H
+
+#include "types.h"
+
+QT_BEGIN_NAMESPACE
+
+class JsonOutput;
+class ProcessPool;
+
+// Return the QML cache generator of the Qt installation or an empty string if
+// it does not have one (Qt < 5.8).
+QString findQmlCacheGenerator(const QString &qtBinDir);
+
+// Compile the deployed .qml/.js files ahead of time into .qmlc/.jsc files next
+// to them, running the processes on pool. Files whose cache file is up to date
+// are skipped; failures are reported as warnings since the engine falls back
+// to compiling at run time.
+void generateQmlCache(const QString &qmlCacheGenerator, const QStringList &files, ProcessPool *pool,
+                      unsigned updateFileFlags, JsonOutput *json);
+
+QT_END_NAMESPACE
+
+#endif // QMLCACHEGEN_H
@@ -0,0 +1,193 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qmlreachability.h"
+#include "qmlscanner.h"
+#include "utils.h"
+
+#include <QtCore/QDirIterator>
+#include <QtCore/QHash>
+
+QT_BEGIN_NAMESPACE
+
+typedef QHash<QString, QStringList> TypeFiles; // Type name -> absolute file names.
+
+class QmlReachabilityAnalysis
+{
+public:
+    explicit QmlReachabilityAnalysis(const QString &qmlImportPath) : m_qmlImportPath(qmlImportPath) {}
+
+    void addFile(const QString &fileName);
+    void run();
+
+    QSet<QString> reachableFiles() const { return m_reachable; }
+
+private:
+    const TypeFiles &directoryTypes(const QString &directory);
+    QString modulePath(const QmlImport &import);
+    void addModule(const QString &path);
+    void visit(const QString &fileName);
+
+    const QString m_qmlImportPath;
+    QHash<QString, TypeFiles> m_directoryTypes;
+    QHash<QString, QString> m_modulePaths; // QmlImport::key() -> directory.
+    QSet<QString> m_modules;
+    QSet<QString> m_reachable;
+    QStringList m_pending;
+};
+
+// Types of a directory: the qmldir type declarations and, implicitly, the
+// .qml files by base name.
+const TypeFiles &QmlReachabilityAnalysis::directoryTypes(const QString &directory)
+{
+    QHash<QString, TypeFiles>::iterator it = m_directoryTypes.find(directory);
+    if (it != m_directoryTypes.end())
+        return it.value();
+    TypeFiles types;
+    const QString qmlDirFile = directory + QStringLiteral("/qmldir");
+    if (QFileInfo(qmlDirFile).isFile()) {
+        foreach (const QmlDirInfo::Component &component, readQmlDir(qmlDirFile).components) {
+            const QString fileName = QDir::cleanPath(directory + QLatin1Char('/') + component.fileName);
+            if (!types[component.typeName].contains(fileName))
+                types[component.typeName].append(fileName);
+        }
+    }
+    foreach (const QString &qmlFile, QDir(directory).entryList(QStringList(QStringLiteral("*.qml")), QDir::Files)) {
+        const QString typeName = QFileInfo(qmlFile).completeBaseName();
+        if (!types.contains(typeName))
+            types.insert(typeName, QStringList(directory + QLatin1Char('/') + qmlFile));
+    }
+    return m_directoryTypes.insert(directory, types).value();
+}
+
+QString QmlReachabilityAnalysis::modulePath(const QmlImport &import)
+{
+    const QString key = import.key();
+    QHash<QString, QString>::const_iterator it = m_modulePaths.constFind(key);
+    if (it != m_modulePaths.constEnd())
+        return it.value();
+    const QString path = resolveQmlModule(m_qmlImportPath, import);
+    m_modulePaths.insert(key, path);
+    if (!path.isEmpty())
+        addModule(path);
+    return path;
+}
+
+// Modules whose plugin registers the types (qmlRegisterType(QUrl), QtQuick.Controls,
+// QtQuick.Dialogs) have a qmldir without type declarations and may load files by
+// computed URLs. Their files cannot be tracked and are all reachable.
+void QmlReachabilityAnalysis::addModule(const QString &path)
+{
+    if (m_modules.contains(path))
+        return;
+    m_modules.insert(path);
+    const QmlDirInfo qmlDir = readQmlDir(path + QStringLiteral("/qmldir"));
+    if (qmlDir.plugins.isEmpty() || !qmlDir.components.isEmpty())
+        return;
+    if (verboseLevel() > 1)
+        logStream() << "Keeping all files of " << QDir::toNativeSeparators(path) << ".\n";
+    QDirIterator it(path, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext())
+        addFile(it.next());
+}
+
+void QmlReachabilityAnalysis::addFile(const QString &fileName)
+{
+    const QString cleanFileName = QDir::cleanPath(QFileInfo(fileName).absoluteFilePath());
+    if (m_reachable.contains(cleanFileName))
+        return;
+    m_reachable.insert(cleanFileName);
+    if (cleanFileName.endsWith(QLatin1String(".qml")) || cleanFileName.endsWith(QLatin1String(".js")))
+        m_pending.append(cleanFileName);
+}
+
+void QmlReachabilityAnalysis::visit(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+    const QmlFileReferences references = lexQmlReferences(file.readAll());
+    const QString directory = QFileInfo(fileName).absolutePath();
+
+    // Scopes in which the type names are looked up.
+    QStringList scopes(directory);
+    foreach (const QString &fileImport, references.fileImports) {
+        const QString path = QDir::cleanPath(directory + QLatin1Char('/') + fileImport);
+        const QFileInfo fileInfo(path);
+        if (fileInfo.isDir())
+            scopes.append(path);
+        else if (fileInfo.isFile())
+            addFile(path);
+    }
+    foreach (const QmlImport &moduleImport, references.moduleImports) {
+        const QString path = modulePath(moduleImport);
+        if (!path.isEmpty())
+            scopes.append(path);
+    }
+
+    foreach (const QString &typeName, references.typeNames) {
+        foreach (const QString &scope, scopes) {
+            foreach (const QString &typeFile, directoryTypes(scope).value(typeName))
+                addFile(typeFile);
+        }
+    }
+    foreach (const QString &literal, references.strings) {
+        if (literal.contains(QLatin1Char(':')) || literal.size() > 256)
+            continue; // URL schemes, drive letters, text.
+        const QString path = QDir::cleanPath(directory + QLatin1Char('/') + literal);
+        if (QFileInfo(path).isFile())
+            addFile(path);
+    }
+}
+
+void QmlReachabilityAnalysis::run()
+{
+    while (!m_pending.isEmpty())
+        visit(m_pending.takeLast());
+}
+
+QSet<QString> findReachableQmlFiles(const QStringList &applicationDirectories,
+                                    const QString &qmlImportPath)
+{
+    QmlReachabilityAnalysis analysis(qmlImportPath);
+    foreach (const QFileInfo &fileInfo, findQmlFiles(applicationDirectories)) {
+        if (fileInfo.fileName() != QLatin1String("qmldir"))
+            analysis.addFile(fileInfo.absoluteFilePath());
+    }
+    analysis.run();
+    if (verboseLevel() > 1)
+        logStream() << analysis.reachableFiles().size() << " QML files are reachable.\n";
+    return analysis.reachableFiles();
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,185 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qmlscancache.h"
+#include "utils.h"
+
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDataStream>
+#include <QtCore/QSaveFile>
+#include <QtCore/QStandardPaths>
+
+QT_BEGIN_NAMESPACE
+
+static const quint32 scanCacheMagic = 0x51534341; // "QSCA"
+static const quint32 scanCacheVersion = 1;
+
+QmlImportScanCache::QmlImportScanCache(const QStringList &directories, const QString &qmlImportPath,
+                                       Options::QmlImportScanner scanner)
+{
+    foreach (const QString &directory, directories)
+        m_key += QDir::cleanPath(QFileInfo(directory).absoluteFilePath()) + QLatin1Char('|');
+    m_key += qmlImportPath + QLatin1Char('|') + QString::number(scanner);
+    const QString cacheLocation = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (!cacheLocation.isEmpty()) {
+        const QByteArray hash = QCryptographicHash::hash(m_key.toUtf8(), QCryptographicHash::Sha1).toHex();
+        m_fileName = cacheLocation + QStringLiteral("/qmlscan-") + QString::fromLatin1(hash.left(16))
+                     + QStringLiteral(".dat");
+    }
+}
+
+// Returns false if there is no usable cache file, which is not an error.
+bool QmlImportScanCache::load()
+{
+    if (m_fileName.isEmpty())
+        return false;
+    QFile file(m_fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    QDataStream str(&file);
+    str.setVersion(QDataStream::Qt_5_0);
+    quint32 magic;
+    quint32 version;
+    QString key;
+    str >> magic >> version >> key;
+    if (str.status() != QDataStream::Ok || magic != scanCacheMagic
+        || version != scanCacheVersion || key != m_key) {
+        return false;
+    }
+    qint32 fileCount;
+    str >> fileCount;
+    for (qint32 f = 0; f < fileCount && str.status() == QDataStream::Ok; ++f) {
+        QString path;
+        FileEntry entry;
+        qint32 importCount;
+        str >> path >> entry.size >> entry.lastModified >> importCount;
+        for (qint32 i = 0; i < importCount && str.status() == QDataStream::Ok; ++i) {
+            QmlImport import;
+            str >> import.uri >> import.version;
+            entry.imports.append(import);
+        }
+        m_files.insert(path, entry);
+    }
+    qint32 moduleCount;
+    str >> moduleCount;
+    for (qint32 m = 0; m < moduleCount && str.status() == QDataStream::Ok; ++m) {
+        QmlImportScanResult::Module module;
+        str >> module.name >> module.className >> module.sourcePath;
+        m_modules.append(module);
+    }
+    if (str.status() != QDataStream::Ok) {
+        m_files.clear();
+        m_modules.clear();
+        return false;
+    }
+    return true;
+}
+
+bool QmlImportScanCache::save(QString *errorMessage) const
+{
+    if (m_fileName.isEmpty())
+        return true;
+    QDir().mkpath(QFileInfo(m_fileName).absolutePath());
+    QSaveFile file(m_fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        *errorMessage = QString::fromLatin1("Cannot write %1: %2")
+                        .arg(QDir::toNativeSeparators(m_fileName), file.errorString());
+        return false;
+    }
+    QDataStream str(&file);
+    str.setVersion(QDataStream::Qt_5_0);
+    str << scanCacheMagic << scanCacheVersion << m_key << qint32(m_files.size());
+    for (QHash<QString, FileEntry>::const_iterator it = m_files.constBegin(); it != m_files.constEnd(); ++it) {
+        str << it.key() << it.value().size << it.value().lastModified << qint32(it.value().imports.size());
+        foreach (const QmlImport &import, it.value().imports)
+            str << import.uri << import.version;
+    }
+    str << qint32(m_modules.size());
+    foreach (const QmlImportScanResult::Module &module, m_modules)
+        str << module.name << module.className << module.sourcePath;
+    if (str.status() != QDataStream::Ok || !file.commit()) {
+        *errorMessage = QString::fromLatin1("Cannot write %1: %2")
+                        .arg(QDir::toNativeSeparators(m_fileName), file.errorString());
+        return false;
+    }
+    return true;
+}
+
+const QmlImportScanCache::FileEntry *QmlImportScanCache::entry(const QFileInfo &file) const
+{
+    const QHash<QString, FileEntry>::const_iterator it = m_files.constFind(file.absoluteFilePath());
+    if (it == m_files.constEnd() || it.value().size != file.size()
+        || it.value().lastModified != file.lastModified().toMSecsSinceEpoch()) {
+        return 0;
+    }
+    return &it.value();
+}
+
+// Returns the cached modules if the files are unchanged.
+bool QmlImportScanCache::modules(const QFileInfoList &files, QList<QmlImportScanResult::Module> *modules) const
+{
+    if (files.size() != m_files.size())
+        return false;
+    foreach (const QFileInfo &file, files) {
+        if (!entry(file))
+            return false;
+    }
+    *modules = m_modules;
+    return true;
+}
+
+// Returns the cached imports of an unchanged file (built-in scanner).
+bool QmlImportScanCache::fileImports(const QFileInfo &file, QmlImportList *imports) const
+{
+    if (const FileEntry *e = entry(file)) {
+        *imports = e->imports;
+        return true;
+    }
+    return false;
+}
+
+void QmlImportScanCache::setResult(const QFileInfoList &files, const QVector<QmlImportList> &imports,
+                                   const QList<QmlImportScanResult::Module> &modules)
+{
+    m_files.clear();
+    for (int f = 0; f < files.size(); ++f) {
+        FileEntry entry;
+        entry.size = files.at(f).size();
+        entry.lastModified = files.at(f).lastModified().toMSecsSinceEpoch();
+        entry.imports = imports.value(f);
+        m_files.insert(files.at(f).absoluteFilePath(), entry);
+    }
+    m_modules = modules;
+}
+
+QT_END_NAMESPACE
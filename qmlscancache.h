@@ -0,0 +1,82 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QMLSCANCACHE_H
+#define QMLSCANCACHE_H
+
+#include "qmlscanner.h"
+
+#include <QtCore/QHash>
+
+QT_BEGIN_NAMESPACE
+
+// Result of the QML import scan of directories, stored in the cache location.
+// It is valid as long as the size and modification time of the scanned
+// .qml/.js/qmldir files are unchanged. For the built-in scanner, the imports
+// are kept per file so that only changed files need to be lexed again.
+class QmlImportScanCache
+{
+public:
+    QmlImportScanCache(const QStringList &directories, const QString &qmlImportPath,
+                       Options::QmlImportScanner scanner);
+
+    QString fileName() const { return m_fileName; }
+
+    bool load();
+    bool save(QString *errorMessage) const;
+
+    bool modules(const QFileInfoList &files, QList<QmlImportScanResult::Module> *modules) const;
+    bool fileImports(const QFileInfo &file, QmlImportList *imports) const;
+    void setResult(const QFileInfoList &files, const QVector<QmlImportList> &imports,
+                   const QList<QmlImportScanResult::Module> &modules);
+
+private:
+    struct FileEntry {
+        FileEntry() : size(0), lastModified(0) {}
+
+        qint64 size;
+        qint64 lastModified;
+        QmlImportList imports;
+    };
+
+    const FileEntry *entry(const QFileInfo &file) const;
+
+    QString m_fileName;
+    QString m_key;
+    QHash<QString, FileEntry> m_files;
+    QList<QmlImportScanResult::Module> m_modules;
+};
+
+QT_END_NAMESPACE
+
+#endif // QMLSCANCACHE_H
@@ -0,0 +1,438 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qmlscanner.h"
+#include "utils.h"
+
+#include <QtCore/QDirIterator>
+#include <QtCore/QHash>
+#include <QtCore/QRunnable>
+#include <QtCore/QSet>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
+#include <QtCore/QVector>
+
+#include <algorithm>
+
+QT_BEGIN_NAMESPACE
+
+static inline bool isWordChar(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')
+        || c == '_' || c == '.' || c == '$';
+}
+
+// Skip white space and comments. Stops at a line break if stopAtNewLine is set.
+static const char *skipSpace(const char *p, const char *end, bool stopAtNewLine)
+{
+    while (p < end) {
+        const char c = *p;
+        if (c == '\n') {
+            if (stopAtNewLine)
+                break;
+            ++p;
+        } else if (c == ' ' || c == '\t' || c == '\r' || c == '\f') {
+            ++p;
+        } else if (c == '/' && p + 1 < end && p[1] == '/') {
+            while (p < end && *p != '\n')
+                ++p;
+        } else if (c == '/' && p + 1 < end && p[1] == '*') {
+            for (p += 2; p < end && !(*p == '*' && p + 1 < end && p[1] == '/'); ++p) {}
+            p = p < end ? p + 2 : end;
+        } else {
+            break;
+        }
+    }
+    return p;
+}
+
+// Read a word (identifier, dotted URI or version), a string literal or a single
+// character.
+static const char *nextToken(const char *p, const char *end, QByteArray *token)
+{
+    const char *start = p;
+    if (*p == '"' || *p == '\'') {
+        const char quote = *p++;
+        for ( ; p < end && *p != quote && *p != '\n'; ++p) {
+            if (*p == '\\')
+                ++p;
+        }
+        if (p < end && *p == quote)
+            ++p;
+    } else if (isWordChar(*p)) {
+        while (p < end && isWordChar(*p))
+            ++p;
+    } else {
+        ++p;
+    }
+    *token = QByteArray(start, int(p - start));
+    return p;
+}
+
+static inline const char *skipStatement(const char *p, const char *end)
+{
+    while (p < end && *p != '\n' && *p != ';')
+        ++p;
+    return p;
+}
+
+// Lex the header of a QML file ("import", "pragma") or of a JavaScript file
+// (".import", ".pragma") up to the first other token, which is the root object
+// or the code, respectively. File and directory imports are not reported.
+QmlImportList lexQmlImports(const QByteArray &content, bool javaScript)
+{
+    QmlImportList result;
+    const char *p = content.constData();
+    const char *end = p + content.size();
+    const QByteArray importKeyword = javaScript ? QByteArrayLiteral(".import") : QByteArrayLiteral("import");
+    const QByteArray pragmaKeyword = javaScript ? QByteArrayLiteral(".pragma") : QByteArrayLiteral("pragma");
+    QByteArray token;
+    while (true) {
+        p = skipSpace(p, end, false);
+        if (p >= end)
+            break;
+        if (*p == ';') {
+            ++p;
+            continue;
+        }
+        p = nextToken(p, end, &token);
+        if (token == pragmaKeyword) {
+            p = skipStatement(p, end);
+        } else if (token == importKeyword) {
+            p = skipSpace(p, end, true);
+            if (p < end && isWordChar(*p)) {
+                QByteArray uri;
+                p = nextToken(p, end, &uri);
+                QByteArray version;
+                p = skipSpace(p, end, true);
+                if (p < end && *p >= '0' && *p <= '9')
+                    p = nextToken(p, end, &version);
+                result.append(QmlImport(QString::fromUtf8(uri), QString::fromLatin1(version)));
+            }
+            p = skipStatement(p, end);
+        } else {
+            break;
+        }
+    }
+    return result;
+}
+
+// Lex a complete QML or JavaScript file for imports, type names and string
+// literals. Regular expression literals are not recognized, which at worst
+// adds spurious references.
+QmlFileReferences lexQmlReferences(const QByteArray &content)
+{
+    QmlFileReferences result;
+    QSet<QByteArray> typeNames;
+    const char *p = content.constData();
+    const char *end = p + content.size();
+    QByteArray token;
+    QByteArray previous;
+    while (true) {
+        p = skipSpace(p, end, false);
+        if (p >= end)
+            break;
+        p = nextToken(p, end, &token);
+        const char first = token.at(0);
+        if (first == '"' || first == '\'') {
+            const QString literal = QString::fromUtf8(token.mid(1, token.size() - 2));
+            if (previous == "import" || previous == ".import")
+                result.fileImports.append(literal);
+            else if (!literal.isEmpty())
+                result.strings.append(literal);
+        } else if (isWordChar(first)) {
+            if (previous == "import" || previous == ".import") {
+                QByteArray version;
+                const char *v = skipSpace(p, end, true);
+                if (v < end && *v >= '0' && *v <= '9')
+                    p = nextToken(v, end, &version);
+                result.moduleImports.append(QmlImport(QString::fromUtf8(token), QString::fromLatin1(version)));
+            } else {
+                // "Controls.Button", "QQC.Button": all capitalized components.
+                foreach (const QByteArray &part, token.split('.')) {
+                    if (!part.isEmpty() && part.at(0) >= 'A' && part.at(0) <= 'Z')
+                        typeNames.insert(part);
+                }
+            }
+        }
+        previous = token;
+    }
+    foreach (const QByteArray &typeName, typeNames)
+        result.typeNames.append(QString::fromUtf8(typeName));
+    return result;
+}
+
+QmlDirInfo parseQmlDir(const QByteArray &content)
+{
+    QmlDirInfo result;
+    foreach (const QByteArray &line, content.split('\n')) {
+        QList<QByteArray> tokens = line.simplified().split(' ');
+        if (tokens.size() > 1 && tokens.first() == "optional") // "optional plugin name"
+            tokens.removeFirst();
+        const QByteArray &keyword = tokens.first();
+        if (keyword.isEmpty() || keyword.startsWith('#'))
+            continue;
+        if (keyword == "classname") {
+            if (tokens.size() > 1)
+                result.className = QString::fromUtf8(tokens.at(1));
+        } else if (keyword == "plugin") {
+            if (tokens.size() > 1) {
+                QmlDirInfo::Plugin plugin;
+                plugin.name = QString::fromUtf8(tokens.at(1));
+                if (tokens.size() > 2)
+                    plugin.path = QString::fromUtf8(tokens.at(2));
+                result.plugins.append(plugin);
+            }
+        } else if (keyword == "depends" || keyword == "import") {
+            if (tokens.size() > 1) {
+                result.imports.append(QmlImport(QString::fromUtf8(tokens.at(1)),
+                                                tokens.size() > 2 ? QString::fromLatin1(tokens.at(2)) : QString()));
+            }
+        } else if (tokens.size() > 1) {
+            // Type declarations "[singleton|internal] Type [version] File.qml".
+            const QByteArray &file = tokens.last();
+            if (file.endsWith(".qml") || file.endsWith(".js")) {
+                result.componentFiles.append(QString::fromUtf8(file));
+                QmlDirInfo::Component component;
+                const bool qualified = keyword == "singleton" || keyword == "internal";
+                component.typeName = QString::fromUtf8(tokens.at(qualified && tokens.size() > 2 ? 1 : 0));
+                component.fileName = QString::fromUtf8(file);
+                result.components.append(component);
+            }
+        }
+    }
+    return result;
+}
+
+QmlDirInfo readQmlDir(const QString &fileName)
+{
+    QFile file(fileName);
+    return file.open(QIODevice::ReadOnly) ? parseQmlDir(file.readAll()) : QmlDirInfo();
+}
+
+static inline void warnUnreadable(const QFile &file)
+{
+    errorStream() << "Warning: Unable to read " << QDir::toNativeSeparators(file.fileName())
+                  << ": " << file.errorString() << '\n';
+}
+
+// readQmlDir() warning about an unreadable file, for the scan.
+static QmlDirInfo scanQmlDir(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        warnUnreadable(file);
+        return QmlDirInfo();
+    }
+    return parseQmlDir(file.readAll());
+}
+
+static QmlImportList fileImports(const QString &fileName)
+{
+    if (fileName.endsWith(QLatin1String("/qmldir")))
+        return scanQmlDir(fileName).imports;
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        warnUnreadable(file);
+        return QmlImportList();
+    }
+    // Lex the mapped file in place, only the header is looked at.
+    const qint64 size = file.size();
+    QByteArray content;
+    if (const uchar *mapped = size > 0 ? file.map(0, size) : 0)
+        content = QByteArray::fromRawData(reinterpret_cast<const char *>(mapped), int(size));
+    else
+        content = file.readAll();
+    return lexQmlImports(content, fileName.endsWith(QLatin1String(".js")));
+}
+
+// Candidate directories of a module relative to the import path in the order
+// used by the QML engine: "QtQuick/Controls.1.2", "QtQuick.1.2/Controls",
+// "QtQuick/Controls.1", "QtQuick.1/Controls", "QtQuick/Controls".
+static QStringList moduleCandidatePaths(const QString &uri, const QString &version)
+{
+    const QStringList parts = uri.split(QLatin1Char('.'));
+    QStringList versions;
+    if (!version.isEmpty()) {
+        versions.append(version);
+        const int dotPos = version.indexOf(QLatin1Char('.'));
+        if (dotPos > 0)
+            versions.append(version.left(dotPos));
+    }
+    QStringList result;
+    foreach (const QString &v, versions) {
+        for (int i = parts.size() - 1; i >= 0; --i) {
+            QStringList versionedParts = parts;
+            versionedParts[i] += QLatin1Char('.') + v;
+            result.append(versionedParts.join(QLatin1Char('/')));
+        }
+    }
+    result.append(parts.join(QLatin1Char('/')));
+    return result;
+}
+
+QString resolveQmlModule(const QString &qmlImportPath, const QmlImport &import)
+{
+    foreach (const QString &candidate, moduleCandidatePaths(import.uri, import.version)) {
+        const QString path = qmlImportPath + QLatin1Char('/') + candidate;
+        if (QFileInfo(path + QStringLiteral("/qmldir")).isFile())
+            return QDir::cleanPath(path);
+    }
+    return QString();
+}
+
+class QmlImportLexTask : public QRunnable
+{
+public:
+    QmlImportLexTask(const QStringList &files, QVector<QmlImportList> *results, int first, int stride)
+        : m_files(files), m_results(results), m_first(first), m_stride(stride)
+        , m_logContext(currentLogContext()) {}
+
+    void run() Q_DECL_OVERRIDE
+    {
+        const LogScope logScope(m_logContext);
+        // Each task writes to distinct slots of the preallocated result vector.
+        for (int i = m_first; i < m_files.size(); i += m_stride)
+            (*m_results)[i] = fileImports(m_files.at(i));
+    }
+
+private:
+    const QStringList &m_files;
+    QVector<QmlImportList> *m_results;
+    const int m_first;
+    const int m_stride;
+    const LogContext m_logContext;
+};
+
+QVector<QmlImportList> lexQmlFiles(const QStringList &files, int jobs)
+{
+    QVector<QmlImportList> result(files.size());
+    if (jobs <= 0)
+        jobs = QThread::idealThreadCount();
+    const int taskCount = qBound(1, files.size() / 16, qMax(1, jobs));
+    if (taskCount == 1) {
+        QmlImportLexTask(files, &result, 0, 1).run();
+        return result;
+    }
+    QThreadPool pool;
+    pool.setMaxThreadCount(taskCount);
+    for (int t = 0; t < taskCount; ++t)
+        pool.start(new QmlImportLexTask(files, &result, t, taskCount));
+    pool.waitForDone();
+    return result;
+}
+
+static bool fileInfoLessThan(const QFileInfo &f1, const QFileInfo &f2)
+{
+    return f1.filePath() < f2.filePath();
+}
+
+// Return the .qml/.js/qmldir files below the directories, sorted and without
+// duplicates from nested directories.
+QFileInfoList findQmlFiles(const QStringList &directories)
+{
+    QFileInfoList result;
+    const QStringList nameFilters = QStringList() << QStringLiteral("*.qml") << QStringLiteral("*.js")
+                                                  << QStringLiteral("qmldir");
+    foreach (const QString &directory, directories) {
+        QDirIterator it(directory, nameFilters, QDir::Files, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            it.next();
+            result.append(it.fileInfo());
+        }
+    }
+    std::sort(result.begin(), result.end(), fileInfoLessThan);
+    if (directories.size() > 1) {
+        QSet<QString> seen;
+        for (QFileInfoList::iterator it = result.begin(); it != result.end(); ) {
+            const QString path = it->absoluteFilePath();
+            if (seen.contains(path)) {
+                it = result.erase(it);
+            } else {
+                seen.insert(path);
+                ++it;
+            }
+        }
+    }
+    return result;
+}
+
+// Resolve the imports in order, adding the dependencies of the modules found
+// (qmldir "depends"/"import" lines and the imports of the module's QML files).
+QList<QmlImportScanResult::Module> resolveQmlImports(const QString &qmlImportPath,
+                                                     const QmlImportList &imports)
+{
+    QList<QmlImportScanResult::Module> result;
+    QmlImportList pending = imports;
+    QSet<QString> seenImports;
+    QSet<QString> seenPaths;
+    for (int i = 0; i < pending.size(); ++i) {
+        const QmlImport import = pending.at(i);
+        const QString key = import.key();
+        if (seenImports.contains(key))
+            continue;
+        seenImports.insert(key);
+        const QString path = resolveQmlModule(qmlImportPath, import);
+        if (path.isEmpty() || seenPaths.contains(path))
+            continue;
+        seenPaths.insert(path);
+        const QmlDirInfo qmlDir = scanQmlDir(path + QStringLiteral("/qmldir"));
+        QmlImportScanResult::Module module;
+        module.name = import.uri;
+        module.className = qmlDir.className;
+        module.sourcePath = path;
+        result.append(module);
+        pending += qmlDir.imports;
+        foreach (const QString &componentFile, qmlDir.componentFiles)
+            pending += fileImports(path + QLatin1Char('/') + componentFile);
+    }
+    return result;
+}
+
+bool scanQmlImports(const QStringList &directories, const QString &qmlImportPath, int jobs,
+                    QList<QmlImportScanResult::Module> *modules, QString *errorMessage)
+{
+    Q_UNUSED(errorMessage) // Unreadable files are skipped with a warning.
+    QStringList files;
+    foreach (const QFileInfo &fileInfo, findQmlFiles(directories))
+        files.append(fileInfo.filePath());
+    if (verboseLevel() > 1)
+        logStream() << "Lexing " << files.size() << " files.\n";
+    QmlImportList imports;
+    foreach (const QmlImportList &fileImportList, lexQmlFiles(files, jobs))
+        imports += fileImportList;
+    *modules = resolveQmlImports(qmlImportPath, imports);
+    return true;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,104 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QMLSCANNER_H
+#define QMLSCANNER_H
+
+#include "qmlutils.h"
+
+QT_BEGIN_NAMESPACE
+
+// A module import statement of a QML or JavaScript file or a "depends"/"import"
+// line of a qmldir file.
+struct QmlImport {
+    QmlImport() {}
+    QmlImport(const QString &u, const QString &v) : uri(u), version(v) {}
+
+    // Different major versions of a module may live in different directories
+    // (QtQuick/Controls and QtQuick/Controls.2).
+    QString key() const { return uri + QLatin1Char(' ') + version; }
+
+    QString uri;
+    QString version;
+};
+
+typedef QList<QmlImport> QmlImportList;
+
+// Contents of a qmldir file relevant for deployment.
+struct QmlDirInfo {
+    struct Plugin {
+        QString name; // Base name, "qtquick2plugin".
+        QString path; // Optional directory, relative to the qmldir file.
+    };
+
+    struct Component {
+        QString typeName;
+        QString fileName; // Relative to the qmldir file.
+    };
+
+    QString className;
+    QList<Plugin> plugins;
+    QmlImportList imports;
+    QStringList componentFiles;
+    QList<Component> components;
+};
+
+// References of a QML or JavaScript file used for determining the reachable files.
+struct QmlFileReferences {
+    QmlImportList moduleImports;
+    QStringList fileImports;  // "import "directory"", "import "file.js" as Name"
+    QStringList typeNames;    // Identifiers starting with an upper case letter.
+    QStringList strings;      // String literals, possibly relative file names.
+};
+
+QmlImportList lexQmlImports(const QByteArray &content, bool javaScript);
+QmlDirInfo parseQmlDir(const QByteArray &content);
+QmlDirInfo readQmlDir(const QString &fileName);
+QmlFileReferences lexQmlReferences(const QByteArray &content);
+QString resolveQmlModule(const QString &qmlImportPath, const QmlImport &import);
+
+QFileInfoList findQmlFiles(const QStringList &directories);
+QVector<QmlImportList> lexQmlFiles(const QStringList &files, int jobs);
+QList<QmlImportScanResult::Module> resolveQmlImports(const QString &qmlImportPath,
+                                                     const QmlImportList &imports);
+
+// Built-in replacement for qmlimportscanner: lexes the import statements of the
+// .qml/.js/qmldir files below the directories in parallel and resolves the
+// modules against the QML import path. Unreadable files are skipped with a
+// warning.
+bool scanQmlImports(const QStringList &directories, const QString &qmlImportPath, int jobs,
+                    QList<QmlImportScanResult::Module> *modules, QString *errorMessage);
+
+QT_END_NAMESPACE
+
+#endif // QMLSCANNER_H
@@ -32,6 +32,9 @@
 ****************************************************************************/
 
 #include "qmlutils.h"
+#include "qmlscanner.h"
+#include "qmlscancache.h"
+#include "qtindex.h"
 #include "utils.h"
 
 #include <QtCore/QDir>
@@ -108,35 +111,105 @@ QString findQmlDirectory(int platform, const QString &startDirectoryName)
     return qmlDirectoryRecursion(Platform(platform), startDirectory.path());
 }
 
-static void findFileRecursion(const QDir &directory, Platform platform,
-                              DebugMatchMode debugMatchMode, QStringList *matches)
+// Find the libraries deployed with a module directory tree by
+// QmlDirectoryFileEntryFunction: the plugins declared by qmldir files, including
+// those of nested modules (QtQuick/Controls/Styles/Flat), and all libraries of
+// directories without qmldir.
+static void findModuleLibraries(const QDir &directory, Platform platform,
+                                DebugMatchMode debugMatchMode, QStringList *matches)
 {
-    foreach (const QString &dll, findSharedLibraries(directory, platform, debugMatchMode))
-        matches->append(directory.filePath(dll));
+    bool hasQmlDir;
+    const QStringList plugins = findQmlPluginLibraries(directory.path(), platform, debugMatchMode, &hasQmlDir);
+    if (hasQmlDir) {
+        *matches += plugins;
+    } else {
+        foreach (const QString &dll, findSharedLibraries(directory, platform, debugMatchMode))
+            matches->append(directory.filePath(dll));
+    }
     foreach (const QString &subDir, directory.entryList(QStringList(), QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks)) {
         QDir subDirectory = directory;
         if (subDirectory.cd(subDir))
-            findFileRecursion(subDirectory, platform, debugMatchMode, matches);
+            findModuleLibraries(subDirectory, platform, debugMatchMode, matches);
     }
 }
 
-QmlImportScanResult runQmlImportScanner(const QString &directory, const QString &qmlImportPath,
-                                        int platform, DebugMatchMode debugMatchMode,
-                                        QString *errorMessage)
+// Return the plugin libraries declared by the "plugin" lines of the qmldir file
+// of directory matching the debug mode. hasQmlDir is set to false if there is
+// no qmldir file.
+QStringList findQmlPluginLibraries(const QString &directory, Platform platform,
+                                   DebugMatchMode debugMatchMode, bool *hasQmlDir)
+{
+    QStringList result;
+    const QString qmlDirFile = directory + QStringLiteral("/qmldir");
+    *hasQmlDir = QFileInfo(qmlDirFile).isFile();
+    if (!*hasQmlDir)
+        return result;
+    const bool isWindows = platform & WindowsBased;
+    const QString suffix = sharedLibrarySuffix(platform);
+    foreach (const QmlDirInfo::Plugin &plugin, readQmlDir(qmlDirFile).plugins) {
+        const QString pluginDirectory = plugin.path.isEmpty()
+            ? directory : QDir::cleanPath(QDir(directory).absoluteFilePath(plugin.path));
+        QStringList candidates;
+        if (isWindows) {
+            if (debugMatchMode != MatchDebug)
+                candidates.append(plugin.name + suffix);
+            if (debugMatchMode != MatchRelease)
+                candidates.append(plugin.name + QLatin1Char('d') + suffix);
+        } else {
+            candidates.append(QStringLiteral("lib") + plugin.name + suffix);
+        }
+        foreach (const QString &candidate, candidates) {
+            const QString path = pluginDirectory + QLatin1Char('/') + candidate;
+            if (!QFileInfo(path).isFile())
+                continue;
+            if (isWindows && debugMatchMode != MatchDebugOrRelease) {
+                QString errorMessage;
+                bool isDebug;
+                if (!readPeExecutable(path, &errorMessage, 0, 0, &isDebug, platform == WindowsMinGW)) {
+                    errorStream() << "Warning: Unable to read " << QDir::toNativeSeparators(path)
+                               << ": " << errorMessage << '\n';
+                } else if (isDebug != (debugMatchMode == MatchDebug)) {
+                    continue;
+                }
+            }
+            result.append(path);
+        }
+    }
+    return result;
+}
+
+static inline QStringList qmlImportScannerArguments(const QStringList &directories, const QString &qmlImportPath)
 {
-    QmlImportScanResult result;
     QStringList arguments;
-    arguments << QStringLiteral("-importPath") << qmlImportPath << QStringLiteral("-rootPath") << directory;
-    unsigned long exitCode;
-    QByteArray stdOut;
-    QByteArray stdErr;
+    arguments << QStringLiteral("-importPath") << qmlImportPath << QStringLiteral("-rootPath") << directories;
+    return arguments;
+}
+
+// Run qmlimportscanner (or take the result of the run started by
+// startQmlImportScanner()) and return the modules found.
+static bool runExternalQmlImportScanner(const QStringList &directories, const QString &qmlImportPath,
+                                        const ProcessFuture &externalScan,
+                                        QList<QmlImportScanResult::Module> *modules,
+                                        QString *errorMessage)
+{
     const QString binary = QStringLiteral("qmlimportscanner");
-    if (!runProcess(binary, arguments, QDir::currentPath(), &exitCode, &stdOut, &stdErr, errorMessage))
-        return result;
-    if (exitCode) {
-        *errorMessage = binary + QStringLiteral(" returned ") + QString::number(exitCode)
-                        + QStringLiteral(": ") + QString::fromLocal8Bit(stdErr);
-        return result;
+    ProcessResult scanResult;
+    if (externalScan.isValid()) {
+        scanResult = externalScan.result();
+    } else {
+        scanResult.started = runProcess(binary, qmlImportScannerArguments(directories, qmlImportPath),
+                                        QDir::currentPath(), &scanResult.exitCode,
+                                        &scanResult.stdOut, &scanResult.stdErr, &scanResult.errorMessage);
+    }
+    if (!scanResult.started) {
+        *errorMessage = scanResult.errorMessage;
+        return false;
+    }
+    const QByteArray &stdOut = scanResult.stdOut;
+    if (scanResult.exitCode) {
+        *errorMessage = binary + QStringLiteral(" returned ") + QString::number(scanResult.exitCode)
+                        + QStringLiteral(": ") + QString::fromLocal8Bit(scanResult.stdErr);
+        return false;
     }
     QJsonParseError jsonParseError;
     const QJsonDocument data = QJsonDocument::fromJson(stdOut, &jsonParseError);
@@ -144,7 +217,7 @@ QmlImportScanResult runQmlImportScanner(const QString &directory, const QString
         *errorMessage = binary + QStringLiteral(" returned invalid JSON output: ")
                         + jsonParseError.errorString() + QStringLiteral(" :\"")
                         + QString::fromLocal8Bit(stdOut) + QLatin1Char('"');
-        return result;
+        return false;
     }
     const QJsonArray array = data.array();
     const int childCount = array.count();
@@ -157,34 +230,128 @@ QmlImportScanResult runQmlImportScanner(const QString &directory, const QString
                 module.name = object.value(QStringLiteral("name")).toString();
                 module.className = object.value(QStringLiteral("classname")).toString();
                 module.sourcePath = path;
-                result.modules.append(module);
-                findFileRecursion(QDir(path), Platform(platform), debugMatchMode, &result.plugins);
+                modules->append(module);
             }
         }
     }
-    result.ok = true;
-    return result;
+    return true;
 }
 
-static inline bool contains(const QList<QmlImportScanResult::Module> &modules, const QString &name)
+static inline bool scanModules(const QStringList &directories, const QString &qmlImportPath,
+                               const Options &options, const PendingQmlImportScan &pendingScan,
+                               QList<QmlImportScanResult::Module> *modules, QString *errorMessage)
 {
-    foreach (const QmlImportScanResult::Module &m, modules) {
-        if (m.name == name)
-            return true;
+    return options.qmlImportScanner == Options::QmlImportScannerBuiltin
+        ? scanQmlImports(directories, qmlImportPath, options.jobs, modules, errorMessage)
+        : runExternalQmlImportScanner(directories, qmlImportPath, pendingScan.process, modules, errorMessage);
+}
+
+// Scan using the cache: the result is reused if no .qml/.js/qmldir file changed.
+// For the built-in scanner, only the changed files are lexed again. The files
+// and the cache check of a pending external scan are reused.
+static bool scanModulesCached(const QStringList &directories, const QString &qmlImportPath,
+                              const Options &options, const PendingQmlImportScan &pendingScan,
+                              QList<QmlImportScanResult::Module> *modules, QString *errorMessage)
+{
+    QmlImportScanCache cache(directories, qmlImportPath, options.qmlImportScanner);
+    if (pendingScan.cached) {
+        *modules = pendingScan.modules;
+        if (verboseLevel() > 1)
+            logStream() << "Using cached QML imports " << QDir::toNativeSeparators(cache.fileName()) << ".\n";
+        return true;
+    }
+    const QFileInfoList files = pendingScan.filesListed ? pendingScan.files : findQmlFiles(directories);
+    if (!pendingScan.filesListed && cache.load() && cache.modules(files, modules)) {
+        if (verboseLevel() > 1)
+            logStream() << "Using cached QML imports " << QDir::toNativeSeparators(cache.fileName()) << ".\n";
+        return true;
+    }
+    QVector<QmlImportList> imports(files.size());
+    if (options.qmlImportScanner == Options::QmlImportScannerBuiltin) {
+        QStringList changedFiles;
+        QList<int> changedIndexes;
+        for (int f = 0; f < files.size(); ++f) {
+            if (!cache.fileImports(files.at(f), &imports[f])) {
+                changedFiles.append(files.at(f).filePath());
+                changedIndexes.append(f);
+            }
+        }
+        if (verboseLevel() > 1)
+            logStream() << "Lexing " << changedFiles.size() << " of " << files.size() << " files.\n";
+        const QVector<QmlImportList> changedImports = lexQmlFiles(changedFiles, options.jobs);
+        for (int c = 0; c < changedIndexes.size(); ++c)
+            imports[changedIndexes.at(c)] = changedImports.at(c);
+        QmlImportList allImports;
+        foreach (const QmlImportList &fileImportList, imports)
+            allImports += fileImportList;
+        *modules = resolveQmlImports(qmlImportPath, allImports);
+    } else if (!runExternalQmlImportScanner(directories, qmlImportPath, pendingScan.process, modules, errorMessage)) {
+        return false;
+    }
+    cache.setResult(files, imports, *modules);
+    QString saveErrorMessage;
+    if (!cache.save(&saveErrorMessage))
+        errorStream() << "Warning: " << saveErrorMessage << '\n';
+    return true;
+}
+
+PendingQmlImportScan startQmlImportScanner(const QStringList &directories, const QString &qmlImportPath,
+                                           const Options &options, ProcessPool *pool)
+{
+    PendingQmlImportScan result;
+    if (directories.isEmpty() || options.qmlImportScanner != Options::QmlImportScannerExternal)
+        return result;
+    foreach (const QString &directory, directories) {
+        if (!QFileInfo(directory).isDir())
+            return result; // Reported by runQmlImportScanner().
+    }
+    if (options.qmlScanCache) {
+        QmlImportScanCache cache(directories, qmlImportPath, options.qmlImportScanner);
+        result.files = findQmlFiles(directories);
+        result.filesListed = true;
+        if (cache.load() && cache.modules(result.files, &result.modules)) {
+            result.cached = true;
+            return result;
+        }
     }
-    return false;
+    result.process = pool->start(QStringLiteral("qmlimportscanner"), qmlImportScannerArguments(directories, qmlImportPath),
+                                 QDir::currentPath());
+    return result;
 }
 
-void QmlImportScanResult::append(const QmlImportScanResult &other)
+// Scan all QML root directories in one pass.
+QmlImportScanResult runQmlImportScanner(const QStringList &directories, const QString &qmlImportPath,
+                                        const Options &options, DebugMatchMode debugMatchMode,
+                                        const QtInstallationIndex *index,
+                                        const PendingQmlImportScan &pendingScan,
+                                        QString *errorMessage)
 {
-    foreach (const QmlImportScanResult::Module &module, other.modules) {
-        if (!contains(modules, module.name))
-            modules.append(module);
+    QmlImportScanResult result;
+    foreach (const QString &directory, directories) {
+        if (!QFileInfo(directory).isDir()) {
+            *errorMessage = QStringLiteral("QML directory ") + QDir::toNativeSeparators(directory)
+                            + QStringLiteral(" does not exist.");
+            return result;
+        }
     }
-    foreach (const QString &plugin, other.plugins) {
-        if (!plugins.contains(plugin))
-            plugins.append(plugin);
+    const bool ok = options.qmlScanCache
+        ? scanModulesCached(directories, qmlImportPath, options, pendingScan, &result.modules, errorMessage)
+        : scanModules(directories, qmlImportPath, options, pendingScan, &result.modules, errorMessage);
+    if (!ok)
+        return result;
+    // Analyze all libraries deployed with the modules. Modules without qmldir get
+    // all libraries found in their directory tree.
+    QStringList plugins;
+    foreach (const QmlImportScanResult::Module &module, result.modules) {
+        if (!index || QFileInfo(module.sourcePath + QStringLiteral("/qmldir")).isFile()
+            || !index->qmlLibraries(module.sourcePath, debugMatchMode, &plugins)) {
+            findModuleLibraries(QDir(module.sourcePath), options.platform, debugMatchMode, &plugins);
+        }
     }
+    plugins.removeDuplicates();
+    result.plugins = plugins;
+    result.ok = true;
+    return result;
 }
 
 QT_END_NAMESPACE
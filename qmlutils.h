@@ -35,11 +35,15 @@
 #define QMLUTILS_H
 
 #include "utils.h"
+#include "processpool.h"
 
 #include <QStringList>
+#include <QFileInfo>
 
 QT_BEGIN_NAMESPACE
 
+class QtInstallationIndex;
+
 QString findQmlDirectory(int platform, const QString &startDirectoryName);
 
 struct QmlImportScanResult {
@@ -53,15 +57,35 @@ struct QmlImportScanResult {
     };
 
     QmlImportScanResult() : ok(false) {}
-    void append(const QmlImportScanResult &other);
 
     bool ok;
     QList<Module> modules;
     QStringList plugins;
 };
 
-QmlImportScanResult runQmlImportScanner(const QString &directory, const QString &qmlImportPath,
-                                        int platform, DebugMatchMode debugMatchMode,
+QStringList findQmlPluginLibraries(const QString &directory, Platform platform,
+                                   DebugMatchMode debugMatchMode, bool *hasQmlDir);
+
+// Scan started by startQmlImportScanner() and completed by runQmlImportScanner().
+struct PendingQmlImportScan {
+    PendingQmlImportScan() : filesListed(false), cached(false) {}
+
+    ProcessFuture process; // qmlimportscanner, invalid if not started.
+    bool filesListed; // The QML files were listed to check the scan cache.
+    QFileInfoList files;
+    bool cached; // The scan cache had a valid result.
+    QList<QmlImportScanResult::Module> modules;
+};
+
+// Start qmlimportscanner on the pool unless the built-in scanner is used or the
+// scan cache has a valid result, so that it runs while the binaries are analyzed.
+PendingQmlImportScan startQmlImportScanner(const QStringList &directories, const QString &qmlImportPath,
+                                           const Options &options, ProcessPool *pool);
+
+QmlImportScanResult runQmlImportScanner(const QStringList &directories, const QString &qmlImportPath,
+                                        const Options &options, DebugMatchMode debugMatchMode,
+                                        const QtInstallationIndex *index,
+                                        const PendingQmlImportScan &pendingScan,
                                         QString *errorMessage);
 
 QT_END_NAMESPACE
@@ -0,0 +1,345 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qtindex.h"
+#include "deploymentcache.h"
+#include "qtmodules.h"
+#include "utils.h"
+
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDataStream>
+#include <QtCore/QDateTime>
+#include <QtCore/QSaveFile>
+#include <QtCore/QStandardPaths>
+
+QT_BEGIN_NAMESPACE
+
+static const quint32 indexMagic = 0x51544958; // "QTIX"
+static const quint32 indexVersion = 2;
+
+QDataStream &operator<<(QDataStream &str, const QtInstallationIndex::Library &l)
+{
+    str << l.fileName << l.modules << l.isDebug << l.dependenciesKnown;
+    return str;
+}
+
+QDataStream &operator>>(QDataStream &str, QtInstallationIndex::Library &l)
+{
+    str >> l.fileName >> l.modules >> l.isDebug >> l.dependenciesKnown;
+    return str;
+}
+
+static inline QString libraryLocation(const QMap<QString, QString> &qmakeVariables, Platform platform)
+{
+    return qmakeVariables.value(platform == Unix ? QStringLiteral("QT_INSTALL_LIBS") : QStringLiteral("QT_INSTALL_BINS"));
+}
+
+// The index is validated by a few stamps of the installation: the modification
+// times of its top-level directories, which change when modules are installed
+// or removed, and of qconfig.pri. Changes below them require "--index-qt".
+static QMap<QString, qint64> installationTimeStamps(const QMap<QString, QString> &qmakeVariables, Platform platform)
+{
+    QStringList paths;
+    paths << qmakeVariables.value(QStringLiteral("QT_INSTALL_PREFIX"))
+          << libraryLocation(qmakeVariables, platform)
+          << qmakeVariables.value(QStringLiteral("QT_INSTALL_PLUGINS"))
+          << qmakeVariables.value(QStringLiteral("QT_INSTALL_QML"))
+          << qmakeVariables.value(QStringLiteral("QT_INSTALL_TRANSLATIONS"));
+    QString hostData = qmakeVariables.value(QStringLiteral("QT_HOST_DATA"));
+    if (hostData.isEmpty())
+        hostData = qmakeVariables.value(QStringLiteral("QT_INSTALL_PREFIX"));
+    if (!hostData.isEmpty())
+        paths << hostData + QStringLiteral("/mkspecs/qconfig.pri");
+    QMap<QString, qint64> result;
+    foreach (const QString &path, paths) {
+        if (path.isEmpty())
+            continue;
+        const QFileInfo fi(path);
+        result.insert(path, fi.exists() ? fi.lastModified().toMSecsSinceEpoch() : qint64(-1));
+    }
+    return result;
+}
+
+// The default index is stored in the cache location, one file per Qt installation.
+QString QtInstallationIndex::defaultFileName(const QMap<QString, QString> &qmakeVariables)
+{
+    QString cacheLocation = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (cacheLocation.isEmpty())
+        return QString();
+    const QByteArray key = (qmakeVariables.value(QStringLiteral("QT_INSTALL_PREFIX"))
+                            + QLatin1Char('|') + qmakeVariables.value(QStringLiteral("QMAKE_XSPEC"))).toUtf8();
+    const QByteArray hash = QCryptographicHash::hash(key, QCryptographicHash::Sha1).toHex();
+    return cacheLocation + QStringLiteral("/qtindex-") + QString::fromLatin1(hash.left(16)) + QStringLiteral(".dat");
+}
+
+// Determine the modules required by a library and its debug flag.
+static QtInstallationIndex::Library indexLibrary(DeploymentCache *cache, const QString &qtLibraryLocation,
+                                                 const QDir &directory, const QString &fileName,
+                                                 Platform platform, bool withModules)
+{
+    QtInstallationIndex::Library library;
+    library.fileName = fileName;
+    const QString path = directory.absoluteFilePath(fileName);
+    QString errorMessage;
+    QStringList dependentQtLibs;
+    bool isDebug = false;
+    if (withModules) {
+        if (cache->findDependentQtLibraries(qtLibraryLocation, path, platform, &errorMessage,
+                                            &dependentQtLibs, 0, &isDebug)) {
+            foreach (const QString &qtLib, dependentQtLibs)
+                library.modules |= qtModule(qtLib);
+            library.dependenciesKnown = true;
+        }
+    } else {
+        cache->readExecutable(path, platform, &errorMessage, 0, 0, &isDebug);
+    }
+    library.isDebug = isDebug;
+    return library;
+}
+
+void QtInstallationIndex::scanQmlDirectory(const QString &relativePath, DeploymentCache *cache)
+{
+    const QString path = relativePath.isEmpty() ? m_qmlPath : m_qmlPath + QLatin1Char('/') + relativePath;
+    const QDir directory(path);
+    QmlDirectory entry;
+    entry.files = directory.entryList(QDir::Files);
+    foreach (const QString &library, cache->findSharedLibraries(directory, m_platform, MatchDebugOrRelease))
+        entry.libraries.append(indexLibrary(cache, QString(), directory, library, m_platform, false));
+    m_qmlDirectories.insert(relativePath, entry);
+    foreach (const QString &subDirectory, directory.entryList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks))
+        scanQmlDirectory(relativePath.isEmpty() ? subDirectory : relativePath + QLatin1Char('/') + subDirectory, cache);
+}
+
+bool QtInstallationIndex::create(const QString &fileName, const QMap<QString, QString> &qmakeVariables,
+                                 Platform platform, DeploymentCache *cache, QString *errorMessage)
+{
+    QtInstallationIndex index;
+    index.m_platform = platform;
+    index.m_pluginsPath = qmakeVariables.value(QStringLiteral("QT_INSTALL_PLUGINS"));
+    index.m_qmlPath = qmakeVariables.value(QStringLiteral("QT_INSTALL_QML"));
+    index.m_translationsPath = qmakeVariables.value(QStringLiteral("QT_INSTALL_TRANSLATIONS"));
+    index.m_timeStamps = installationTimeStamps(qmakeVariables, platform);
+    const QString qtLibraryLocation = libraryLocation(qmakeVariables, platform);
+
+    if (verboseLevel())
+        logStream() << "Indexing " << QDir::toNativeSeparators(index.m_pluginsPath) << "...\n";
+    if (!index.m_pluginsPath.isEmpty()) {
+        const QDir pluginsDir(index.m_pluginsPath);
+        foreach (const QString &category, cache->subDirectories(pluginsDir)) {
+            const QString categoryPath = index.m_pluginsPath + QLatin1Char('/') + category;
+            const QDir categoryDir(categoryPath);
+            LibraryList libraries;
+            foreach (const QString &plugin, cache->findSharedLibraries(categoryDir, platform, MatchDebugOrRelease))
+                libraries.append(indexLibrary(cache, qtLibraryLocation, categoryDir, plugin, platform, true));
+            index.m_pluginCategories.append(category);
+            index.m_plugins.insert(category, libraries);
+        }
+    }
+
+    if (verboseLevel())
+        logStream() << "Indexing " << QDir::toNativeSeparators(index.m_qmlPath) << "...\n";
+    if (!index.m_qmlPath.isEmpty() && QFileInfo(index.m_qmlPath).isDir())
+        index.scanQmlDirectory(QString(), cache);
+
+    if (!index.m_translationsPath.isEmpty()) {
+        index.m_translations = QDir(index.m_translationsPath).entryList(QStringList(QStringLiteral("*.qm")), QDir::Files);
+    }
+
+    if (!index.write(fileName, errorMessage))
+        return false;
+    if (verboseLevel())
+        logStream() << "Wrote " << QDir::toNativeSeparators(fileName) << ".\n";
+    return true;
+}
+
+bool QtInstallationIndex::write(const QString &fileName, QString *errorMessage) const
+{
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        *errorMessage = QString::fromLatin1("Cannot write %1: %2")
+                        .arg(QDir::toNativeSeparators(fileName), file.errorString());
+        return false;
+    }
+    QDataStream str(&file);
+    str.setVersion(QDataStream::Qt_5_0);
+    str << indexMagic << indexVersion << qint32(m_platform)
+        << m_pluginsPath << m_qmlPath << m_translationsPath << m_timeStamps
+        << m_pluginCategories << m_plugins << qint32(m_qmlDirectories.size());
+    for (QMap<QString, QmlDirectory>::const_iterator it = m_qmlDirectories.constBegin(); it != m_qmlDirectories.constEnd(); ++it)
+        str << it.key() << it.value().files << it.value().libraries;
+    str << m_translations;
+    if (str.status() != QDataStream::Ok || !file.commit()) {
+        *errorMessage = QString::fromLatin1("Cannot write %1: %2")
+                        .arg(QDir::toNativeSeparators(fileName), file.errorString());
+        return false;
+    }
+    return true;
+}
+
+// Load the index. Returns false with an error message when the index cannot be
+// read or no longer matches the Qt installation.
+bool QtInstallationIndex::load(const QString &fileName, const QMap<QString, QString> &qmakeVariables,
+                               Platform platform, QString *errorMessage)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *errorMessage = QString::fromLatin1("Cannot open %1: %2")
+                        .arg(QDir::toNativeSeparators(fileName), file.errorString());
+        return false;
+    }
+    const QByteArray data = file.readAll();
+    QDataStream str(data);
+    str.setVersion(QDataStream::Qt_5_0);
+    quint32 magic;
+    quint32 version;
+    qint32 indexPlatform;
+    str >> magic >> version >> indexPlatform;
+    if (str.status() != QDataStream::Ok || magic != indexMagic || version != indexVersion) {
+        *errorMessage = QString::fromLatin1("%1 is not a valid Qt installation index.")
+                        .arg(QDir::toNativeSeparators(fileName));
+        return false;
+    }
+    qint32 qmlDirectoryCount;
+    str >> m_pluginsPath >> m_qmlPath >> m_translationsPath >> m_timeStamps
+        >> m_pluginCategories >> m_plugins >> qmlDirectoryCount;
+    m_qmlDirectories.clear();
+    for (qint32 i = 0; i < qmlDirectoryCount && str.status() == QDataStream::Ok; ++i) {
+        QString relativePath;
+        QmlDirectory entry;
+        str >> relativePath >> entry.files >> entry.libraries;
+        m_qmlDirectories.insert(relativePath, entry);
+    }
+    str >> m_translations;
+    m_platform = Platform(indexPlatform);
+    if (str.status() != QDataStream::Ok) {
+        *errorMessage = QString::fromLatin1("%1 is truncated.").arg(QDir::toNativeSeparators(fileName));
+        return false;
+    }
+
+    if (m_platform != platform
+        || m_pluginsPath != qmakeVariables.value(QStringLiteral("QT_INSTALL_PLUGINS"))
+        || m_qmlPath != qmakeVariables.value(QStringLiteral("QT_INSTALL_QML"))
+        || m_translationsPath != qmakeVariables.value(QStringLiteral("QT_INSTALL_TRANSLATIONS"))) {
+        *errorMessage = QString::fromLatin1("%1 was created for a different Qt installation.")
+                        .arg(QDir::toNativeSeparators(fileName));
+        return false;
+    }
+    const QMap<QString, qint64> timeStamps = installationTimeStamps(qmakeVariables, platform);
+    if (timeStamps.keys() != m_timeStamps.keys()) {
+        *errorMessage = QString::fromLatin1("%1 was created for a different Qt installation.")
+                        .arg(QDir::toNativeSeparators(fileName));
+        return false;
+    }
+    for (QMap<QString, qint64>::const_iterator it = m_timeStamps.constBegin(); it != m_timeStamps.constEnd(); ++it) {
+        if (timeStamps.value(it.key()) != it.value()) {
+            *errorMessage = QString::fromLatin1("%1 is out of date (%2 was modified).")
+                            .arg(QDir::toNativeSeparators(fileName), QDir::toNativeSeparators(it.key()));
+            return false;
+        }
+    }
+    return true;
+}
+
+// Mirrors findSharedLibraries(): the debug flag is only checked on Windows.
+bool QtInstallationIndex::matches(const Library &library, Platform platform,
+                                  DebugMatchMode debugMatchMode, const QString &prefix)
+{
+    QString nameFilter = prefix;
+    if (nameFilter.isEmpty())
+        nameFilter += QLatin1Char('*');
+    if (debugMatchMode == MatchDebug && (platform & WindowsBased))
+        nameFilter += QLatin1Char('d');
+    nameFilter += sharedLibrarySuffix(platform);
+    if (!QDir::match(nameFilter, library.fileName))
+        return false;
+    if (debugMatchMode != MatchDebugOrRelease && (platform & WindowsBased))
+        return library.isDebug == (debugMatchMode == MatchDebug);
+    return true;
+}
+
+static void appendQmlLibraries(const QString &path, const QtInstallationIndex::LibraryList &libraries,
+                               Platform platform, DebugMatchMode debugMatchMode, QStringList *result)
+{
+    foreach (const QtInstallationIndex::Library &library, libraries) {
+        if (QtInstallationIndex::matches(library, platform, debugMatchMode))
+            result->append(path + QLatin1Char('/') + library.fileName);
+    }
+}
+
+// Return the plugin libraries of a QML import directory and its subdirectories
+// as does the recursive search of runQmlImportScanner(). Returns false if the
+// directory is not part of the index.
+bool QtInstallationIndex::qmlLibraries(const QString &directory, DebugMatchMode debugMatchMode,
+                                       QStringList *result) const
+{
+    if (m_qmlPath.isEmpty())
+        return false;
+    const QString cleanDirectory = QDir::cleanPath(directory);
+    QString relativePath;
+    if (cleanDirectory != m_qmlPath) {
+        if (!cleanDirectory.startsWith(m_qmlPath + QLatin1Char('/')))
+            return false;
+        relativePath = cleanDirectory.mid(m_qmlPath.size() + 1);
+    }
+    typedef QMap<QString, QmlDirectory>::const_iterator QmlDirectoryIterator;
+    const QmlDirectoryIterator end = m_qmlDirectories.constEnd();
+    const QmlDirectoryIterator directoryIt = m_qmlDirectories.constFind(relativePath);
+    if (directoryIt == end)
+        return false;
+    appendQmlLibraries(cleanDirectory, directoryIt.value().libraries, m_platform, debugMatchMode, result);
+    // The subdirectories are the range of keys starting with "<relativePath>/", which
+    // does not necessarily follow the directory: "QtQuick/Controls.2" sorts between
+    // "QtQuick/Controls" and "QtQuick/Controls/Styles".
+    const QString subDirectoryPrefix = relativePath.isEmpty() ? QString() : relativePath + QLatin1Char('/');
+    QmlDirectoryIterator it = relativePath.isEmpty() ? directoryIt + 1 : m_qmlDirectories.lowerBound(subDirectoryPrefix);
+    for ( ; it != end && it.key().startsWith(subDirectoryPrefix); ++it)
+        appendQmlLibraries(m_qmlPath + QLatin1Char('/') + it.key(), it.value().libraries, m_platform, debugMatchMode, result);
+    return true;
+}
+
+QStringList QtInstallationIndex::translations(const QStringList &nameFilters) const
+{
+    QStringList result;
+    foreach (const QString &translation, m_translations) {
+        foreach (const QString &nameFilter, nameFilters) {
+            if (QDir::match(nameFilter, translation)) {
+                result.append(translation);
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+QT_END_NAMESPACE
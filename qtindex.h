@@ -0,0 +1,100 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QTINDEX_H
+#define QTINDEX_H
+
+#include "types.h"
+
+QT_BEGIN_NAMESPACE
+
+class DeploymentCache;
+
+// Persistent index of a Qt installation created by "--index-qt": the plugins by
+// category with the Qt modules they require and their debug flag, the files and
+// plugin libraries of the QML import directories and the translations. It is
+// validated by a few time stamps of the installation root when loaded, so that
+// analysis does not need to touch the Qt tree; "--index-qt" refreshes it.
+class QtInstallationIndex
+{
+public:
+    struct Library {
+        Library() : modules(0), isDebug(false), dependenciesKnown(false) {}
+
+        QString fileName;
+        quint64 modules; // Qt modules required by the library (plugins only).
+        bool isDebug;
+        bool dependenciesKnown;
+    };
+    typedef QList<Library> LibraryList;
+
+    QtInstallationIndex() : m_platform(UnknownPlatform) {}
+
+    static QString defaultFileName(const QMap<QString, QString> &qmakeVariables);
+    static bool create(const QString &fileName, const QMap<QString, QString> &qmakeVariables,
+                       Platform platform, DeploymentCache *cache, QString *errorMessage);
+
+    bool load(const QString &fileName, const QMap<QString, QString> &qmakeVariables,
+              Platform platform, QString *errorMessage);
+
+    QStringList pluginCategories() const { return m_pluginCategories; }
+    LibraryList plugins(const QString &category) const { return m_plugins.value(category); }
+    bool qmlLibraries(const QString &directory, DebugMatchMode debugMatchMode, QStringList *result) const;
+    QStringList translations(const QStringList &nameFilters) const;
+
+    static bool matches(const Library &library, Platform platform,
+                        DebugMatchMode debugMatchMode, const QString &prefix = QString());
+
+private:
+    struct QmlDirectory {
+        QStringList files;
+        LibraryList libraries;
+    };
+
+    void scanQmlDirectory(const QString &relativePath, DeploymentCache *cache);
+    bool write(const QString &fileName, QString *errorMessage) const;
+
+    Platform m_platform;
+    QString m_pluginsPath;
+    QString m_qmlPath;
+    QString m_translationsPath;
+    QMap<QString, qint64> m_timeStamps; // Top-level directories, qconfig.pri.
+    QStringList m_pluginCategories;
+    QMap<QString, LibraryList> m_plugins;
+    QMap<QString, QmlDirectory> m_qmlDirectories; // Relative to m_qmlPath.
+    QStringList m_translations;
+};
+
+QT_END_NAMESPACE
+
+#endif // QTINDEX_H
@@ -0,0 +1,279 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "statistics.h"
+#include "tracing.h"
+#include "memstats.h"
+
+#include <QtCore/QJsonArray>
+#include <QtCore/QThreadStorage>
+
+#ifdef Q_OS_WIN
+#  include <qt_windows.h>
+#else
+#  include <sys/resource.h>
+#  include <sys/time.h>
+#endif
+
+QT_BEGIN_NAMESPACE
+
+static const char *phaseNames[PhaseCount] = {
+    "other", "qmake query", "dependency closure", "plugin discovery", "QML scan",
+    "library copy", "plugin copy", "QML copy", "Qt5Core patch", "translations"
+};
+
+// Also the keys of the JSON output.
+static const char *counterNames[CounterCount] = {
+    "binariesParsed", "filesStated", "bytesCopied", "upToDate", "processesSpawned"
+};
+
+DeploymentStatistics::DeploymentStatistics()
+{
+    for (int p = 0; p < PhaseCount; ++p) {
+        m_wallTimes[p].store(0);
+        m_cpuTimes[p].store(0);
+        for (int c = 0; c < CounterCount; ++c)
+            m_counters[p][c].store(0);
+    }
+}
+
+void DeploymentStatistics::addTime(DeploymentPhase phase, qint64 wallTimeNs, qint64 cpuTimeNs)
+{
+    m_wallTimes[phase].fetchAndAddRelaxed(wallTimeNs);
+    m_cpuTimes[phase].fetchAndAddRelaxed(cpuTimeNs);
+}
+
+const char *DeploymentStatistics::phaseName(DeploymentPhase phase)
+{
+    return phaseNames[phase];
+}
+
+const char *DeploymentStatistics::counterName(DeploymentCounter counter)
+{
+    return counterNames[counter];
+}
+
+// Report order: the phases in the order they run, then the remainder if any.
+static QVector<DeploymentPhase> reportedPhases(const DeploymentStatistics &statistics)
+{
+    QVector<DeploymentPhase> result;
+    for (int p = OtherPhase + 1; p < PhaseCount; ++p)
+        result.append(DeploymentPhase(p));
+    bool hasOther = statistics.wallTime(OtherPhase) != 0;
+    for (int c = 0; !hasOther && c < CounterCount; ++c)
+        hasOther = statistics.value(OtherPhase, DeploymentCounter(c)) != 0;
+    if (hasOther)
+        result.append(OtherPhase);
+    return result;
+}
+
+QString formatStatisticsTable(const QList<QStringList> &rows, int labelColumnCount)
+{
+    const int columnCount = rows.isEmpty() ? 0 : rows.first().size();
+    QVector<int> widths(columnCount, 0);
+    foreach (const QStringList &row, rows) {
+        for (int c = 0; c < columnCount; ++c)
+            widths[c] = qMax(widths.at(c), row.at(c).size());
+    }
+    QString result;
+    foreach (const QStringList &row, rows) {
+        for (int c = 0; c < columnCount; ++c) {
+            if (c)
+                result += QStringLiteral("  ");
+            result += c < labelColumnCount ? row.at(c).leftJustified(widths.at(c))
+                                           : row.at(c).rightJustified(widths.at(c));
+        }
+        result += QLatin1Char('\n');
+    }
+    return result;
+}
+
+static inline QString formatMs(qint64 ns)
+{
+    return QString::number(double(ns) / 1000000.0, 'f', 1);
+}
+
+QString DeploymentStatistics::format() const
+{
+    static const char *headers[] = {
+        "Phase", "Wall ms", "CPU ms", "Binaries", "Stat'ed", "Bytes", "Up to date", "Processes"
+    };
+    const int columnCount = int(sizeof(headers) / sizeof(headers[0]));
+
+    QList<QStringList> rows;
+    QStringList row;
+    for (int h = 0; h < columnCount; ++h)
+        row.append(QLatin1String(headers[h]));
+    rows.append(row);
+    qint64 totals[2 + CounterCount] = {0};
+    foreach (DeploymentPhase phase, reportedPhases(*this)) {
+        row.clear();
+        row.append(QLatin1String(phaseName(phase)));
+        row.append(formatMs(wallTime(phase)));
+        row.append(formatMs(cpuTime(phase)));
+        totals[0] += wallTime(phase);
+        totals[1] += cpuTime(phase);
+        for (int c = 0; c < CounterCount; ++c) {
+            const qint64 v = value(phase, DeploymentCounter(c));
+            row.append(QString::number(v));
+            totals[2 + c] += v;
+        }
+        rows.append(row);
+    }
+    row.clear();
+    row.append(QStringLiteral("total"));
+    row.append(formatMs(totals[0]));
+    row.append(formatMs(totals[1]));
+    for (int c = 0; c < CounterCount; ++c)
+        row.append(QString::number(totals[2 + c]));
+    rows.append(row);
+
+    return formatStatisticsTable(rows, 1);
+}
+
+QJsonObject DeploymentStatistics::toJson() const
+{
+    QJsonArray phases;
+    foreach (DeploymentPhase phase, reportedPhases(*this)) {
+        QJsonObject object;
+        object.insert(QStringLiteral("name"), QLatin1String(phaseName(phase)));
+        object.insert(QStringLiteral("wallTimeMs"), double(wallTime(phase)) / 1000000.0);
+        object.insert(QStringLiteral("cpuTimeMs"), double(cpuTime(phase)) / 1000000.0);
+        for (int c = 0; c < CounterCount; ++c)
+            object.insert(QLatin1String(counterNames[c]), double(value(phase, DeploymentCounter(c))));
+        phases.append(object);
+    }
+    QJsonObject result;
+    result.insert(QStringLiteral("phases"), phases);
+    return result;
+}
+
+qint64 processCpuTimeNs()
+{
+#ifdef Q_OS_WIN
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if (!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime))
+        return 0;
+    const quint64 kernel = (quint64(kernelTime.dwHighDateTime) << 32) | kernelTime.dwLowDateTime;
+    const quint64 user = (quint64(userTime.dwHighDateTime) << 32) | userTime.dwLowDateTime;
+    return qint64(kernel + user) * 100; // 100ns units.
+#else // Q_OS_WIN
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+    return (qint64(usage.ru_utime.tv_sec) + qint64(usage.ru_stime.tv_sec)) * 1000000000
+        + (qint64(usage.ru_utime.tv_usec) + qint64(usage.ru_stime.tv_usec)) * 1000;
+#endif // !Q_OS_WIN
+}
+
+// Innermost running timer of each thread.
+struct ThreadPhaseTimer
+{
+    ThreadPhaseTimer() : timer(0) {}
+
+    PhaseTimer *timer;
+};
+
+static QThreadStorage<ThreadPhaseTimer *> threadPhaseTimers;
+
+static ThreadPhaseTimer *threadPhaseTimer()
+{
+    if (!threadPhaseTimers.hasLocalData())
+        threadPhaseTimers.setLocalData(new ThreadPhaseTimer);
+    return threadPhaseTimers.localData();
+}
+
+LogContext PhaseTimer::phaseContext(DeploymentPhase phase)
+{
+    LogContext result = currentLogContext();
+    result.phase = phase;
+    return result;
+}
+
+PhaseTimer::PhaseTimer(DeploymentPhase phase)
+    : m_phase(phase), m_statistics(currentLogContext().statistics), m_trace(currentLogContext().trace)
+    , m_memoryStatistics(currentLogContext().memoryStatistics), m_outer(0), m_cpuStart(0), m_traceStart(0), m_logScope(new LogScope(phaseContext(phase)))
+{
+    if (!isActive())
+        return;
+    ThreadPhaseTimer *current = threadPhaseTimer();
+    m_outer = current->timer;
+    if (m_outer)
+        m_outer->stop();
+    current->timer = this;
+    start();
+}
+
+PhaseTimer::~PhaseTimer()
+{
+    if (!isActive())
+        return;
+    stop();
+    threadPhaseTimer()->timer = m_outer;
+    if (m_outer)
+        m_outer->start();
+}
+
+void PhaseTimer::setPhase(DeploymentPhase phase)
+{
+    if (isActive())
+        stop();
+    m_phase = phase;
+    m_logScope.reset(); // Restore the previous context before deriving the new one.
+    m_logScope.reset(new LogScope(phaseContext(phase)));
+    if (isActive())
+        start();
+}
+
+void PhaseTimer::start()
+{
+    if (m_statistics) {
+        m_wallTimer.start();
+        m_cpuStart = processCpuTimeNs();
+    }
+    if (m_trace)
+        m_traceStart = m_trace->elapsedNs();
+}
+
+// A phase paused by a nested one shows as several spans in the trace.
+void PhaseTimer::stop()
+{
+    if (m_statistics)
+        m_statistics->addTime(m_phase, m_wallTimer.nsecsElapsed(), processCpuTimeNs() - m_cpuStart);
+    if (m_trace)
+        m_trace->addSpan(phaseNames[m_phase], "phase", m_traceStart, m_trace->elapsedNs());
+    if (m_memoryStatistics)
+        m_memoryStatistics->updatePeakResidentSize(m_phase);
+}
+
+QT_END_NAMESPACE
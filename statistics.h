@@ -0,0 +1,153 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef STATISTICS_H
+#define STATISTICS_H
+
+#include "logging.h"
+
+#include <QtCore/QAtomicInteger>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QJsonObject>
+#include <QtCore/QScopedPointer>
+#include <QtCore/QStringList>
+
+QT_BEGIN_NAMESPACE
+
+enum DeploymentPhase {
+    OtherPhase,           // Outside of the phases below, for example the web processes.
+    QMakeQueryPhase,
+    DependencyPhase,      // Dependency closure of the binaries.
+    PluginDiscoveryPhase,
+    QmlScanPhase,
+    LibraryCopyPhase,
+    PluginCopyPhase,
+    QmlCopyPhase,
+    CorePatchPhase,       // Patching the paths of Qt5Core.
+    TranslationPhase,
+    PhaseCount
+};
+
+enum DeploymentCounter {
+    BinariesParsedCounter,
+    FilesStatedCounter,
+    BytesCopiedCounter,
+    UpToDateCounter,      // Files skipped as up to date.
+    ProcessesSpawnedCounter,
+    CounterCount
+};
+
+// Wall time, CPU time and counters per phase, reported by "--timings".
+// Thread-safe, batch deployments add up in one instance. The CPU time is
+// that of the process including its worker threads, so it overlaps for
+// phases running concurrently in batch mode.
+class DeploymentStatistics
+{
+public:
+    DeploymentStatistics();
+
+    void addTime(DeploymentPhase phase, qint64 wallTimeNs, qint64 cpuTimeNs);
+    void add(DeploymentPhase phase, DeploymentCounter counter, qint64 value)
+        { m_counters[phase][counter].fetchAndAddRelaxed(value); }
+
+    qint64 wallTime(DeploymentPhase phase) const { return m_wallTimes[phase].load(); }
+    qint64 cpuTime(DeploymentPhase phase) const { return m_cpuTimes[phase].load(); }
+    qint64 value(DeploymentPhase phase, DeploymentCounter counter) const
+        { return m_counters[phase][counter].load(); }
+
+    static const char *phaseName(DeploymentPhase phase);
+    static const char *counterName(DeploymentCounter counter);
+
+    QString format() const;
+    QJsonObject toJson() const;
+
+private:
+    Q_DISABLE_COPY(DeploymentStatistics)
+
+    QAtomicInteger<qint64> m_wallTimes[PhaseCount];
+    QAtomicInteger<qint64> m_cpuTimes[PhaseCount];
+    QAtomicInteger<qint64> m_counters[PhaseCount][CounterCount];
+};
+
+// Format rows of equal size, the first row being the header. The label columns
+// are left-aligned, the value columns right-aligned.
+QString formatStatisticsTable(const QList<QStringList> &rows, int labelColumnCount);
+
+// CPU time used by the process so far (user and kernel).
+qint64 processCpuTimeNs();
+
+// Adds to the counter of the current phase if the log context of the thread
+// has statistics (see LogContext), a no-op otherwise.
+inline void countEvent(DeploymentCounter counter, qint64 value = 1)
+{
+    const LogContext context = currentLogContext();
+    if (context.statistics)
+        context.statistics->add(DeploymentPhase(context.phase), counter, value);
+}
+
+// Sets the phase of the current thread for its lifetime and adds its wall and
+// CPU time to the statistics and its span to the trace. Nested timers pause the enclosing one so that
+// each phase gets its exclusive time. Tasks started meanwhile take the phase
+// with the log context.
+class PhaseTimer
+{
+public:
+    explicit PhaseTimer(DeploymentPhase phase);
+    ~PhaseTimer();
+
+    // Continue with the next phase of a sequence.
+    void setPhase(DeploymentPhase phase);
+
+private:
+    Q_DISABLE_COPY(PhaseTimer)
+
+    bool isActive() const { return m_statistics || m_trace || m_memoryStatistics; }
+    void start();
+    void stop();
+
+    static LogContext phaseContext(DeploymentPhase phase);
+
+    DeploymentPhase m_phase;
+    DeploymentStatistics *m_statistics;
+    TraceRecorder *m_trace; // Phases are also traced with "--trace".
+    MemoryStatistics *m_memoryStatistics; // Peak RSS at the end of the phases.
+    PhaseTimer *m_outer;
+    QElapsedTimer m_wallTimer;
+    qint64 m_cpuStart;
+    qint64 m_traceStart;
+    QScopedPointer<LogScope> m_logScope;
+};
+
+QT_END_NAMESPACE
+
+#endif // STATISTICS_H
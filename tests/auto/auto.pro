@@ -0,0 +1,3 @@
+TEMPLATE = subdirs
+SUBDIRS = commandlineparser deployment iostats logging memstats qmakequery qmcatalog qmlreachability statistics tracing
+unix: SUBDIRS += runprocess
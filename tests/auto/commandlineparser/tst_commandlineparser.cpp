@@ -0,0 +1,94 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "commandlineparser.h"
+
+#include <QtTest/QtTest>
+
+class tst_CommandLineParser : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void preParsedArgument_data();
+    void preParsedArgument();
+};
+
+void tst_CommandLineParser::preParsedArgument_data()
+{
+    QTest::addColumn<QStringList>("arguments");
+    QTest::addColumn<QString>("value");
+
+    const QString application = QStringLiteral("windeployqt");
+    QTest::newRow("double-dash")
+        << (QStringList() << application << QStringLiteral("--qt-prefix") << QStringLiteral("/qt"))
+        << QStringLiteral("/qt");
+    QTest::newRow("double-dash-equals")
+        << (QStringList() << application << QStringLiteral("--qt-prefix=/qt"))
+        << QStringLiteral("/qt");
+    QTest::newRow("single-dash")
+        << (QStringList() << application << QStringLiteral("-qt-prefix") << QStringLiteral("/qt"))
+        << QStringLiteral("/qt");
+    QTest::newRow("single-dash-equals")
+        << (QStringList() << application << QStringLiteral("-qt-prefix=/qt"))
+        << QStringLiteral("/qt");
+    QTest::newRow("after-options")
+        << (QStringList() << application << QStringLiteral("-verbose") << QStringLiteral("2")
+            << QStringLiteral("-qt-prefix") << QStringLiteral("/qt") << QStringLiteral("app.exe"))
+        << QStringLiteral("/qt");
+    QTest::newRow("missing-value")
+        << (QStringList() << application << QStringLiteral("-qt-prefix"))
+        << QString();
+    QTest::newRow("longer-name")
+        << (QStringList() << application << QStringLiteral("-qt-prefixes") << QStringLiteral("/qt"))
+        << QString();
+    QTest::newRow("positional")
+        << (QStringList() << application << QStringLiteral("qt-prefix") << QStringLiteral("/qt"))
+        << QString();
+    QTest::newRow("after-end-of-options")
+        << (QStringList() << application << QStringLiteral("--") << QStringLiteral("-qt-prefix")
+            << QStringLiteral("/qt"))
+        << QString();
+}
+
+void tst_CommandLineParser::preParsedArgument()
+{
+    QFETCH(QStringList, arguments);
+    QFETCH(QString, value);
+
+    QCOMPARE(::preParsedArgument(arguments, QStringLiteral("qt-prefix")), value);
+}
+
+QTEST_GUILESS_MAIN(tst_CommandLineParser)
+
+#include "tst_commandlineparser.moc"
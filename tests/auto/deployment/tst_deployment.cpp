@@ -0,0 +1,158 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "deployment.h"
+#include "deploymentstore.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QDirIterator>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QTemporaryDir>
+#include <QtTest/QtTest>
+
+#ifndef Q_OS_WIN
+#  include <unistd.h>
+#endif
+
+class tst_Deployment : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void replaceStoreTarget();
+#ifndef Q_OS_WIN
+    void linkSharedSymbolicLink();
+#endif
+
+private:
+    QString m_directory;
+    QTemporaryDir m_temporaryDirectory;
+};
+
+static bool writeFile(const QString &fileName, const QByteArray &content)
+{
+    if (!QDir().mkpath(QFileInfo(fileName).absolutePath()))
+        return false;
+    QFile file(fileName);
+    return file.open(QIODevice::WriteOnly) && file.write(content) == content.size();
+}
+
+void tst_Deployment::initTestCase()
+{
+    QVERIFY(m_temporaryDirectory.isValid());
+    m_directory = m_temporaryDirectory.path();
+}
+
+static QByteArray readFile(const QString &fileName)
+{
+    QFile file(fileName);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+// Targets placed by the store are read-only hard links to the store objects and
+// must nevertheless be replaceable, with and without the store.
+void tst_Deployment::replaceStoreTarget()
+{
+    const QString source = m_directory + QStringLiteral("/store-source/Qt5Core.dll");
+    const QString target = m_directory + QStringLiteral("/store-target");
+    QVERIFY(writeFile(source, QByteArrayLiteral("library")));
+    QVERIFY(QDir().mkpath(target));
+    const QString targetFile = target + QStringLiteral("/Qt5Core.dll");
+
+    QString errorMessage;
+    DeploymentStore store(m_directory + QStringLiteral("/store"));
+    QVERIFY2(store.open(&errorMessage), qPrintable(errorMessage));
+    QVERIFY2(updateFile(source, target, 0, 0, &store, &errorMessage), qPrintable(errorMessage));
+    QCOMPARE(readFile(targetFile), QByteArrayLiteral("library"));
+
+    QVERIFY2(updateFile(source, target, ForceUpdateFile, 0, &store, &errorMessage), qPrintable(errorMessage));
+    QCOMPARE(readFile(targetFile), QByteArrayLiteral("library"));
+    // The object stays read-only.
+    QDirIterator it(store.directory(), QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        if (it.filePath().contains(QLatin1String("/objects/")))
+            QVERIFY(!(it.fileInfo().permissions() & QFile::WriteOwner));
+    }
+
+    QVERIFY(writeFile(source, QByteArrayLiteral("modified library")));
+    QVERIFY2(updateFile(source, target, ForceUpdateFile, 0, 0, &errorMessage), qPrintable(errorMessage));
+    QCOMPARE(readFile(targetFile), QByteArrayLiteral("modified library"));
+    QVERIFY(QFileInfo(targetFile).isWritable());
+}
+
+#ifndef Q_OS_WIN
+// A versioned library "libQt5Core.so.5" -> "libQt5Core.so.5.6.0" of the shared
+// runtime directory must be usable from the application directory.
+void tst_Deployment::linkSharedSymbolicLink()
+{
+    const QString qtLibs = m_directory + QStringLiteral("/qt/lib");
+    const QString shared = m_directory + QStringLiteral("/shared");
+    const QString application = m_directory + QStringLiteral("/application");
+    QVERIFY(writeFile(qtLibs + QStringLiteral("/libQt5Core.so.5.6.0"), QByteArrayLiteral("library")));
+    QVERIFY(QFile::link(QStringLiteral("libQt5Core.so.5.6.0"), qtLibs + QStringLiteral("/libQt5Core.so.5")));
+    QVERIFY(QDir().mkpath(shared));
+    QVERIFY(QDir().mkpath(application));
+
+    QString errorMessage;
+    QVERIFY2(updateFile(qtLibs + QStringLiteral("/libQt5Core.so.5"), shared, 0, 0, 0, &errorMessage),
+             qPrintable(errorMessage));
+    QVERIFY(QFileInfo(shared + QStringLiteral("/libQt5Core.so.5")).isSymLink());
+
+    const QString sharedLink = shared + QStringLiteral("/libQt5Core.so.5");
+    const QString link = application + QStringLiteral("/libQt5Core.so.5");
+    const QString library = application + QStringLiteral("/libQt5Core.so.5.6.0");
+    QVERIFY2(linkSharedFile(sharedLink, application, 0, 0, &errorMessage), qPrintable(errorMessage));
+    QVERIFY(QFileInfo(link).isSymLink());
+    QVERIFY(QFileInfo::exists(link));
+    QCOMPARE(QFileInfo(link).canonicalFilePath(), QFileInfo(library).canonicalFilePath());
+    QVERIFY(!QFileInfo(library).isSymLink());
+
+    // Repair a hard link to the symbolic link pointing to a missing file.
+    QVERIFY(QFile::remove(link));
+    QVERIFY(QFile::remove(library));
+    QCOMPARE(::link(QFile::encodeName(sharedLink).constData(), QFile::encodeName(link).constData()), 0);
+    QVERIFY(!QFileInfo::exists(link));
+    QVERIFY2(linkSharedFile(sharedLink, application, 0, 0, &errorMessage), qPrintable(errorMessage));
+    QVERIFY(QFileInfo::exists(link));
+    QFile file(link);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QCOMPARE(file.readAll(), QByteArrayLiteral("library"));
+}
+#endif // !Q_OS_WIN
+
+QTEST_GUILESS_MAIN(tst_Deployment)
+
+#include "tst_deployment.moc"
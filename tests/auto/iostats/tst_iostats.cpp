@@ -0,0 +1,120 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "iostats.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QJsonObject>
+#include <QtTest/QtTest>
+
+class tst_IoStatistics : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void classifyLongestRoot();
+    void classifyInPlaceTarget();
+    void addAndJson();
+};
+
+static QString path(const char *relativePath)
+{
+    return QDir::currentPath() + QLatin1Char('/') + QLatin1String(relativePath);
+}
+
+// An application built inside the Qt installation belongs to the application.
+void tst_IoStatistics::classifyLongestRoot()
+{
+    IoStatistics statistics;
+    statistics.addRoot(QtInstallationRoot, path("qt"));
+    statistics.addRoot(ApplicationRoot, path("qt/examples/app"));
+    statistics.addRoot(TargetRoot, path("deploy"));
+
+    QCOMPARE(statistics.classify(path("qt/bin/Qt5Core.dll")), QtInstallationRoot);
+    QCOMPARE(statistics.classify(path("qt")), QtInstallationRoot);
+    QCOMPARE(statistics.classify(path("qt/examples/app/app.exe")), ApplicationRoot);
+    QCOMPARE(statistics.classify(path("qt/examples/application/app.exe")), QtInstallationRoot);
+    QCOMPARE(statistics.classify(path("qt/examples/app/../other/a.qml")), QtInstallationRoot);
+    QCOMPARE(statistics.classify(path("qtbase/bin/Qt5Core.dll")), OtherRoot);
+    QCOMPARE(statistics.classify(path("deploy/platforms/qwindows.dll")), TargetRoot);
+    QCOMPARE(statistics.classify(QStringLiteral("deploy/app.exe")), TargetRoot); // Relative.
+    QCOMPARE(statistics.classify(path("other/file")), OtherRoot);
+}
+
+// Deploying into the application directory classifies it as target.
+void tst_IoStatistics::classifyInPlaceTarget()
+{
+    IoStatistics statistics;
+    statistics.addRoot(QtInstallationRoot, path("qt"));
+    statistics.addRoot(ApplicationRoot, path("app"));
+    statistics.addRoot(TargetRoot, path("app/"));
+    QCOMPARE(statistics.classify(path("app/app.exe")), TargetRoot);
+    QCOMPARE(statistics.classify(path("qt/bin/Qt5Core.dll")), QtInstallationRoot);
+
+    statistics.addRoot(ApplicationRoot, path("app")); // Does not revert.
+    QCOMPARE(statistics.classify(path("app/app.exe")), TargetRoot);
+}
+
+void tst_IoStatistics::addAndJson()
+{
+    IoStatistics statistics;
+    statistics.addRoot(QtInstallationRoot, path("qt"));
+    statistics.addRoot(TargetRoot, path("deploy"));
+    statistics.add(LibraryCopyPhase, IoRead, path("qt/bin/Qt5Core.dll"), 100);
+    statistics.add(LibraryCopyPhase, IoRead, path("qt/bin/Qt5Gui.dll"), 50);
+    statistics.add(LibraryCopyPhase, IoWrite, path("deploy/Qt5Core.dll"), 100);
+    statistics.add(QmlScanPhase, IoStat, path("other/main.qml"), 0);
+
+    QCOMPARE(statistics.calls(LibraryCopyPhase, QtInstallationRoot, IoRead), qint64(2));
+    QCOMPARE(statistics.bytes(LibraryCopyPhase, QtInstallationRoot, IoRead), qint64(150));
+    QCOMPARE(statistics.calls(LibraryCopyPhase, TargetRoot, IoWrite), qint64(1));
+    QCOMPARE(statistics.calls(QmlScanPhase, OtherRoot, IoStat), qint64(1));
+
+    const QJsonArray json = statistics.toJson();
+    QCOMPARE(json.size(), 3); // Used phase and root combinations.
+    const QJsonObject scan = json.at(0).toObject();
+    QCOMPARE(scan.value(QStringLiteral("phase")).toString(), QStringLiteral("QML scan"));
+    QCOMPARE(scan.value(QStringLiteral("root")).toString(), QStringLiteral("other"));
+    QCOMPARE(scan.value(QStringLiteral("stat")).toDouble(), 1.0);
+    QVERIFY(!scan.contains(QStringLiteral("statBytes")));
+    const QJsonObject qt = json.at(1).toObject();
+    QCOMPARE(qt.value(QStringLiteral("phase")).toString(), QStringLiteral("library copy"));
+    QCOMPARE(qt.value(QStringLiteral("root")).toString(), QStringLiteral("qt"));
+    QCOMPARE(qt.value(QStringLiteral("read")).toDouble(), 2.0);
+    QCOMPARE(qt.value(QStringLiteral("readBytes")).toDouble(), 150.0);
+    QVERIFY(!qt.contains(QStringLiteral("write")));
+}
+
+QTEST_GUILESS_MAIN(tst_IoStatistics)
+
+#include "tst_iostats.moc"
@@ -0,0 +1,177 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "logging.h"
+
+#include <QtCore/QMutex>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QThread>
+#include <QtTest/QtTest>
+
+class tst_Logging : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void concurrentWriters();
+    void unterminatedLine();
+    void loggingSink();
+};
+
+class RecordingSink : public LogSink
+{
+public:
+    void message(const LogRecord &record) Q_DECL_OVERRIDE
+    {
+        QMutexLocker locker(&m_mutex);
+        m_records.append(record);
+    }
+
+    QList<LogRecord> records() const
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_records;
+    }
+
+private:
+    mutable QMutex m_mutex;
+    QList<LogRecord> m_records;
+};
+
+// Logs each record again to another sink, as a sink forwarding to a logger would.
+class ForwardingSink : public LogSink
+{
+public:
+    explicit ForwardingSink(LogSink *target) : m_target(target) {}
+
+    void message(const LogRecord &record) Q_DECL_OVERRIDE
+    {
+        const LogScope logScope(LogContext(1, m_target));
+        logStream() << "forwarded " << record.text.toStdWString() << '\n';
+        flushLog();
+    }
+
+private:
+    LogSink *m_target;
+};
+
+enum { writerCount = 8, linesPerWriter = 20000 };
+
+// Enough lines to wrap the bounded queue many times while the writer drains it.
+class WriterThread : public QThread
+{
+public:
+    WriterThread(int index, LogSink *sink) : m_index(index), m_sink(sink) {}
+
+protected:
+    void run() Q_DECL_OVERRIDE
+    {
+        const LogScope logScope(LogContext(1, m_sink));
+        for (int i = 0; i < linesPerWriter; ++i)
+            logStream() << m_index << ' ' << i << '\n';
+        errorStream() << "tail " << m_index;
+    }
+
+private:
+    const int m_index;
+    LogSink *m_sink;
+};
+
+// Each writer's records arrive complete and in order, including the unterminated
+// last line queued when the log scope ends.
+void tst_Logging::concurrentWriters()
+{
+    RecordingSink sink;
+    QList<WriterThread *> threads;
+    for (int t = 0; t < writerCount; ++t)
+        threads.append(new WriterThread(t, &sink));
+    foreach (WriterThread *thread, threads)
+        thread->start();
+    foreach (WriterThread *thread, threads)
+        QVERIFY(thread->wait(60000));
+    qDeleteAll(threads);
+    flushLog();
+
+    const QList<LogRecord> records = sink.records();
+    QCOMPARE(records.size(), writerCount * (linesPerWriter + 1));
+    QVector<int> nextLine(writerCount, 0);
+    foreach (const LogRecord &record, records) {
+        if (record.text.startsWith(QLatin1String("tail "))) {
+            QCOMPARE(record.level, LogWarning);
+            const int writer = record.text.mid(5).toInt();
+            QCOMPARE(nextLine.at(writer), int(linesPerWriter));
+            nextLine[writer] = -1;
+            continue;
+        }
+        QCOMPARE(record.level, LogInfo);
+        const QStringList fields = record.text.split(QLatin1Char(' '));
+        QCOMPARE(fields.size(), 2);
+        const int writer = fields.at(0).toInt();
+        QVERIFY(writer >= 0 && writer < writerCount);
+        QCOMPARE(fields.at(1).toInt(), nextLine.at(writer));
+        ++nextLine[writer];
+    }
+    QCOMPARE(nextLine, QVector<int>(writerCount, -1));
+}
+
+void tst_Logging::unterminatedLine()
+{
+    RecordingSink sink;
+    const LogScope logScope(LogContext(1, &sink));
+    logStream() << "no newline";
+    flushLog();
+    const QList<LogRecord> records = sink.records();
+    QCOMPARE(records.size(), 1);
+    QCOMPARE(records.first().text, QStringLiteral("no newline"));
+}
+
+// A sink logging from the writer thread must neither deadlock nor spin.
+void tst_Logging::loggingSink()
+{
+    RecordingSink recordingSink;
+    ForwardingSink forwardingSink(&recordingSink);
+    {
+        const LogScope logScope(LogContext(1, &forwardingSink));
+        for (int i = 0; i < 5; ++i)
+            logStream() << "line " << i << '\n';
+    }
+    flushLog();
+    const QList<LogRecord> records = recordingSink.records();
+    QCOMPARE(records.size(), 5);
+    for (int i = 0; i < records.size(); ++i)
+        QCOMPARE(records.at(i).text, QStringLiteral("forwarded line ") + QString::number(i));
+}
+
+QTEST_GUILESS_MAIN(tst_Logging)
+
+#include "tst_logging.moc"
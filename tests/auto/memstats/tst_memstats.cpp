@@ -0,0 +1,110 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "memstats.h"
+
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonObject>
+#include <QtTest/QtTest>
+
+class tst_MemoryStatistics : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void peakResidentSize();
+    void format();
+    void toJson();
+};
+
+static void record(MemoryStatistics *statistics)
+{
+    statistics->updatePeakResidentSize(DependencyPhase);
+    statistics->addAllocation(DependencyPhase, 64);
+    statistics->addAllocation(DependencyPhase, 32);
+    statistics->updatePeakResidentSize(QmlCopyPhase);
+}
+
+void tst_MemoryStatistics::peakResidentSize()
+{
+    QVERIFY(peakResidentSetSize() > 0);
+    MemoryStatistics statistics;
+    record(&statistics);
+    QVERIFY(statistics.peakResidentSize(DependencyPhase) > 0);
+    QVERIFY(statistics.peakResidentSize(QmlCopyPhase) >= statistics.peakResidentSize(DependencyPhase));
+    QCOMPARE(statistics.peakResidentSize(QmlScanPhase), qint64(0));
+    QCOMPARE(statistics.allocations(DependencyPhase), qint64(2));
+    QCOMPARE(statistics.allocatedBytes(DependencyPhase), qint64(96));
+}
+
+// A header and a row per recorded phase, followed by the process peak.
+void tst_MemoryStatistics::format()
+{
+    MemoryStatistics statistics;
+    record(&statistics);
+    const bool counting = MemoryStatistics::isAllocationCountingAvailable();
+    const QStringList lines = statistics.format().split(QLatin1Char('\n'), QString::SkipEmptyParts);
+    QCOMPARE(lines.size(), 4);
+    const QStringList header = lines.at(0).split(QLatin1Char(' '), QString::SkipEmptyParts);
+    QCOMPARE(header.size(), counting ? 6 : 3); // "Peak RSS", "Allocated bytes" contain blanks.
+    QCOMPARE(header.first(), QStringLiteral("Phase"));
+    QVERIFY(lines.at(1).startsWith(QLatin1String("dependency closure")));
+    QVERIFY(lines.at(2).startsWith(QLatin1String("QML copy")));
+    QVERIFY(lines.at(3).startsWith(QLatin1String("Peak RSS: ")));
+    QCOMPARE(lines.at(3).contains(QLatin1String("CONFIG+=memstats")), !counting);
+}
+
+void tst_MemoryStatistics::toJson()
+{
+    MemoryStatistics statistics;
+    record(&statistics);
+    const bool counting = MemoryStatistics::isAllocationCountingAvailable();
+    const QJsonObject json = statistics.toJson();
+    QVERIFY(json.value(QStringLiteral("peakRss")).toDouble() > 0);
+    QCOMPARE(json.value(QStringLiteral("allocationCounting")).toBool(), counting);
+    const QJsonArray phases = json.value(QStringLiteral("phases")).toArray();
+    QCOMPARE(phases.size(), 2);
+    const QJsonObject dependency = phases.at(0).toObject();
+    QCOMPARE(dependency.value(QStringLiteral("name")).toString(), QStringLiteral("dependency closure"));
+    QVERIFY(dependency.value(QStringLiteral("peakRss")).toDouble() > 0);
+    QCOMPARE(dependency.contains(QStringLiteral("allocations")), counting);
+    if (counting) {
+        QCOMPARE(dependency.value(QStringLiteral("allocations")).toDouble(), 2.0);
+        QCOMPARE(dependency.value(QStringLiteral("allocatedBytes")).toDouble(), 96.0);
+    }
+    QCOMPARE(phases.at(1).toObject().value(QStringLiteral("name")).toString(), QStringLiteral("QML copy"));
+}
+
+QTEST_GUILESS_MAIN(tst_MemoryStatistics)
+
+#include "tst_memstats.moc"
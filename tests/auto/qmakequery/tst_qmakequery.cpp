@@ -0,0 +1,167 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "utils.h"
+#include "qmakequery.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QTemporaryDir>
+#include <QtTest/QtTest>
+
+class tst_QMakeQuery : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void parseQMakeQuery();
+    void variablesFromPrefix();
+    void variablesFromPrefixQtConf();
+    void variablesFromPrefixCorePri();
+    void variablesFromPrefixInvalid();
+};
+
+static bool writeFile(const QString &fileName, const QByteArray &content)
+{
+    if (!QDir().mkpath(QFileInfo(fileName).absolutePath()))
+        return false;
+    QFile file(fileName);
+    return file.open(QIODevice::WriteOnly | QIODevice::Text) && file.write(content) == content.size();
+}
+
+// Minimal installation: qconfig.pri and a QtCore library determining the platform.
+static bool createPrefix(const QString &prefix, const QByteArray &qconfig)
+{
+    return writeFile(prefix + QStringLiteral("/mkspecs/qconfig.pri"), qconfig)
+        && writeFile(prefix + QStringLiteral("/lib/libQt5Core.so.5"), QByteArray());
+}
+
+void tst_QMakeQuery::parseQMakeQuery()
+{
+    const QByteArray output =
+        "QT_SYSROOT:\r\n"
+        "QT_INSTALL_PREFIX:C:/Qt/5.5/msvc2013_64\r\n"
+        "QT_INSTALL_BINS:C:/Qt/5.5/msvc2013_64/bin\r\n"
+        "QT_VERSION:5.5.1\r\n"
+        "QMAKE_XSPEC:win32-msvc2013\n";
+    const QMap<QString, QString> variables = ::parseQMakeQuery(output);
+    QCOMPARE(variables.size(), 5);
+    QVERIFY(variables.contains(QStringLiteral("QT_SYSROOT")));
+    QVERIFY(variables.value(QStringLiteral("QT_SYSROOT")).isEmpty());
+    QCOMPARE(variables.value(QStringLiteral("QT_INSTALL_PREFIX")), QStringLiteral("C:/Qt/5.5/msvc2013_64"));
+    QCOMPARE(variables.value(QStringLiteral("QT_INSTALL_BINS")), QStringLiteral("C:/Qt/5.5/msvc2013_64/bin"));
+    QCOMPARE(variables.value(QStringLiteral("QT_VERSION")), QStringLiteral("5.5.1"));
+    QCOMPARE(variables.value(QStringLiteral("QMAKE_XSPEC")), QStringLiteral("win32-msvc2013"));
+    QVERIFY(::parseQMakeQuery(QByteArray()).isEmpty());
+}
+
+void tst_QMakeQuery::variablesFromPrefix()
+{
+    QTemporaryDir temporaryDirectory;
+    QVERIFY(temporaryDirectory.isValid());
+    const QString prefix = QDir(temporaryDirectory.path()).canonicalPath();
+    QVERIFY(createPrefix(prefix, "QT_VERSION = 5.6.0\nQT_MAJOR_VERSION = 5\n"));
+
+    QString errorMessage;
+    const QMap<QString, QString> variables = qmakeVariablesFromPrefix(prefix, &errorMessage);
+    QVERIFY2(!variables.isEmpty(), qPrintable(errorMessage));
+    QCOMPARE(variables.value(QStringLiteral("QT_INSTALL_PREFIX")), prefix);
+    QCOMPARE(variables.value(QStringLiteral("QT_INSTALL_BINS")), prefix + QStringLiteral("/bin"));
+    QCOMPARE(variables.value(QStringLiteral("QT_INSTALL_LIBS")), prefix + QStringLiteral("/lib"));
+    QCOMPARE(variables.value(QStringLiteral("QT_INSTALL_PLUGINS")), prefix + QStringLiteral("/plugins"));
+    QCOMPARE(variables.value(QStringLiteral("QT_INSTALL_QML")), prefix + QStringLiteral("/qml"));
+    QCOMPARE(variables.value(QStringLiteral("QT_INSTALL_TRANSLATIONS")), prefix + QStringLiteral("/translations"));
+    QCOMPARE(variables.value(QStringLiteral("QT_INSTALL_DATA")), prefix);
+    QCOMPARE(variables.value(QStringLiteral("QT_HOST_BINS")), prefix + QStringLiteral("/bin"));
+    QCOMPARE(variables.value(QStringLiteral("QT_VERSION")), QStringLiteral("5.6.0"));
+    QCOMPARE(variables.value(QStringLiteral("QMAKE_XSPEC")), QStringLiteral("linux-g++"));
+    QCOMPARE(variables.value(QStringLiteral("QMAKE_SPEC")), QStringLiteral("linux-g++"));
+}
+
+void tst_QMakeQuery::variablesFromPrefixQtConf()
+{
+    QTemporaryDir temporaryDirectory;
+    QVERIFY(temporaryDirectory.isValid());
+    const QString prefix = QDir(temporaryDirectory.path()).canonicalPath();
+    const QString qmlDirectory = prefix + QStringLiteral("/shared/qml");
+    QVERIFY(createPrefix(prefix, "QT_VERSION = 5.6.0\n"));
+    QVERIFY(writeFile(prefix + QStringLiteral("/bin/qt.conf"),
+                      "[Paths]\nLibraries = lib64\nQml2Imports = " + qmlDirectory.toUtf8()
+                      + "\nTargetSpec = linux-arm-gnueabi-g++\nHostSpec = linux-g++\n"));
+
+    QString errorMessage;
+    const QMap<QString, QString> variables = qmakeVariablesFromPrefix(prefix, &errorMessage);
+    QVERIFY2(!variables.isEmpty(), qPrintable(errorMessage));
+    QCOMPARE(variables.value(QStringLiteral("QT_INSTALL_LIBS")), prefix + QStringLiteral("/lib64"));
+    QCOMPARE(variables.value(QStringLiteral("QT_INSTALL_QML")), qmlDirectory);
+    QCOMPARE(variables.value(QStringLiteral("QT_INSTALL_PLUGINS")), prefix + QStringLiteral("/plugins"));
+    QCOMPARE(variables.value(QStringLiteral("QMAKE_XSPEC")), QStringLiteral("linux-arm-gnueabi-g++"));
+    QCOMPARE(variables.value(QStringLiteral("QMAKE_SPEC")), QStringLiteral("linux-g++"));
+}
+
+// Installations without QT_VERSION in qconfig.pri.
+void tst_QMakeQuery::variablesFromPrefixCorePri()
+{
+    QTemporaryDir temporaryDirectory;
+    QVERIFY(temporaryDirectory.isValid());
+    const QString prefix = QDir(temporaryDirectory.path()).canonicalPath();
+    QVERIFY(createPrefix(prefix, "QT_EDITION = OpenSource\n"));
+    QVERIFY(writeFile(prefix + QStringLiteral("/mkspecs/modules/qt_lib_core.pri"),
+                      "QT.core.VERSION = 5.6.1\nQT.core.MAJOR_VERSION = 5\n"));
+
+    QString errorMessage;
+    const QMap<QString, QString> variables = qmakeVariablesFromPrefix(prefix, &errorMessage);
+    QVERIFY2(!variables.isEmpty(), qPrintable(errorMessage));
+    QCOMPARE(variables.value(QStringLiteral("QT_VERSION")), QStringLiteral("5.6.1"));
+}
+
+void tst_QMakeQuery::variablesFromPrefixInvalid()
+{
+    QTemporaryDir temporaryDirectory;
+    QVERIFY(temporaryDirectory.isValid());
+    const QString prefix = temporaryDirectory.path();
+    QString errorMessage;
+    QVERIFY(qmakeVariablesFromPrefix(prefix, &errorMessage).isEmpty());
+    QVERIFY(errorMessage.contains(QStringLiteral("qconfig.pri")));
+
+    // No QtCore library and no "TargetSpec" in qt.conf.
+    QVERIFY(writeFile(prefix + QStringLiteral("/mkspecs/qconfig.pri"), "QT_VERSION = 5.6.0\n"));
+    errorMessage.clear();
+    QVERIFY(qmakeVariablesFromPrefix(prefix, &errorMessage).isEmpty());
+    QVERIFY(errorMessage.contains(QStringLiteral("TargetSpec")));
+}
+
+QTEST_GUILESS_MAIN(tst_QMakeQuery)
+
+#include "tst_qmakequery.moc"
@@ -0,0 +1,174 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qmcatalog.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QTranslator>
+#include <QtCore/QVector>
+#include <QtCore/QtEndian>
+#include <QtTest/QtTest>
+
+#include <algorithm>
+
+// Writes catalogs in the format of lrelease without contexts section and merges
+// them, checking the result with QTranslator.
+class tst_QmCatalog : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void roundTrip();
+    void invalidInput();
+
+private:
+    QString m_directory;
+    QTemporaryDir m_temporaryDirectory;
+};
+
+struct Message {
+    Message(const char *c, const char *s, const QString &t) : context(c), sourceText(s), translation(t) {}
+
+    QByteArray context;
+    QByteArray sourceText;
+    QString translation;
+};
+
+// Hash of the source text and comment as computed by QTranslator.
+static quint32 elfHash(const QByteArray &text)
+{
+    quint32 h = 0;
+    foreach (char c, text) {
+        h = (h << 4) + uchar(c);
+        const quint32 g = h & 0xf0000000;
+        if (g)
+            h ^= g >> 24;
+        h &= ~g;
+    }
+    return h ? h : 1;
+}
+
+static void appendTagged(QByteArray *data, char tag, const QByteArray &value)
+{
+    uchar length[4];
+    qToBigEndian<quint32>(quint32(value.size()), length);
+    data->append(tag);
+    data->append(reinterpret_cast<const char *>(length), sizeof(length));
+    data->append(value);
+}
+
+static bool writeQmFile(const QString &fileName, const QList<Message> &messages)
+{
+    static const uchar magic[16] = {
+        0x3c, 0xb8, 0x64, 0x18, 0xca, 0xef, 0x9c, 0x95,
+        0xcd, 0x21, 0x1c, 0xbf, 0x60, 0xa1, 0xbd, 0xdd
+    };
+    QByteArray messageData;
+    QVector<QPair<quint32, quint32> > hashes;
+    foreach (const Message &message, messages) {
+        hashes.append(qMakePair(elfHash(message.sourceText), quint32(messageData.size())));
+        QByteArray translation(message.translation.size() * 2, Qt::Uninitialized);
+        for (int c = 0; c < message.translation.size(); ++c)
+            qToBigEndian<quint16>(message.translation.at(c).unicode(), reinterpret_cast<uchar *>(translation.data()) + 2 * c);
+        appendTagged(&messageData, 3, translation);
+        appendTagged(&messageData, 6, message.sourceText);
+        appendTagged(&messageData, 7, message.context);
+        messageData.append(char(1));
+    }
+    std::sort(hashes.begin(), hashes.end());
+    QByteArray hashData;
+    for (int i = 0; i < hashes.size(); ++i) {
+        uchar entry[8];
+        qToBigEndian<quint32>(hashes.at(i).first, entry);
+        qToBigEndian<quint32>(hashes.at(i).second, entry + 4);
+        hashData.append(reinterpret_cast<const char *>(entry), sizeof(entry));
+    }
+    QByteArray data(reinterpret_cast<const char *>(magic), sizeof(magic));
+    appendTagged(&data, char(0xa7), QByteArrayLiteral("de"));
+    appendTagged(&data, char(0x42), hashData);
+    appendTagged(&data, char(0x69), messageData);
+    QFile file(fileName);
+    return file.open(QIODevice::WriteOnly) && file.write(data) == data.size();
+}
+
+void tst_QmCatalog::initTestCase()
+{
+    QVERIFY(m_temporaryDirectory.isValid());
+    m_directory = m_temporaryDirectory.path();
+}
+
+void tst_QmCatalog::roundTrip()
+{
+    const QString first = m_directory + QStringLiteral("/qtbase_de.qm");
+    const QString second = m_directory + QStringLiteral("/qtdeclarative_de.qm");
+    const QString merged = m_directory + QStringLiteral("/qt_de.qm");
+    QVERIFY(writeQmFile(first, QList<Message>()
+                        << Message("QFileDialog", "Open", QStringLiteral("Öffnen"))
+                        << Message("QFileDialog", "Save", QStringLiteral("Speichern"))));
+    // "Open" also in a different context and again in the same one, which the first file shadows.
+    QVERIFY(writeQmFile(second, QList<Message>()
+                        << Message("QQuickAction", "Open", QStringLiteral("Aufmachen"))
+                        << Message("QFileDialog", "Open", QStringLiteral("Aufmachen"))
+                        << Message("QQuickAction", "Close", QStringLiteral("Schließen"))));
+
+    QString errorMessage;
+    QVERIFY2(mergeQmFiles(QStringList() << first << second, merged, &errorMessage), qPrintable(errorMessage));
+
+    QTranslator translator;
+    QVERIFY(translator.load(merged));
+    QCOMPARE(translator.translate("QFileDialog", "Open"), QStringLiteral("Öffnen"));
+    QCOMPARE(translator.translate("QFileDialog", "Save"), QStringLiteral("Speichern"));
+    QCOMPARE(translator.translate("QQuickAction", "Open"), QStringLiteral("Aufmachen"));
+    QCOMPARE(translator.translate("QQuickAction", "Close"), QStringLiteral("Schließen"));
+    QVERIFY(translator.translate("QQuickAction", "Save").isEmpty());
+}
+
+void tst_QmCatalog::invalidInput()
+{
+    const QString invalid = m_directory + QStringLiteral("/invalid.qm");
+    QFile file(invalid);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    QVERIFY(file.write("not a catalog") > 0);
+    file.close();
+    QString errorMessage;
+    QVERIFY(!mergeQmFiles(QStringList(invalid), m_directory + QStringLiteral("/out.qm"), &errorMessage));
+    QVERIFY(!errorMessage.isEmpty());
+    QVERIFY(!QFileInfo::exists(m_directory + QStringLiteral("/out.qm")));
+}
+
+QTEST_GUILESS_MAIN(tst_QmCatalog)
+
+#include "tst_qmcatalog.moc"
@@ -0,0 +1,9 @@
+TARGET = tst_qmlreachability
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+QT = core testlib
+
+include(../../../windeployqt.pri)
+
+SOURCES += tst_qmlreachability.cpp
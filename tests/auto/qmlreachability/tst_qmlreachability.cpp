@@ -0,0 +1,99 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qmlreachability.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QTemporaryDir>
+#include <QtTest/QtTest>
+
+class tst_QmlReachability : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void pluginOnlyModule();
+};
+
+static bool writeFile(const QString &fileName, const QByteArray &content)
+{
+    if (!QDir().mkpath(QFileInfo(fileName).absolutePath()))
+        return false;
+    QFile file(fileName);
+    return file.open(QIODevice::WriteOnly) && file.write(content) == content.size();
+}
+
+// A module registering its types from the plugin (like QtQuick.Controls) keeps
+// all files, a module declaring its types keeps the used ones.
+void tst_QmlReachability::pluginOnlyModule()
+{
+    QTemporaryDir temporaryDirectory;
+    QVERIFY(temporaryDirectory.isValid());
+    const QString root = QDir(temporaryDirectory.path()).canonicalPath();
+    const QString importPath = root + QStringLiteral("/qml");
+    const QString application = root + QStringLiteral("/application");
+    const QString pluginOnly = importPath + QStringLiteral("/Plugin/Only");
+    const QString typed = importPath + QStringLiteral("/Typed");
+
+    QVERIFY(writeFile(pluginOnly + QStringLiteral("/qmldir"),
+                      "module Plugin.Only\nplugin onlyplugin\nclassname OnlyPlugin\n"));
+    QVERIFY(writeFile(pluginOnly + QStringLiteral("/Button.qml"), "import QtQuick 2.0\nItem {}\n"));
+    QVERIFY(writeFile(pluginOnly + QStringLiteral("/Styles/Base/ButtonStyle.qml"), "import QtQuick 2.0\nItem {}\n"));
+    QVERIFY(writeFile(pluginOnly + QStringLiteral("/Styles/Base/images/button.png"), "png"));
+    QVERIFY(writeFile(pluginOnly + QStringLiteral("/utils.js"), ".pragma library\n"));
+    // Imported by a file of the plugin-only module.
+    QVERIFY(writeFile(pluginOnly + QStringLiteral("/Private/Helper.qml"), "import Typed 1.0\nTyped {}\n"));
+
+    QVERIFY(writeFile(typed + QStringLiteral("/qmldir"), "module Typed\nTyped 1.0 Typed.qml\n"));
+    QVERIFY(writeFile(typed + QStringLiteral("/Typed.qml"), "import QtQuick 2.0\nItem {}\n"));
+    QVERIFY(writeFile(typed + QStringLiteral("/Unused.qml"), "import QtQuick 2.0\nItem {}\n"));
+
+    QVERIFY(writeFile(application + QStringLiteral("/main.qml"),
+                      "import QtQuick 2.0\nimport Plugin.Only 1.0\nButton {}\n"));
+
+    const QSet<QString> reachable = findReachableQmlFiles(QStringList(application), importPath);
+    QVERIFY(reachable.contains(application + QStringLiteral("/main.qml")));
+    QVERIFY(reachable.contains(pluginOnly + QStringLiteral("/Button.qml")));
+    QVERIFY(reachable.contains(pluginOnly + QStringLiteral("/Styles/Base/ButtonStyle.qml")));
+    QVERIFY(reachable.contains(pluginOnly + QStringLiteral("/Styles/Base/images/button.png")));
+    QVERIFY(reachable.contains(pluginOnly + QStringLiteral("/utils.js")));
+    QVERIFY(reachable.contains(pluginOnly + QStringLiteral("/Private/Helper.qml")));
+    QVERIFY(reachable.contains(typed + QStringLiteral("/Typed.qml")));
+    QVERIFY(!reachable.contains(typed + QStringLiteral("/Unused.qml")));
+}
+
+QTEST_GUILESS_MAIN(tst_QmlReachability)
+
+#include "tst_qmlreachability.moc"
@@ -0,0 +1,118 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "utils.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QTemporaryDir>
+#include <QtTest/QtTest>
+
+class tst_RunProcess : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void interleavedOutput();
+    void exitCode();
+    void chdirFailure();
+    void missingBinary();
+};
+
+static inline QStringList shellArguments(const char *script)
+{
+    return QStringList() << QStringLiteral("-c") << QString::fromLatin1(script);
+}
+
+// Both outputs exceed the pipe buffers, the child blocks unless they are read alternately.
+void tst_RunProcess::interleavedOutput()
+{
+    static const char script[] =
+        "i=0; while [ $i -lt 20000 ]; do"
+        " echo \"stdout line $i 0123456789abcdefghijklmnopqrstuvwxyz\";"
+        " echo \"stderr line $i 0123456789abcdefghijklmnopqrstuvwxyz\" >&2;"
+        " i=$((i+1)); done";
+    unsigned long exitCode = 1;
+    QByteArray stdOut;
+    QByteArray stdErr;
+    QString errorMessage;
+    QVERIFY2(runProcess(QStringLiteral("sh"), shellArguments(script), QString(),
+                        &exitCode, &stdOut, &stdErr, &errorMessage),
+             qPrintable(errorMessage));
+    QCOMPARE(exitCode, 0ul);
+    const QList<QByteArray> stdOutLines = stdOut.trimmed().split('\n');
+    const QList<QByteArray> stdErrLines = stdErr.trimmed().split('\n');
+    QCOMPARE(stdOutLines.size(), 20000);
+    QCOMPARE(stdErrLines.size(), 20000);
+    QVERIFY(stdOutLines.first().startsWith("stdout line 0 "));
+    QVERIFY(stdOutLines.last().startsWith("stdout line 19999 "));
+    QVERIFY(stdErrLines.last().startsWith("stderr line 19999 "));
+}
+
+void tst_RunProcess::exitCode()
+{
+    unsigned long exitCode = 0;
+    QByteArray stdOut;
+    QString errorMessage;
+    QVERIFY2(runProcess(QStringLiteral("sh"), shellArguments("pwd; exit 3"), QDir::rootPath(),
+                        &exitCode, &stdOut, 0, &errorMessage),
+             qPrintable(errorMessage));
+    QCOMPARE(exitCode, 3ul);
+    QCOMPARE(stdOut.trimmed(), QByteArray("/"));
+}
+
+void tst_RunProcess::chdirFailure()
+{
+    QTemporaryDir temporaryDirectory;
+    QVERIFY(temporaryDirectory.isValid());
+    const QString missingDirectory = temporaryDirectory.path() + QStringLiteral("/missing");
+    unsigned long exitCode = 0;
+    QString errorMessage;
+    QVERIFY(!runProcess(QStringLiteral("sh"), shellArguments("exit 0"), missingDirectory,
+                        &exitCode, 0, 0, &errorMessage));
+    QVERIFY2(errorMessage.contains(missingDirectory), qPrintable(errorMessage));
+}
+
+void tst_RunProcess::missingBinary()
+{
+    unsigned long exitCode = 0;
+    QByteArray stdOut;
+    QByteArray stdErr;
+    QString errorMessage;
+    QVERIFY(!runProcess(QStringLiteral("windeployqt-test-missing-binary"), QStringList(), QString(),
+                        &exitCode, &stdOut, &stdErr, &errorMessage));
+    QVERIFY2(errorMessage.contains(QStringLiteral("windeployqt-test-missing-binary")), qPrintable(errorMessage));
+}
+
+QTEST_GUILESS_MAIN(tst_RunProcess)
+
+#include "tst_runprocess.moc"
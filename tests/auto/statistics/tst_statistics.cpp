@@ -0,0 +1,126 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "statistics.h"
+
+#include <QtCore/QRunnable>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
+#include <QtTest/QtTest>
+
+class tst_Statistics : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void nestedPhaseTimers();
+    void poolThreadPhases();
+    void formatTable();
+};
+
+// Counts in the phase of the creating thread, then in a phase of its own.
+class CountingTask : public QRunnable
+{
+public:
+    CountingTask() : m_logContext(currentLogContext()) {}
+
+    void run() Q_DECL_OVERRIDE
+    {
+        const LogScope logScope(m_logContext);
+        countEvent(BytesCopiedCounter, 42);
+        const PhaseTimer phaseTimer(PluginCopyPhase);
+        countEvent(BytesCopiedCounter, 7);
+    }
+
+private:
+    const LogContext m_logContext;
+};
+
+// A nested timer pauses the enclosing one, so each phase gets its exclusive time.
+void tst_Statistics::nestedPhaseTimers()
+{
+    DeploymentStatistics statistics;
+    const LogScope logScope(LogContext(1, 0, &statistics));
+    {
+        const PhaseTimer outer(DependencyPhase);
+        QCOMPARE(currentLogContext().phase, int(DependencyPhase));
+        QThread::msleep(20);
+        {
+            const PhaseTimer inner(QmlScanPhase);
+            QCOMPARE(currentLogContext().phase, int(QmlScanPhase));
+            QThread::msleep(200);
+        }
+        QCOMPARE(currentLogContext().phase, int(DependencyPhase));
+        QThread::msleep(20);
+    }
+    QCOMPARE(currentLogContext().phase, int(OtherPhase));
+
+    const qint64 msNs = 1000000;
+    QVERIFY(statistics.wallTime(QmlScanPhase) >= 200 * msNs);
+    QVERIFY(statistics.wallTime(DependencyPhase) >= 40 * msNs);
+    QVERIFY(statistics.wallTime(DependencyPhase) < statistics.wallTime(QmlScanPhase));
+    QCOMPARE(statistics.wallTime(OtherPhase), qint64(0));
+}
+
+// Tasks take the phase with the log context of the thread creating them.
+void tst_Statistics::poolThreadPhases()
+{
+    DeploymentStatistics statistics;
+    const LogScope logScope(LogContext(1, 0, &statistics));
+    {
+        const PhaseTimer phaseTimer(LibraryCopyPhase);
+        QThreadPool pool;
+        pool.start(new CountingTask);
+        pool.start(new CountingTask);
+        pool.waitForDone();
+    }
+    QCOMPARE(statistics.value(LibraryCopyPhase, BytesCopiedCounter), qint64(84));
+    QCOMPARE(statistics.value(PluginCopyPhase, BytesCopiedCounter), qint64(14));
+    QCOMPARE(statistics.value(OtherPhase, BytesCopiedCounter), qint64(0));
+}
+
+void tst_Statistics::formatTable()
+{
+    QList<QStringList> rows;
+    rows << (QStringList() << QStringLiteral("Phase") << QStringLiteral("ms"))
+         << (QStringList() << QStringLiteral("a") << QStringLiteral("1.0"))
+         << (QStringList() << QStringLiteral("long name") << QStringLiteral("12.5"));
+    QCOMPARE(formatStatisticsTable(rows, 1),
+             QStringLiteral("Phase        ms\n"
+                            "a           1.0\n"
+                            "long name  12.5\n"));
+}
+
+QTEST_GUILESS_MAIN(tst_Statistics)
+
+#include "tst_statistics.moc"
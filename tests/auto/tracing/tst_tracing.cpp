@@ -0,0 +1,138 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "tracing.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QThread>
+#include <QtTest/QtTest>
+
+class tst_Tracing : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void save();
+};
+
+class SpanThread : public QThread
+{
+public:
+    explicit SpanThread(const LogContext &context) : m_logContext(context) {}
+
+protected:
+    void run() Q_DECL_OVERRIDE
+    {
+        const LogScope logScope(m_logContext);
+        const TraceSpan span("worker", "test");
+    }
+
+private:
+    const LogContext m_logContext;
+};
+
+// The trace is a Chrome trace document with a thread name per thread and a
+// complete event per span.
+void tst_Tracing::save()
+{
+    QTemporaryDir temporaryDirectory;
+    QVERIFY(temporaryDirectory.isValid());
+    const QString fileName = temporaryDirectory.path() + QStringLiteral("/trace.json");
+
+    TraceRecorder recorder;
+    {
+        const LogScope logScope(LogContext(1, 0, 0, &recorder));
+        const TraceSpan span("copy", "file", "file", QStringLiteral("/qt/bin/Qt5Core.dll"));
+        SpanThread thread(currentLogContext());
+        thread.start();
+        QVERIFY(thread.wait());
+    }
+    {
+        const TraceSpan untraced("untraced", "test"); // No recorder in the context.
+    }
+    QString errorMessage;
+    QVERIFY2(recorder.save(fileName, &errorMessage), qPrintable(errorMessage));
+
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+    QCOMPARE(parseError.error, QJsonParseError::NoError);
+    QCOMPARE(document.object().value(QStringLiteral("displayTimeUnit")).toString(), QStringLiteral("ms"));
+    const QJsonArray events = document.object().value(QStringLiteral("traceEvents")).toArray();
+    QCOMPARE(events.size(), 4);
+
+    QMap<int, QString> threadNames;
+    QMap<QString, QJsonObject> spans;
+    foreach (const QJsonValue &value, events) {
+        const QJsonObject event = value.toObject();
+        const QString phase = event.value(QStringLiteral("ph")).toString();
+        const int tid = event.value(QStringLiteral("tid")).toInt(-1);
+        QVERIFY(event.value(QStringLiteral("pid")).isDouble());
+        if (phase == QLatin1String("M")) {
+            QCOMPARE(event.value(QStringLiteral("name")).toString(), QStringLiteral("thread_name"));
+            threadNames.insert(tid, event.value(QStringLiteral("args")).toObject()
+                                        .value(QStringLiteral("name")).toString());
+        } else {
+            QCOMPARE(phase, QStringLiteral("X"));
+            QVERIFY(event.value(QStringLiteral("ts")).toDouble() >= 0);
+            QVERIFY(event.value(QStringLiteral("dur")).toDouble() >= 0);
+            spans.insert(event.value(QStringLiteral("name")).toString(), event);
+        }
+    }
+    QCOMPARE(threadNames.size(), 2);
+    QCOMPARE(threadNames.value(0), QStringLiteral("main"));
+    QCOMPARE(threadNames.value(1), QStringLiteral("worker 1"));
+
+    QCOMPARE(spans.size(), 2);
+    const QJsonObject copy = spans.value(QStringLiteral("copy"));
+    QCOMPARE(copy.value(QStringLiteral("cat")).toString(), QStringLiteral("file"));
+    QCOMPARE(copy.value(QStringLiteral("tid")).toInt(-1), 0);
+    QCOMPARE(copy.value(QStringLiteral("args")).toObject().value(QStringLiteral("file")).toString(),
+             QDir::toNativeSeparators(QStringLiteral("/qt/bin/Qt5Core.dll")));
+    const QJsonObject worker = spans.value(QStringLiteral("worker"));
+    QCOMPARE(worker.value(QStringLiteral("cat")).toString(), QStringLiteral("test"));
+    QCOMPARE(worker.value(QStringLiteral("tid")).toInt(-1), 1);
+    QVERIFY(!worker.contains(QStringLiteral("args")));
+    // The worker span lies within the main thread's span.
+    QVERIFY(worker.value(QStringLiteral("ts")).toDouble() >= copy.value(QStringLiteral("ts")).toDouble());
+}
+
+QTEST_GUILESS_MAIN(tst_Tracing)
+
+#include "tst_tracing.moc"
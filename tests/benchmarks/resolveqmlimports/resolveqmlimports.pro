@@ -0,0 +1,9 @@
+TARGET = tst_bench_resolveqmlimports
+CONFIG += console
+CONFIG -= app_bundle
+
+QT = core testlib
+
+include(../../../windeployqt.pri)
+
+SOURCES += tst_bench_resolveqmlimports.cpp
@@ -0,0 +1,106 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qmlscanner.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QTemporaryDir>
+#include <QtTest/QtTest>
+
+// Resolves the imports of an application using thousands of synthetic modules,
+// each imported several times and depending on another module.
+class tst_Bench_ResolveQmlImports : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void resolveImports_data();
+    void resolveImports();
+
+private:
+    QTemporaryDir m_importPath;
+};
+
+static const int maxModuleCount = 8000;
+
+static inline QString moduleUri(int m)
+{
+    return QStringLiteral("Synthetic.Module") + QString::number(m);
+}
+
+void tst_Bench_ResolveQmlImports::initTestCase()
+{
+    QVERIFY(m_importPath.isValid());
+    for (int m = 0; m < maxModuleCount; ++m) {
+        const QString directory = m_importPath.path() + QStringLiteral("/Synthetic/Module") + QString::number(m);
+        QVERIFY(QDir().mkpath(directory));
+        QFile qmlDir(directory + QStringLiteral("/qmldir"));
+        QVERIFY(qmlDir.open(QIODevice::WriteOnly | QIODevice::Text));
+        QByteArray content = "module " + moduleUri(m).toLatin1() + "\nplugin module"
+            + QByteArray::number(m) + "plugin\nclassname Module" + QByteArray::number(m) + "Plugin\n";
+        if (m)
+            content += "depends " + moduleUri(m / 2).toLatin1() + " 1.0\n";
+        QCOMPARE(qmlDir.write(content), qint64(content.size()));
+    }
+}
+
+void tst_Bench_ResolveQmlImports::resolveImports_data()
+{
+    QTest::addColumn<int>("moduleCount");
+
+    QTest::newRow("1000") << 1000;
+    QTest::newRow("4000") << 4000;
+    QTest::newRow("8000") << maxModuleCount;
+}
+
+void tst_Bench_ResolveQmlImports::resolveImports()
+{
+    QFETCH(int, moduleCount);
+
+    QmlImportList imports;
+    for (int i = 0; i < 4; ++i) {
+        for (int m = 0; m < moduleCount; ++m)
+            imports.append(QmlImport(moduleUri(m), QStringLiteral("1.0")));
+    }
+    QList<QmlImportScanResult::Module> modules;
+    QBENCHMARK {
+        modules = resolveQmlImports(m_importPath.path(), imports);
+    }
+    QCOMPARE(modules.size(), moduleCount);
+}
+
+QTEST_GUILESS_MAIN(tst_Bench_ResolveQmlImports)
+
+#include "tst_bench_resolveqmlimports.moc"
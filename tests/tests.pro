@@ -0,0 +1,3 @@
+# Build with "qmake tests.pro", independently of the application.
+TEMPLATE = subdirs
+SUBDIRS = auto benchmarks
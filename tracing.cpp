@@ -0,0 +1,128 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "tracing.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDir>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QSaveFile>
+#include <QtCore/QThread>
+
+QT_BEGIN_NAMESPACE
+
+// The thread creating the recorder is "main" (id 0).
+TraceRecorder::TraceRecorder()
+{
+    m_threadIds.insert(QThread::currentThreadId(), 0);
+    m_clock.start();
+}
+
+void TraceRecorder::addSpan(const char *name, const char *category, qint64 startNs, qint64 endNs,
+                            const char *argumentName, const QString &argumentValue)
+{
+    Event event;
+    event.name = name;
+    event.category = category;
+    event.argumentName = argumentName;
+    event.argumentValue = argumentValue;
+    event.startNs = startNs;
+    event.durationNs = endNs - startNs;
+    const Qt::HANDLE thread = QThread::currentThreadId();
+    QMutexLocker locker(&m_mutex);
+    QHash<Qt::HANDLE, int>::const_iterator it = m_threadIds.constFind(thread);
+    if (it == m_threadIds.constEnd())
+        it = m_threadIds.insert(thread, m_threadIds.size());
+    event.threadId = it.value();
+    m_events.append(event);
+}
+
+static inline double toMicroseconds(qint64 ns)
+{
+    return double(ns) / 1000.0;
+}
+
+bool TraceRecorder::save(const QString &fileName, QString *errorMessage) const
+{
+    const double pid = double(QCoreApplication::applicationPid());
+    QJsonArray events;
+    {
+        QMutexLocker locker(&m_mutex);
+        for (int t = 0; t < m_threadIds.size(); ++t) {
+            QJsonObject args;
+            args.insert(QStringLiteral("name"), t ? QStringLiteral("worker ") + QString::number(t)
+                                                  : QStringLiteral("main"));
+            QJsonObject metadata;
+            metadata.insert(QStringLiteral("name"), QStringLiteral("thread_name"));
+            metadata.insert(QStringLiteral("ph"), QStringLiteral("M"));
+            metadata.insert(QStringLiteral("pid"), pid);
+            metadata.insert(QStringLiteral("tid"), t);
+            metadata.insert(QStringLiteral("args"), args);
+            events.append(metadata);
+        }
+        foreach (const Event &event, m_events) {
+            QJsonObject object;
+            object.insert(QStringLiteral("name"), QLatin1String(event.name));
+            object.insert(QStringLiteral("cat"), QLatin1String(event.category));
+            object.insert(QStringLiteral("ph"), QStringLiteral("X"));
+            object.insert(QStringLiteral("ts"), toMicroseconds(event.startNs));
+            object.insert(QStringLiteral("dur"), toMicroseconds(event.durationNs));
+            object.insert(QStringLiteral("pid"), pid);
+            object.insert(QStringLiteral("tid"), event.threadId);
+            if (event.argumentName) {
+                QJsonObject args;
+                args.insert(QLatin1String(event.argumentName), QDir::toNativeSeparators(event.argumentValue));
+                object.insert(QStringLiteral("args"), args);
+            }
+            events.append(object);
+        }
+    }
+    QJsonObject document;
+    document.insert(QStringLiteral("traceEvents"), events);
+    document.insert(QStringLiteral("displayTimeUnit"), QStringLiteral("ms"));
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)
+        || file.write(QJsonDocument(document).toJson(QJsonDocument::Compact)) < 0
+        || !file.commit()) {
+        *errorMessage = QString::fromLatin1("Cannot write the trace %1: %2")
+                        .arg(QDir::toNativeSeparators(fileName), file.errorString());
+        return false;
+    }
+    return true;
+}
+
+QT_END_NAMESPACE
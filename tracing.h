@@ -0,0 +1,117 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef TRACING_H
+#define TRACING_H
+
+#include "logging.h"
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+QT_BEGIN_NAMESPACE
+
+// Records spans of a run as Chrome trace events ("--trace"), to be opened in
+// chrome://tracing or Perfetto. Thread-safe, the events are appended under a
+// mutex at the end of each span and written by save().
+class TraceRecorder
+{
+public:
+    TraceRecorder();
+
+    void addSpan(const char *name, const char *category, qint64 startNs, qint64 endNs,
+                 const char *argumentName = 0, const QString &argumentValue = QString());
+    qint64 elapsedNs() const { return m_clock.nsecsElapsed(); }
+
+    bool save(const QString &fileName, QString *errorMessage) const;
+
+private:
+    Q_DISABLE_COPY(TraceRecorder)
+
+    struct Event {
+        const char *name; // Static strings.
+        const char *category;
+        const char *argumentName;
+        QString argumentValue;
+        qint64 startNs;
+        qint64 durationNs;
+        int threadId;
+    };
+
+    QElapsedTimer m_clock;
+    mutable QMutex m_mutex;
+    QVector<Event> m_events;
+    QHash<Qt::HANDLE, int> m_threadIds; // Small ids in the order of appearance.
+};
+
+// Records a span for its lifetime if the log context of the thread has a
+// recorder (see LogContext), does nothing otherwise.
+class TraceSpan
+{
+public:
+    TraceSpan(const char *name, const char *category,
+              const char *argumentName = 0, const QString &argumentValue = QString())
+        : m_recorder(currentLogContext().trace), m_name(name), m_category(category)
+        , m_argumentName(argumentName), m_startNs(0)
+    {
+        if (m_recorder) {
+            m_argumentValue = argumentValue;
+            m_startNs = m_recorder->elapsedNs();
+        }
+    }
+
+    ~TraceSpan()
+    {
+        if (m_recorder) {
+            m_recorder->addSpan(m_name, m_category, m_startNs, m_recorder->elapsedNs(),
+                                m_argumentName, m_argumentValue);
+        }
+    }
+
+private:
+    Q_DISABLE_COPY(TraceSpan)
+
+    TraceRecorder *m_recorder;
+    const char *m_name;
+    const char *m_category;
+    const char *m_argumentName;
+    QString m_argumentValue;
+    qint64 m_startNs;
+};
+
+QT_END_NAMESPACE
+
+#endif // TRACING_H
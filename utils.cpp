@@ -35,6 +35,9 @@
 #include "elfreader.h"
 #include "qtmodules.h"
 #include "jsonoutput.h"
+#include "statistics.h"
+#include "tracing.h"
+#include "iostats.h"
 
 #include <QtCore/QString>
 #include <QtCore/QDebug>
@@ -58,16 +61,18 @@
 #  include <string.h>
 #  include <errno.h>
 #  include <fcntl.h>
+#  include <poll.h>
 #endif  // !Q_OS_WIN
 
 QT_BEGIN_NAMESPACE
 
-int optVerboseLevel = 1;
-
 // Create a symbolic link by changing to the source directory to make sure the
 // link uses relative paths only (QFile::link() otherwise uses the absolute path).
+// On Unix, symlink() is used directly since changing the current directory is not
+// thread-safe.
 bool createSymbolicLink(const QFileInfo &source, const QString &target, QString *errorMessage)
 {
+#ifdef Q_OS_WIN
     const QString oldDirectory = QDir::currentPath();
     if (!QDir::setCurrent(source.absolutePath())) {
         *errorMessage = QStringLiteral("Unable to change to directory %1.").arg(QDir::toNativeSeparators(source.absolutePath()));
@@ -83,6 +88,38 @@ bool createSymbolicLink(const QFileInfo &source, const QString &target, QString
         return false;
     }
     return true;
+#else // Q_OS_WIN
+    const QString linkName = source.absolutePath() + QLatin1Char('/') + target;
+    if (symlink(QFile::encodeName(source.fileName()).constData(), QFile::encodeName(linkName).constData())) {
+        *errorMessage = QString::fromLatin1("Failed to create symbolic link %1 -> %2: %3")
+                        .arg(QDir::toNativeSeparators(source.absoluteFilePath()),
+                             QDir::toNativeSeparators(target), QString::fromLocal8Bit(strerror(errno)));
+        return false;
+    }
+    return true;
+#endif // !Q_OS_WIN
+}
+
+// Create a hard link, which fails for example when the files are on different volumes.
+bool createHardLink(const QString &source, const QString &target, QString *errorMessage)
+{
+#ifdef Q_OS_WIN
+    if (!CreateHardLinkW(reinterpret_cast<const wchar_t *>(QDir::toNativeSeparators(target).utf16()),
+                         reinterpret_cast<const wchar_t *>(QDir::toNativeSeparators(source).utf16()), NULL)) {
+        *errorMessage = QString::fromLatin1("Failed to create hard link %1 -> %2: %3")
+                        .arg(QDir::toNativeSeparators(target), QDir::toNativeSeparators(source),
+                             winErrorMessage(GetLastError()));
+        return false;
+    }
+#else // Q_OS_WIN
+    if (link(QFile::encodeName(source).constData(), QFile::encodeName(target).constData())) {
+        *errorMessage = QString::fromLatin1("Failed to create hard link %1 -> %2: %3")
+                        .arg(QDir::toNativeSeparators(target), QDir::toNativeSeparators(source),
+                             QString::fromLocal8Bit(strerror(errno)));
+        return false;
+    }
+#endif // !Q_OS_WIN
+    return true;
 }
 
 bool createDirectory(const QString &directory, QString *errorMessage)
@@ -95,8 +132,8 @@ bool createDirectory(const QString &directory, QString *errorMessage)
                         arg(QDir::toNativeSeparators(directory));
         return false;
     }
-    if (optVerboseLevel)
-        std::wcout << "Creating " << QDir::toNativeSeparators(directory) << "...\n";
+    if (verboseLevel())
+        logStream() << "Creating " << QDir::toNativeSeparators(directory) << "...\n";
     QDir dir;
     if (!dir.mkpath(directory)) {
         *errorMessage = QString::fromLatin1("Could not create directory %1.").
@@ -106,10 +143,44 @@ bool createDirectory(const QString &directory, QString *errorMessage)
     return true;
 }
 
+// Windows stores the read-only attribute with the file, so clearing it on a
+// hard link makes all links writable. DeploymentStore::place() restores it on
+// the objects. Elsewhere, the directory permissions apply.
+bool makeFileWritable(const QString &fileName, QString *errorMessage)
+{
+#ifdef Q_OS_WIN
+    QFile file(fileName);
+    const QFile::Permissions permissions = file.permissions();
+    if (!file.exists() || (permissions & QFile::WriteUser))
+        return true;
+    if (!file.setPermissions(permissions | QFile::WriteUser)) {
+        *errorMessage = QString::fromLatin1("Cannot set write permission on %1: %2")
+                        .arg(QDir::toNativeSeparators(fileName), file.errorString());
+        return false;
+    }
+#else // Q_OS_WIN
+    Q_UNUSED(fileName)
+    Q_UNUSED(errorMessage)
+#endif // !Q_OS_WIN
+    return true;
+}
+
+bool removeFile(const QString &fileName, QString *errorMessage)
+{
+    if (!makeFileWritable(fileName, errorMessage))
+        return false;
+    QFile file(fileName);
+    if (!file.remove()) {
+        *errorMessage = QString::fromLatin1("Cannot remove existing file %1: %2")
+                        .arg(QDir::toNativeSeparators(fileName), file.errorString());
+        return false;
+    }
+    return true;
+}
+
 // Find shared libraries matching debug/Platform in a directory, return relative names.
-QStringList findSharedLibraries(const QDir &directory, Platform platform,
-                                DebugMatchMode debugMatchMode,
-                                const QString &prefix)
+static inline QString sharedLibraryNameFilter(Platform platform, DebugMatchMode debugMatchMode,
+                                              const QString &prefix)
 {
     QString nameFilter = prefix;
     if (nameFilter.isEmpty())
@@ -117,9 +188,31 @@ QStringList findSharedLibraries(const QDir &directory, Platform platform,
     if (debugMatchMode == MatchDebug && (platform & WindowsBased))
         nameFilter += QLatin1Char('d');
     nameFilter += sharedLibrarySuffix(platform);
+    return nameFilter;
+}
+
+QStringList findSharedLibraries(const QDir &directory, Platform platform,
+                                DebugMatchMode debugMatchMode,
+                                const QString &prefix)
+{
+    const QString nameFilter = sharedLibraryNameFilter(platform, debugMatchMode, prefix);
+    ioEvent(IoListDirectory, directory.absolutePath());
+    return filterSharedLibraries(directory, directory.entryList(QStringList(nameFilter), QDir::Files),
+                                 platform, debugMatchMode, prefix);
+}
+
+// Filter file names of a directory that was already read for shared libraries
+// (see findSharedLibraries()).
+QStringList filterSharedLibraries(const QDir &directory, const QStringList &fileNames,
+                                  Platform platform, DebugMatchMode debugMatchMode,
+                                  const QString &prefix)
+{
+    const QString nameFilter = sharedLibraryNameFilter(platform, debugMatchMode, prefix);
     QStringList result;
     QString errorMessage;
-    foreach (const QString &dll, directory.entryList(QStringList(nameFilter), QDir::Files)) {
+    foreach (const QString &dll, fileNames) {
+        if (!QDir::match(nameFilter, dll))
+            continue;
         const QString dllPath = directory.absoluteFilePath(dll);
         bool matches = true;
         if (debugMatchMode != MatchDebugOrRelease && (platform & WindowsBased)) {
@@ -128,8 +221,8 @@ QStringList findSharedLibraries(const QDir &directory, Platform platform,
                                  (platform == WindowsMinGW))) {
                 matches = debugDll == (debugMatchMode == MatchDebug);
             } else {
-                std::wcerr << "Warning: Unable to read " << QDir::toNativeSeparators(dllPath)
-                           << ": " << errorMessage;
+                errorStream() << "Warning: Unable to read " << QDir::toNativeSeparators(dllPath)
+                           << ": " << errorMessage << '\n';
             }
         } // Windows
         if (matches)
@@ -228,6 +321,7 @@ bool runProcess(const QString &binary, const QStringList &args,
                 unsigned long *exitCode, QByteArray *stdOut, QByteArray *stdErr,
                 QString *errorMessage)
 {
+    const TraceSpan span("runProcess", "process", "binary", binary);
     if (exitCode)
         *exitCode = 0;
 
@@ -273,8 +367,8 @@ bool runProcess(const QString &binary, const QStringList &args,
     appendToCommandLine(binary, &commandLine);
     foreach (const QString &a, args)
         appendToCommandLine(a, &commandLine);
-    if (optVerboseLevel > 1)
-        std::wcout << "Running: " << commandLine << '\n';
+    if (verboseLevel() > 1)
+        logStream() << "Running: " << commandLine << '\n';
 
     QScopedArrayPointer<wchar_t> commandLineW(new wchar_t[commandLine.size() + 1]);
     commandLine.toWCharArray(commandLineW.data());
@@ -290,6 +384,7 @@ bool runProcess(const QString &binary, const QStringList &args,
         return false;
     }
 
+    countEvent(ProcessesSpawnedCounter);
     WaitForSingleObject(pi.hProcess, INFINITE);
     CloseHandle(pi.hThread);
     if (exitCode)
@@ -305,102 +400,173 @@ bool runProcess(const QString &binary, const QStringList &args,
 
 #else // Q_OS_WIN
 
-static inline char *encodeFileName(const QString &f)
+// runProcess helper: Create a pipe for stdout/stderr redirection. The
+// descriptors must not leak into processes started in parallel by other
+// threads, which would delay the end of file until those exit.
+static inline bool createRedirectPipe(int fds[2], QString *errorMessage)
 {
-    const QByteArray encoded = QFile::encodeName(f);
-    char *result = new char[encoded.size() + 1];
-    strcpy(result, encoded.constData());
-    return result;
+#ifdef Q_OS_LINUX
+    if (pipe2(fds, O_CLOEXEC)) {
+#else
+    if (pipe(fds) || fcntl(fds[0], F_SETFD, FD_CLOEXEC) || fcntl(fds[1], F_SETFD, FD_CLOEXEC)) {
+#endif
+        *errorMessage = QStringLiteral("pipe() failed: ") + QString::fromLocal8Bit(strerror(errno));
+        return false;
+    }
+    return true;
 }
 
-static inline char *tempFilePattern()
+static inline void closePipe(int fds[2])
 {
-    QString path = QDir::tempPath();
-    if (!path.endsWith(QLatin1Char('/')))
-        path += QLatin1Char('/');
-    path += QStringLiteral("tmpXXXXXX");
-    return encodeFileName(path);
+    if (fds[0] >= 0) {
+        close(fds[0]);
+        close(fds[1]);
+    }
 }
 
-static inline QByteArray readOutRedirectFile(int fd)
+enum ChildStage { ChildStarted, ChildChdirFailed, ChildExecFailed };
+
+// runProcess helper: Report a failure of the forked child through the pipe
+// closed by exec and exit. Only async-signal-safe functions may be used.
+static void reportChildError(int fd, ChildStage stage)
 {
-    enum { bufSize = 256 };
+    const int error[2] = {stage, errno};
+    const ssize_t written = write(fd, error, sizeof(error));
+    Q_UNUSED(written)
+    ::_exit(127);
+}
 
-    QByteArray result;
-    if (!lseek(fd, 0, 0)) {
-        char buf[bufSize];
-        while (true) {
-            const ssize_t rs = read(fd, buf, bufSize);
-            if (rs <= 0)
-                break;
-            result.append(buf, int(rs));
+// runProcess helper: Read the stdout/stderr pipes until both are closed.
+static void readRedirectPipes(int stdOutFd, QByteArray *stdOut, int stdErrFd, QByteArray *stdErr)
+{
+    enum { bufSize = 65536 };
+
+    QScopedArrayPointer<char> buf(new char[bufSize]);
+    struct pollfd fds[2];
+    QByteArray *outputs[2];
+    nfds_t count = 0;
+    if (stdOutFd >= 0) {
+        fds[count].fd = stdOutFd;
+        fds[count].events = POLLIN;
+        outputs[count++] = stdOut;
+    }
+    if (stdErrFd >= 0) {
+        fds[count].fd = stdErrFd;
+        fds[count].events = POLLIN;
+        outputs[count++] = stdErr;
+    }
+    while (count) {
+        if (poll(fds, count, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        for (nfds_t i = 0; i < count; ) {
+            bool closed = false;
+            if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+                const ssize_t rs = read(fds[i].fd, buf.data(), bufSize);
+                if (rs > 0)
+                    outputs[i]->append(buf.data(), int(rs));
+                else if (rs == 0 || errno != EINTR)
+                    closed = true;
+            }
+            if (closed) {
+                --count;
+                fds[i] = fds[count];
+                outputs[i] = outputs[count];
+            } else {
+                ++i;
+            }
         }
     }
-    close(fd);
-    return result;
 }
 
 // runProcess: Run a command line process (replacement for QProcess which
-// does not exist in the bootstrap library).
+// does not exist in the bootstrap library). The output is captured through
+// pipes. Everything the child needs is prepared before forking since only
+// async-signal-safe functions may be called there (other threads may hold
+// locks of the allocator). Failing to change the working directory or to
+// execute the binary is reported as failure to start.
 bool runProcess(const QString &binary, const QStringList &args,
                 const QString &workingDirectory,
                 unsigned long *exitCode, QByteArray *stdOut, QByteArray *stdErr,
                 QString *errorMessage)
 {
-    QScopedArrayPointer<char> stdOutFileName;
-    QScopedArrayPointer<char> stdErrFileName;
-
-    int stdOutFile = 0;
-    if (stdOut) {
-        stdOutFileName.reset(tempFilePattern());
-        stdOutFile = mkstemp(stdOutFileName.data());
-        if (stdOutFile < 0) {
-            *errorMessage = QStringLiteral("mkstemp() failed: ") + QString::fromLocal8Bit(strerror(errno));
-            return false;
-        }
+    const TraceSpan span("runProcess", "process", "binary", binary);
+    QList<QByteArray> encodedArguments;
+    encodedArguments.append(QFile::encodeName(binary));
+    foreach (const QString &a, args)
+        encodedArguments.append(QFile::encodeName(a));
+    QVector<char *> argv;
+    argv.reserve(encodedArguments.size() + 1);
+    for (int i = 0; i < encodedArguments.size(); ++i)
+        argv.append(encodedArguments[i].data());
+    argv.append(0);
+    const QByteArray encodedWorkingDirectory = QFile::encodeName(workingDirectory);
+
+    int stdOutPipe[2] = {-1, -1};
+    int stdErrPipe[2] = {-1, -1};
+    int childErrorPipe[2] = {-1, -1};
+    if (stdOut && !createRedirectPipe(stdOutPipe, errorMessage))
+        return false;
+    if (stdErr && !createRedirectPipe(stdErrPipe, errorMessage)) {
+        closePipe(stdOutPipe);
+        return false;
     }
-
-    int stdErrFile = 0;
-    if (stdErr) {
-        stdErrFileName.reset(tempFilePattern());
-        stdErrFile = mkstemp(stdErrFileName.data());
-        if (stdErrFile < 0) {
-            *errorMessage = QStringLiteral("mkstemp() failed: ") + QString::fromLocal8Bit(strerror(errno));
-            return false;
-        }
+    if (!createRedirectPipe(childErrorPipe, errorMessage)) {
+        closePipe(stdOutPipe);
+        closePipe(stdErrPipe);
+        return false;
     }
 
     const pid_t pID = fork();
 
-    if (pID < 0) {
-        *errorMessage = QStringLiteral("Fork failed: ") + QString::fromLocal8Bit(strerror(errno));
-        return false;
-    }
-
     if (!pID) { // Child
-        if (stdOut) {
-            dup2(stdOutFile, STDOUT_FILENO);
-            close(stdOutFile);
-        }
-        if (stdErr) {
-            dup2(stdErrFile, STDERR_FILENO);
-            close(stdErrFile);
-        }
+        if (stdOut)
+            dup2(stdOutPipe[1], STDOUT_FILENO);
+        if (stdErr)
+            dup2(stdErrPipe[1], STDERR_FILENO);
+        if (!encodedWorkingDirectory.isEmpty() && chdir(encodedWorkingDirectory.constData()))
+            reportChildError(childErrorPipe[1], ChildChdirFailed);
+        execvp(argv[0], argv.data());
+        reportChildError(childErrorPipe[1], ChildExecFailed);
+    }
 
-        if (!workingDirectory.isEmpty() && !QDir::setCurrent(workingDirectory)) {
-            std::wcerr << "Failed to change working directory to " << workingDirectory << ".\n";
-            ::_exit(-1);
+    const int forkErrno = errno;
+    if (stdOut)
+        close(stdOutPipe[1]);
+    if (stdErr)
+        close(stdErrPipe[1]);
+    close(childErrorPipe[1]);
+    int childError[2] = {ChildStarted, 0}; // Stage, errno.
+    if (pID > 0) {
+        // The pipe is closed by a successful exec, failures are reported before exiting.
+        ssize_t rs;
+        do {
+            rs = read(childErrorPipe[0], childError, sizeof(childError));
+        } while (rs < 0 && errno == EINTR);
+        if (rs != ssize_t(sizeof(childError))) {
+            childError[0] = ChildStarted;
+            countEvent(ProcessesSpawnedCounter);
         }
+        QByteArray stdOutData;
+        QByteArray stdErrData;
+        readRedirectPipes(stdOutPipe[0], &stdOutData, stdErrPipe[0], &stdErrData);
+        if (stdOut)
+            *stdOut = stdOutData;
+        if (stdErr)
+            *stdErr = stdErrData;
+    }
+    if (stdOut)
+        close(stdOutPipe[0]);
+    if (stdErr)
+        close(stdErrPipe[0]);
+    close(childErrorPipe[0]);
 
-        char **argv  = new char *[args.size() + 2]; // Create argv.
-        char **ap = argv;
-        *ap++ = encodeFileName(binary);
-        foreach (const QString &a, args)
-            *ap++ = encodeFileName(a);
-        *ap = 0;
-
-        execvp(argv[0], argv);
-        ::_exit(-1);
+    if (pID < 0) {
+        if (errorMessage)
+            *errorMessage = QStringLiteral("Fork failed: ") + QString::fromLocal8Bit(strerror(forkErrno));
+        return false;
     }
 
     int status;
@@ -410,19 +576,20 @@ bool runProcess(const QString &binary, const QStringList &args,
         waitResult = waitpid(pID, &status, 0);
     } while (waitResult == -1 && errno == EINTR);
 
-    if (stdOut) {
-        *stdOut = readOutRedirectFile(stdOutFile);
-        unlink(stdOutFileName.data());
-    }
-    if (stdErr) {
-        *stdErr = readOutRedirectFile(stdErrFile);
-        unlink(stdErrFileName.data());
-    }
-
     if (waitResult < 0) {
         *errorMessage = QStringLiteral("Wait failed: ") + QString::fromLocal8Bit(strerror(errno));
         return false;
     }
+    if (childError[0] != ChildStarted) {
+        if (errorMessage) {
+            const QString reason = QString::fromLocal8Bit(strerror(childError[1]));
+            *errorMessage = childError[0] == ChildChdirFailed
+                ? QString::fromLatin1("Cannot change to working directory %1: %2")
+                  .arg(QDir::toNativeSeparators(workingDirectory), reason)
+                : QString::fromLatin1("Cannot start %1: %2").arg(binary, reason);
+        }
+        return false;
+    }
     if (!WIFEXITED(status)) {
         *errorMessage = binary + QStringLiteral(" did not exit cleanly.");
         return false;
@@ -465,7 +632,13 @@ QMap<QString, QString> queryQMakeAll(QString *errorMessage)
             + QStringLiteral(": ") + QString::fromLocal8Bit(stdErr);
         return QMap<QString, QString>();
     }
-    const QString output = QString::fromLocal8Bit(stdOut).trimmed().remove(QLatin1Char('\r'));
+    return parseQMakeQuery(stdOut);
+}
+
+// Parse the "KEY:value" lines output by "qmake -query".
+QMap<QString, QString> parseQMakeQuery(const QByteArray &queryOutput)
+{
+    const QString output = QString::fromLocal8Bit(queryOutput).trimmed().remove(QLatin1Char('\r'));
     QMap<QString, QString> result;
     const int size = output.size();
     for (int pos = 0; pos < size; ) {
@@ -730,6 +903,11 @@ bool readPeExecutable(const QString &peExecutableFileName, QString *errorMessage
             *errorMessage = QString::fromLatin1("Cannot map '%1': %2").arg(peExecutableFileName, winErrorMessage(GetLastError()));
             break;
         }
+        if (isIoAccountingEnabled()) {
+            LARGE_INTEGER fileSize;
+            ioEvent(IoOpen, peExecutableFileName);
+            ioEvent(IoMap, peExecutableFileName, GetFileSizeEx(hFile, &fileSize) ? fileSize.QuadPart : 0);
+        }
 
         const IMAGE_NT_HEADERS *ntHeaders = getNtHeader(fileMemory, errorMessage);
         if (!ntHeaders)
@@ -747,21 +925,21 @@ bool readPeExecutable(const QString &peExecutableFileName, QString *errorMessage
         }
 
         result = true;
-        if (optVerboseLevel > 1) {
-            std::wcout << __FUNCTION__ << ": " << QDir::toNativeSeparators(peExecutableFileName)
+        if (verboseLevel() > 1) {
+            logStream() << __FUNCTION__ << ": " << QDir::toNativeSeparators(peExecutableFileName)
                 << ' ' << wordSize << " bit";
             if (isMinGW)
-                std::wcout << ", MinGW";
+                logStream() << ", MinGW";
             if (dependentLibrariesIn) {
-                std::wcout << ", dependent libraries: ";
-                if (optVerboseLevel > 2)
-                    std::wcout << dependentLibrariesIn->join(QLatin1Char(' '));
+                logStream() << ", dependent libraries: ";
+                if (verboseLevel() > 2)
+                    logStream() << dependentLibrariesIn->join(QLatin1Char(' '));
                 else
-                    std::wcout << dependentLibrariesIn->size();
+                    logStream() << dependentLibrariesIn->size();
             }
             if (isDebugIn)
-                std::wcout << (*isDebugIn ? ", debug" : ", release");
-            std::wcout << '\n';
+                logStream() << (*isDebugIn ? ", debug" : ", release");
+            logStream() << '\n';
         }
     } while (false);
 
@@ -874,6 +1052,8 @@ int qtVersion(const QMap<QString, QString> &qmakeVariables)
 
 bool readExecutable(const QString &executableFileName, Platform platform, QString *errorMessage, QStringList *dependentLibraries, unsigned *wordSize, bool *isDebug)
 {
+    const TraceSpan span("readExecutable", "binary", "file", executableFileName);
+    countEvent(BinariesParsedCounter);
     return platform == Unix ?
                 readElfExecutable(executableFileName, errorMessage, dependentLibraries, wordSize, isDebug) :
                 readPeExecutable(executableFileName, errorMessage, dependentLibraries, wordSize, isDebug,
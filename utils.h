@@ -36,6 +36,7 @@
 
 #include "types.h"
 #include "options.h"
+#include "logging.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -60,10 +61,13 @@ inline QString normalizeFileName(const QString &name) { return name; }
 static const char windowsSharedLibrarySuffix[] = ".dll";
 static const char unixSharedLibrarySuffix[] = ".so";
 
-extern int optVerboseLevel;
-
 bool createSymbolicLink(const QFileInfo &source, const QString &target, QString *errorMessage);
+bool createHardLink(const QString &source, const QString &target, QString *errorMessage);
 bool createDirectory(const QString &directory, QString *errorMessage);
+// Hard links into the deployment store are read-only, which prevents removing
+// or replacing them on Windows.
+bool makeFileWritable(const QString &fileName, QString *errorMessage);
+bool removeFile(const QString &fileName, QString *errorMessage);
 
 inline QString sharedLibrarySuffix(Platform platform)
 {
@@ -87,6 +91,7 @@ bool readExecutable(const QString &executableFileName, Platform platform,
                            unsigned *wordSize = 0, bool *isDebug = 0);
 
 QMap<QString, QString> queryQMakeAll(QString *errorMessage);
+QMap<QString, QString> parseQMakeQuery(const QByteArray &queryOutput);
 //QString queryQMake(const QString &variable, QString *errorMessage);
 int qtVersion(const QMap<QString, QString> &qmakeVariables);
 Platform platformFromMkSpec(const QString &xSpec);
@@ -96,6 +101,9 @@ QString findInPath(const QString &file);
 QStringList findSharedLibraries(const QDir &directory, Platform platform,
                                 DebugMatchMode debugMatchMode,
                                 const QString &prefix = QString());
+QStringList filterSharedLibraries(const QDir &directory, const QStringList &fileNames,
+                                  Platform platform, DebugMatchMode debugMatchMode,
+                                  const QString &prefix = QString());
 
 QString findD3dCompiler(Platform platform, const QString &qtBinDir, unsigned wordSize);
 
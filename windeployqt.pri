@@ -0,0 +1,22 @@
+INCLUDEPATH += $$PWD
+DEFINES += QT_NO_CAST_FROM_ASCII QT_NO_CAST_TO_ASCII
+
+SOURCES += $$PWD/utils.cpp $$PWD/qmlutils.cpp $$PWD/qmlscanner.cpp $$PWD/qmlscancache.cpp \
+           $$PWD/qmlreachability.cpp $$PWD/qmlcachegen.cpp $$PWD/qmcatalog.cpp \
+           $$PWD/elfreader.cpp $$PWD/options.cpp $$PWD/qtmodules.cpp $$PWD/directorywalker.cpp \
+           $$PWD/commandlineparser.cpp \
+           $$PWD/deployment.cpp $$PWD/deploymentcache.cpp $$PWD/deploymentstore.cpp \
+           $$PWD/batchdeployment.cpp $$PWD/qtindex.cpp $$PWD/processpool.cpp $$PWD/qmakequery.cpp \
+           $$PWD/jsonoutput.cpp $$PWD/deployer.cpp $$PWD/logging.cpp $$PWD/statistics.cpp \
+           $$PWD/tracing.cpp $$PWD/iostats.cpp $$PWD/memstats.cpp
+HEADERS += $$PWD/utils.h $$PWD/qmlutils.h $$PWD/qmlscanner.h $$PWD/qmlscancache.h \
+           $$PWD/qmlreachability.h $$PWD/qmlcachegen.h $$PWD/qmcatalog.h \
+           $$PWD/elfreader.h $$PWD/directorywalker.h \
+           $$PWD/types.h $$PWD/qtmodules.h $$PWD/options.h \
+           $$PWD/commandlineparser.h \
+           $$PWD/deployment.h $$PWD/deploymentcache.h $$PWD/deploymentstore.h \
+           $$PWD/batchdeployment.h $$PWD/qtindex.h $$PWD/processpool.h $$PWD/qmakequery.h \
+           $$PWD/jsonoutput.h $$PWD/deployer.h $$PWD/logging.h $$PWD/statistics.h \
+           $$PWD/tracing.h $$PWD/iostats.h $$PWD/memstats.h
+
+win32: LIBS += -lShlwapi -lpsapi
@@ -7,17 +7,12 @@ CONFIG -= app_bundle
 QT += core
 QT -= gui
 
-DEFINES += QT_NO_CAST_FROM_ASCII QT_NO_CAST_TO_ASCII
+include(windeployqt.pri)
 
-SOURCES += main.cpp utils.cpp qmlutils.cpp \
-           elfreader.cpp options.cpp qtmodules.cpp \
-           commandlineparser.cpp \
-           deployment.cpp \
-           jsonoutput.cpp
-HEADERS += utils.h qmlutils.h elfreader.h \
-           types.h qtmodules.h options.h \
-           commandlineparser.h \
-           deployment.h \
-           jsonoutput.h
-
-win32: LIBS += -lShlwapi
+SOURCES += main.cpp
+# Instrumented build counting allocations for "--memstats" with the allocator
+# hook. The define is not set for the library, which does not link the hook.
+memstats {
+    DEFINES += WINDEPLOYQT_MEMSTATS
+    SOURCES += memhook.cpp
+}